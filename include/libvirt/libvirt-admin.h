@@ -343,6 +343,17 @@ virAdmServerLookupClient(virAdmServerPtr srv,
 
 # define VIR_CLIENT_INFO_SELINUX_CONTEXT "selinux_context"
 
+/**
+ * VIR_CLIENT_INFO_JOB_QUEUE_DEPTH:
+ * Macro represents the number of the client's requests which are waiting
+ * for a worker thread of the server, as VIR_TYPED_PARAM_UINT.
+ *
+ * NOTE: This attribute is read-only and any attempt to set it will be denied
+ * by daemon
+ */
+
+# define VIR_CLIENT_INFO_JOB_QUEUE_DEPTH "job_queue_depth"
+
 int virAdmClientGetInfo(virAdmClientPtr client,
                         virTypedParameterPtr *params,
                         int *nparams,
@@ -421,6 +432,62 @@ int virAdmConnectSetLoggingFilters(virAdmConnectPtr conn,
                                    const char *filters,
                                    unsigned int flags);
 
+/* Daemon's RPC message buffer pool statistics */
+
+/**
+ * VIR_MESSAGE_BUFFER_POOL_HITS:
+ * Macro for the number of message buffers which were reused from the
+ * pool instead of being allocated, as VIR_TYPED_PARAM_ULLONG.
+ */
+
+# define VIR_MESSAGE_BUFFER_POOL_HITS "hits"
+
+/**
+ * VIR_MESSAGE_BUFFER_POOL_MISSES:
+ * Macro for the number of message buffers which had to be allocated
+ * because the pool had no suitable buffer, as VIR_TYPED_PARAM_ULLONG.
+ */
+
+# define VIR_MESSAGE_BUFFER_POOL_MISSES "misses"
+
+/**
+ * VIR_MESSAGE_BUFFER_POOL_RECYCLED:
+ * Macro for the number of message buffers which were returned to the
+ * pool once the message was processed, as VIR_TYPED_PARAM_ULLONG.
+ */
+
+# define VIR_MESSAGE_BUFFER_POOL_RECYCLED "recycled"
+
+/**
+ * VIR_MESSAGE_BUFFER_POOL_DISCARDED:
+ * Macro for the number of message buffers which were freed rather than
+ * returned to the pool, because they were too large or the pool was
+ * full, as VIR_TYPED_PARAM_ULLONG.
+ */
+
+# define VIR_MESSAGE_BUFFER_POOL_DISCARDED "discarded"
+
+/**
+ * VIR_MESSAGE_BUFFER_POOL_COUNT:
+ * Macro for the number of message buffers currently held by the pool,
+ * as VIR_TYPED_PARAM_ULLONG.
+ */
+
+# define VIR_MESSAGE_BUFFER_POOL_COUNT "count"
+
+/**
+ * VIR_MESSAGE_BUFFER_POOL_BYTES:
+ * Macro for the total size in bytes of message buffers currently held
+ * by the pool, as VIR_TYPED_PARAM_ULLONG.
+ */
+
+# define VIR_MESSAGE_BUFFER_POOL_BYTES "bytes"
+
+int virAdmConnectGetMessageBufferStats(virAdmConnectPtr conn,
+                                       virTypedParameterPtr *params,
+                                       int *nparams,
+                                       unsigned int flags);
+
 # ifdef __cplusplus
 }
 # endif
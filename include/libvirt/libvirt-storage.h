@@ -323,6 +323,10 @@ int                     virStoragePoolListVolumes       (virStoragePoolPtr pool,
 int                     virStoragePoolListAllVolumes    (virStoragePoolPtr pool,
                                                          virStorageVolPtr **vols,
                                                          unsigned int flags);
+int                     virStoragePoolListAllVolumesInfo(virStoragePoolPtr pool,
+                                                         virTypedParameterPtr *params,
+                                                         int *nparams,
+                                                         unsigned int flags);
 
 virConnectPtr           virStorageVolGetConnect         (virStorageVolPtr vol);
 
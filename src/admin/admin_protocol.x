@@ -46,6 +46,9 @@ const ADMIN_CLIENT_INFO_PARAMETERS_MAX = 64;
 /* Upper limit on number of client processing controls */
 const ADMIN_SERVER_CLIENT_LIMITS_MAX = 32;
 
+/* Upper limit on number of message buffer pool statistics */
+const ADMIN_MESSAGE_BUFFER_STATS_MAX = 32;
+
 /* A long string, which may NOT be NULL. */
 typedef string admin_nonnull_string<ADMIN_STRING_MAX>;
 
@@ -214,6 +217,14 @@ struct admin_connect_set_logging_filters_args {
     unsigned int flags;
 };
 
+struct admin_connect_get_message_buffer_stats_args {
+    unsigned int flags;
+};
+
+struct admin_connect_get_message_buffer_stats_ret {
+    admin_typed_param params<ADMIN_MESSAGE_BUFFER_STATS_MAX>;
+};
+
 /* Define the program number, protocol version and procedure numbers here. */
 const ADMIN_PROGRAM = 0x06900690;
 const ADMIN_PROTOCOL_VERSION = 1;
@@ -324,5 +335,10 @@ enum admin_procedure {
     /**
      * @generate: both
      */
-    ADMIN_PROC_SERVER_UPDATE_TLS_FILES = 18
+    ADMIN_PROC_SERVER_UPDATE_TLS_FILES = 18,
+
+    /**
+     * @generate: none
+     */
+    ADMIN_PROC_CONNECT_GET_MESSAGE_BUFFER_STATS = 19
 };
@@ -196,7 +196,8 @@ adminServerLookupClient(virNetServer *srv,
 }
 
 int
-adminClientGetInfo(virNetServerClient *client,
+adminClientGetInfo(virNetServer *srv,
+                   virNetServerClient *client,
                    virTypedParameterPtr *params,
                    int *nparams,
                    unsigned int flags)
@@ -283,6 +284,11 @@ adminClientGetInfo(virNetServerClient *client,
                                    "%s", VIR_CLIENT_INFO_SELINUX_CONTEXT) < 0)
         return -1;
 
+    if (virTypedParamListAddUInt(paramlist,
+                                 virNetServerGetClientJobQueueDepth(srv, client),
+                                 "%s", VIR_CLIENT_INFO_JOB_QUEUE_DEPTH) < 0)
+        return -1;
+
     *nparams = virTypedParamListStealParams(paramlist, params);
     return 0;
 }
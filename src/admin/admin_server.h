@@ -50,7 +50,8 @@ virNetServerClient *adminServerLookupClient(virNetServer *srv,
                                               unsigned long long id,
                                               unsigned int flags);
 
-int adminClientGetInfo(virNetServerClient *client,
+int adminClientGetInfo(virNetServer *srv,
+                       virNetServerClient *client,
                        virTypedParameterPtr *params,
                        int *nparams,
                        unsigned int flags);
@@ -319,7 +319,7 @@ adminDispatchClientGetInfo(virNetServer *server G_GNUC_UNUSED,
         goto cleanup;
     }
 
-    if (adminClientGetInfo(clnt, &params, &nparams, args->flags) < 0)
+    if (adminClientGetInfo(srv, clnt, &params, &nparams, args->flags) < 0)
         goto cleanup;
 
     if (virTypedParamsSerialize(params, nparams,
@@ -518,4 +518,65 @@ adminDispatchConnectGetLoggingFilters(virNetServer *server G_GNUC_UNUSED,
 
     return 0;
 }
+
+static int
+adminConnectGetMessageBufferStats(virTypedParameterPtr *params,
+                                  int *nparams,
+                                  unsigned int flags)
+{
+    g_autoptr(virTypedParamList) paramlist = g_new0(virTypedParamList, 1);
+    virNetMessageBufferStats stats;
+
+    virCheckFlags(0, -1);
+
+    virNetMessageGetBufferStats(&stats);
+
+    if (virTypedParamListAddULLong(paramlist, stats.hits,
+                                   "%s", VIR_MESSAGE_BUFFER_POOL_HITS) < 0 ||
+        virTypedParamListAddULLong(paramlist, stats.misses,
+                                   "%s", VIR_MESSAGE_BUFFER_POOL_MISSES) < 0 ||
+        virTypedParamListAddULLong(paramlist, stats.recycled,
+                                   "%s", VIR_MESSAGE_BUFFER_POOL_RECYCLED) < 0 ||
+        virTypedParamListAddULLong(paramlist, stats.discarded,
+                                   "%s", VIR_MESSAGE_BUFFER_POOL_DISCARDED) < 0 ||
+        virTypedParamListAddULLong(paramlist, stats.pooled,
+                                   "%s", VIR_MESSAGE_BUFFER_POOL_COUNT) < 0 ||
+        virTypedParamListAddULLong(paramlist, stats.pooledBytes,
+                                   "%s", VIR_MESSAGE_BUFFER_POOL_BYTES) < 0)
+        return -1;
+
+    *nparams = virTypedParamListStealParams(paramlist, params);
+
+    return 0;
+}
+
+static int
+adminDispatchConnectGetMessageBufferStats(virNetServer *server G_GNUC_UNUSED,
+                                          virNetServerClient *client G_GNUC_UNUSED,
+                                          virNetMessage *msg G_GNUC_UNUSED,
+                                          struct virNetMessageError *rerr,
+                                          admin_connect_get_message_buffer_stats_args *args,
+                                          admin_connect_get_message_buffer_stats_ret *ret)
+{
+    int rv = -1;
+    virTypedParameterPtr params = NULL;
+    int nparams = 0;
+
+    if (adminConnectGetMessageBufferStats(&params, &nparams, args->flags) < 0)
+        goto cleanup;
+
+    if (virTypedParamsSerialize(params, nparams,
+                                ADMIN_MESSAGE_BUFFER_STATS_MAX,
+                                (struct _virTypedParameterRemote **) &ret->params.params_val,
+                                &ret->params.params_len, 0) < 0)
+        goto cleanup;
+
+    rv = 0;
+ cleanup:
+    if (rv < 0)
+        virNetMessageSaveError(rerr);
+
+    virTypedParamsFree(params, nparams);
+    return rv;
+}
 #include "admin_server_dispatch_stubs.h"
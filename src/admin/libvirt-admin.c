@@ -1266,3 +1266,47 @@ virAdmConnectSetLoggingFilters(virAdmConnectPtr conn,
     virDispatchError(NULL);
     return -1;
 }
+
+/**
+ * virAdmConnectGetMessageBufferStats:
+ * @conn: pointer to an active admin connection
+ * @params: pointer to a list of typed parameters which will be allocated
+ *          to store the statistics (return value)
+ * @nparams: pointer to number of parameters returned in @params
+ * @flags: extra flags; not used yet, so callers should always pass 0
+ *
+ * Retrieves statistics of the daemon's pool of RPC message buffers. Buffers
+ * of messages which were processed are kept in the pool and reused for new
+ * messages rather than freed. The statistics include the number of buffers
+ * reused from the pool, allocated from the heap, returned to the pool and
+ * freed, and the number and total size of buffers currently held by the pool.
+ * See VIR_MESSAGE_BUFFER_POOL_* for the names of the returned parameters.
+ *
+ * Returns 0 on success, allocating @params to size returned in @nparams, or
+ * -1 in case of an error. Caller is responsible for deallocating @params.
+ */
+int
+virAdmConnectGetMessageBufferStats(virAdmConnectPtr conn,
+                                   virTypedParameterPtr *params,
+                                   int *nparams,
+                                   unsigned int flags)
+{
+    int ret = -1;
+
+    VIR_DEBUG("conn=%p, params=%p, nparams=%p, flags=0x%x",
+              conn, params, nparams, flags);
+
+    virResetLastError();
+    virCheckAdmConnectReturn(conn, -1);
+    virCheckNonNullArgGoto(params, error);
+    virCheckNonNullArgGoto(nparams, error);
+
+    if ((ret = remoteAdminConnectGetMessageBufferStats(conn, params, nparams,
+                                                       flags)) < 0)
+        goto error;
+
+    return ret;
+ error:
+    virDispatchError(NULL);
+    return -1;
+}
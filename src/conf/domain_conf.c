@@ -1404,8 +1404,10 @@ VIR_ENUM_IMPL(virDomainLaunchSecurity,
 );
 
 static virClass *virDomainObjClass;
+static virClass *virDomainObjSummaryClass;
 static virClass *virDomainXMLOptionClass;
 static void virDomainObjDispose(void *obj);
+static void virDomainObjSummaryDispose(void *obj);
 static void virDomainXMLOptionDispose(void *obj);
 
 
@@ -1426,6 +1428,9 @@ static int virDomainObjOnceInit(void)
     if (!VIR_CLASS_NEW(virDomainObj, virClassForObjectLockable()))
         return -1;
 
+    if (!VIR_CLASS_NEW(virDomainObjSummary, virClassForObject()))
+        return -1;
+
     if (!VIR_CLASS_NEW(virDomainXMLOption, virClassForObject()))
         return -1;
 
@@ -3724,6 +3729,20 @@ static void virDomainObjDispose(void *obj)
 
     virDomainSnapshotObjListFree(dom->snapshots);
     virDomainCheckpointObjListFree(dom->checkpoints);
+
+    virObjectUnref(dom->summary);
+    virMutexDestroy(&dom->summaryLock);
+}
+
+
+static void
+virDomainObjSummaryDispose(void *obj)
+{
+    virDomainObjSummary *summary = obj;
+
+    if (summary->def)
+        g_free(summary->def->name);
+    g_free(summary->def);
 }
 
 virDomainObj *
@@ -3743,6 +3762,12 @@ virDomainObjNew(virDomainXMLOption *xmlopt)
         goto error;
     }
 
+    if (virMutexInit(&domain->summaryLock) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("failed to initialize domain summary mutex"));
+        goto error;
+    }
+
     if (xmlopt->privateData.alloc) {
         domain->privateData = (xmlopt->privateData.alloc)(xmlopt->config.priv);
         if (!domain->privateData)
@@ -3829,10 +3854,10 @@ void virDomainObjAssignDef(virDomainObj *domain,
  *
  * Finish working with a domain object in an API.  This function
  * clears whatever was left of a domain that was gathered using
- * virDomainObjListFindByUUID(). Currently that means only unlocking and
- * decrementing the reference counter of that domain.  And in order to
- * make sure the caller does not access the domain, the pointer is
- * cleared.
+ * virDomainObjListFindByUUID(). Currently that means publishing the
+ * domain summary, unlocking and decrementing the reference counter of
+ * that domain.  And in order to make sure the caller does not access the
+ * domain, the pointer is cleared.
  */
 void
 virDomainObjEndAPI(virDomainObj **vm)
@@ -3840,12 +3865,92 @@ virDomainObjEndAPI(virDomainObj **vm)
     if (!*vm)
         return;
 
+    virDomainObjPublishSummary(*vm);
     virObjectUnlock(*vm);
     virObjectUnref(*vm);
     *vm = NULL;
 }
 
 
+static bool
+virDomainObjSummaryIsCurrent(virDomainObj *vm,
+                             virDomainObjSummary *summary)
+{
+    return summary &&
+        summary->def->id == vm->def->id &&
+        summary->state.state == vm->state.state &&
+        summary->state.reason == vm->state.reason &&
+        summary->autostart == vm->autostart &&
+        summary->persistent == vm->persistent &&
+        summary->removing == vm->removing &&
+        summary->hasManagedSave == vm->hasManagedSave &&
+        memcmp(summary->def->uuid, vm->def->uuid, VIR_UUID_BUFLEN) == 0 &&
+        STREQ_NULLABLE(summary->def->name, vm->def->name);
+}
+
+
+/**
+ * virDomainObjPublishSummary:
+ * @vm: locked domain object
+ *
+ * Make the current name, UUID, ID, state and flags of @vm visible to
+ * virDomainObjGetSummary() callers. This is done automatically on state
+ * changes and in virDomainObjEndAPI(), so it only needs to be called
+ * explicitly when @vm is modified without either of those following.
+ */
+void
+virDomainObjPublishSummary(virDomainObj *vm)
+{
+    virDomainObjSummary *summary;
+    virDomainObjSummary *old;
+
+    /* @vm->summary is only ever replaced with @vm locked, so it can be
+     * read without @summaryLock here */
+    if (!vm->def || virDomainObjSummaryIsCurrent(vm, vm->summary))
+        return;
+
+    if (!(summary = virObjectNew(virDomainObjSummaryClass)))
+        return;
+
+    summary->def = g_new0(virDomainDef, 1);
+    summary->def->name = g_strdup(vm->def->name);
+    memcpy(summary->def->uuid, vm->def->uuid, VIR_UUID_BUFLEN);
+    summary->def->id = vm->def->id;
+    summary->state = vm->state;
+    summary->autostart = vm->autostart;
+    summary->persistent = vm->persistent;
+    summary->removing = vm->removing;
+    summary->hasManagedSave = vm->hasManagedSave;
+
+    virMutexLock(&vm->summaryLock);
+    old = g_steal_pointer(&vm->summary);
+    vm->summary = summary;
+    virMutexUnlock(&vm->summaryLock);
+
+    virObjectUnref(old);
+}
+
+
+/**
+ * virDomainObjGetSummary:
+ * @vm: domain object, doesn't need to be locked
+ *
+ * Returns a reference to the most recently published summary of @vm or
+ * NULL if none was published yet. The caller must unref the result.
+ */
+virDomainObjSummary *
+virDomainObjGetSummary(virDomainObj *vm)
+{
+    virDomainObjSummary *summary;
+
+    virMutexLock(&vm->summaryLock);
+    summary = virObjectRef(vm->summary);
+    virMutexUnlock(&vm->summaryLock);
+
+    return summary;
+}
+
+
 void
 virDomainObjBroadcast(virDomainObj *vm)
 {
@@ -28927,6 +29032,8 @@ virDomainObjSetState(virDomainObj *dom, virDomainState state, int reason)
         dom->state.reason = reason;
     else
         dom->state.reason = 0;
+
+    virDomainObjPublishSummary(dom);
 }
 
 
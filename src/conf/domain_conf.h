@@ -2929,6 +2929,24 @@ struct _virDomainStateReason {
     int reason;
 };
 
+/* Immutable copy of the fields of a virDomainObj that are needed to
+ * list and filter domains. A new one is published whenever they might
+ * have changed, so that readers don't have to lock the domain object. */
+typedef struct _virDomainObjSummary virDomainObjSummary;
+struct _virDomainObjSummary {
+    virObject parent;
+
+    virDomainDef *def; /* only name, uuid and id are filled in */
+    virDomainStateReason state;
+
+    bool autostart;
+    bool persistent;
+    bool removing;
+    bool hasManagedSave;
+};
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virDomainObjSummary, virObjectUnref);
+
 struct _virDomainObj {
     virObjectLockable parent;
     virCond cond;
@@ -2959,6 +2977,9 @@ struct _virDomainObj {
 
     unsigned long long originalMemlock; /* Original RLIMIT_MEMLOCK, zero if no
                                          * restore will be required later */
+
+    virMutex summaryLock; /* protects only the @summary pointer */
+    virDomainObjSummary *summary;
 };
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virDomainObj, virObjectUnref);
@@ -3211,6 +3232,11 @@ virDomainObj *virDomainObjNew(virDomainXMLOption *caps)
 
 void virDomainObjEndAPI(virDomainObj **vm);
 
+void virDomainObjPublishSummary(virDomainObj *vm)
+    ATTRIBUTE_NONNULL(1);
+virDomainObjSummary *virDomainObjGetSummary(virDomainObj *vm)
+    ATTRIBUTE_NONNULL(1);
+
 bool virDomainObjTaint(virDomainObj *obj,
                        virDomainTaintFlags taint);
 void virDomainObjDeprecation(virDomainObj *obj,
@@ -52,6 +52,15 @@ struct _virDomainObjList {
     /* name -> virDomainObj mapping for O(1),
      * lockless lookup-by-name */
     GHashTable *objsName;
+
+    /* id -> virDomainObj mapping for O(1) lookup-by-id of running
+     * domains, and the reverse virDomainObj -> id mapping used to
+     * drop the stale entry once the domain's ID changes. Both are
+     * guarded by @idLock rather than the list lock so that they can
+     * be updated by callers which hold a domain object lock. */
+    virMutex idLock;
+    GHashTable *objsID;
+    GHashTable *objsIDRev;
 };
 
 
@@ -75,6 +84,17 @@ virDomainObjList *virDomainObjListNew(void)
     if (!(doms = virObjectRWLockableNew(virDomainObjListClass)))
         return NULL;
 
+    if (virMutexInit(&doms->idLock) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("cannot initialize mutex"));
+        virObjectUnref(doms);
+        return NULL;
+    }
+
+    doms->objsID = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                         NULL, virObjectFreeHashData);
+    doms->objsIDRev = g_hash_table_new(g_direct_hash, g_direct_equal);
+
     if (!(doms->objs = virHashNew(virObjectFreeHashData)) ||
         !(doms->objsName = virHashNew(virObjectFreeHashData))) {
         virObjectUnref(doms);
@@ -91,6 +111,72 @@ static void virDomainObjListDispose(void *obj)
 
     virHashFree(doms->objs);
     virHashFree(doms->objsName);
+    if (doms->objsIDRev)
+        g_hash_table_unref(doms->objsIDRev);
+    if (doms->objsID) {
+        g_hash_table_unref(doms->objsID);
+        virMutexDestroy(&doms->idLock);
+    }
+}
+
+
+/* The caller must hold @doms->idLock */
+static void
+virDomainObjListIDRemoveLocked(virDomainObjList *doms,
+                               virDomainObj *vm)
+{
+    gpointer id;
+
+    if (!g_hash_table_lookup_extended(doms->objsIDRev, vm, NULL, &id))
+        return;
+
+    g_hash_table_remove(doms->objsIDRev, vm);
+    g_hash_table_remove(doms->objsID, id);
+}
+
+
+/* The caller must hold @doms->idLock and a lock on @vm */
+static void
+virDomainObjListIDUpdateLocked(virDomainObjList *doms,
+                               virDomainObj *vm)
+{
+    gpointer id = GINT_TO_POINTER(vm->def->id);
+    virDomainObj *other;
+
+    virDomainObjListIDRemoveLocked(doms, vm);
+
+    if (!virDomainObjIsActive(vm))
+        return;
+
+    /* A domain whose driver did not tell us about its ID change may
+     * still occupy the slot; the new owner wins. */
+    if ((other = g_hash_table_lookup(doms->objsID, id)))
+        g_hash_table_remove(doms->objsIDRev, other);
+
+    g_hash_table_replace(doms->objsID, id, virObjectRef(vm));
+    g_hash_table_insert(doms->objsIDRev, vm, id);
+}
+
+
+/**
+ * virDomainObjListUpdateID:
+ * @doms: Domain object list
+ * @vm: locked domain object
+ *
+ * Refresh the lookup-by-id index entry of @vm after its def->id has
+ * been assigned (domain start) or reset to -1 (domain stop). Drivers
+ * which don't call this still get correct results from
+ * virDomainObjListFindByID, just without the O(1) fast path.
+ */
+void
+virDomainObjListUpdateID(virDomainObjList *doms,
+                         virDomainObj *vm)
+{
+    virMutexLock(&doms->idLock);
+    virDomainObjListIDUpdateLocked(doms, vm);
+    virMutexUnlock(&doms->idLock);
+
+    virDomainObjPublishSummary(vm);
 }
 
 
@@ -111,23 +197,53 @@ static int virDomainObjListSearchID(const void *payload,
 }
 
 
+/**
+ * @doms: Domain object list
+ * @id: ID of a running domain
+ *
+ * Lookup the @id in the doms->objsID hash table and return a locked
+ * and ref counted domain object if found. Should the index not know
+ * about @id (e.g. the driver doesn't report ID changes via
+ * virDomainObjListUpdateID) fall back to searching the whole list and
+ * record the result for subsequent lookups. Caller is expected to use
+ * the virDomainObjEndAPI when done with the object.
+ */
 virDomainObj *
 virDomainObjListFindByID(virDomainObjList *doms,
                          int id)
 {
     virDomainObj *obj;
 
+    virMutexLock(&doms->idLock);
+    obj = virObjectRef(g_hash_table_lookup(doms->objsID,
+                                           GINT_TO_POINTER(id)));
+    virMutexUnlock(&doms->idLock);
+
+    if (obj) {
+        virObjectLock(obj);
+        if (virDomainObjIsActive(obj) && obj->def->id == id)
+            goto found;
+
+        virObjectUnlock(obj);
+        virObjectUnref(obj);
+    }
+
     virObjectRWLockRead(doms);
     obj = virHashSearch(doms->objs, virDomainObjListSearchID, &id, NULL);
     virObjectRef(obj);
     virObjectRWUnlock(doms);
-    if (obj) {
-        virObjectLock(obj);
-        if (obj->removing) {
-            virObjectUnlock(obj);
-            virObjectUnref(obj);
-            obj = NULL;
-        }
+    if (!obj)
+        return NULL;
+
+    virObjectLock(obj);
+    if (obj->def->id == id)
+        virDomainObjListUpdateID(doms, obj);
+
+ found:
+    if (obj->removing) {
+        virObjectUnlock(obj);
+        virObjectUnref(obj);
+        obj = NULL;
     }
 
     return obj;
@@ -233,9 +349,10 @@ virDomainObjListFindByName(virDomainObjList *doms,
  * reference count since upon removal in virHashRemoveEntry
  * the virObjectUnref will be called since the hash tables were
  * configured to call virObjectFreeHashData when the object is
- * removed from the hash table.
+ * removed from the hash table. A running @vm is also added into
+ * the @doms->objsID table which holds one more reference.
  *
- * Returns 0 on success with 3 references and locked
+ * Returns 0 on success with 3 (4 if running) references and locked
  *        -1 on failure with 1 reference and locked
  */
 static int
@@ -255,6 +372,11 @@ virDomainObjListAddObjLocked(virDomainObjList *doms,
     }
     virObjectRef(vm);
 
+    if (virDomainObjIsActive(vm))
+        virDomainObjListUpdateID(doms, vm);
+
+    virDomainObjPublishSummary(vm);
+
     return 0;
 }
 
@@ -323,6 +445,11 @@ virDomainObjListAddLocked(virDomainObjList *doms,
                               def,
                               !!(flags & VIR_DOMAIN_OBJ_LIST_ADD_LIVE),
                               oldDef);
+
+        if (flags & VIR_DOMAIN_OBJ_LIST_ADD_LIVE)
+            virDomainObjListUpdateID(doms, vm);
+
+        virDomainObjPublishSummary(vm);
     } else {
         /* UUID does not match, but if a name matches, refuse it */
         if ((vm = virDomainObjListFindByNameLocked(doms, def->name))) {
@@ -381,6 +508,10 @@ virDomainObjListRemoveLocked(virDomainObjList *doms,
 
     virUUIDFormat(dom->def->uuid, uuidstr);
 
+    virMutexLock(&doms->idLock);
+    virDomainObjListIDRemoveLocked(doms, dom);
+    virMutexUnlock(&doms->idLock);
+
     virHashRemoveEntry(doms->objs, uuidstr);
     virHashRemoveEntry(doms->objsName, dom->def->name);
 }
@@ -404,6 +535,7 @@ virDomainObjListRemove(virDomainObjList *doms,
                        virDomainObj *dom)
 {
     dom->removing = true;
+    virDomainObjPublishSummary(dom);
     virObjectRef(dom);
     virObjectUnlock(dom);
     virObjectRWLockWrite(doms);
@@ -474,6 +606,8 @@ virDomainObjListRename(virDomainObjList *doms,
     if (rc < 0)
         goto cleanup;
 
+    virDomainObjPublishSummary(dom);
+
     ret = 0;
  cleanup:
     virObjectRWUnlock(doms);
@@ -482,37 +616,54 @@ virDomainObjListRename(virDomainObjList *doms,
 }
 
 
-static virDomainObj *
-virDomainObjListLoadConfig(virDomainObjList *doms,
-                           virDomainXMLOption *xmlopt,
-                           const char *configDir,
-                           const char *autostartDir,
-                           const char *name,
-                           virDomainLoadConfigNotify notify,
-                           void *opaque)
+static virDomainDef *
+virDomainObjListParseConfig(virDomainXMLOption *xmlopt,
+                            const char *configDir,
+                            const char *autostartDir,
+                            const char *name,
+                            int *autostart)
 {
-    char *configFile = NULL, *autostartLink = NULL;
+    g_autofree char *configFile = NULL;
+    g_autofree char *autostartLink = NULL;
     virDomainDef *def = NULL;
-    virDomainObj *dom;
-    int autostart;
-    virDomainDef *oldDef = NULL;
 
     if ((configFile = virDomainConfigFile(configDir, name)) == NULL)
-        goto error;
+        return NULL;
     if (!(def = virDomainDefParseFile(configFile, xmlopt, NULL,
                                       VIR_DOMAIN_DEF_PARSE_INACTIVE |
                                       VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE |
                                       VIR_DOMAIN_DEF_PARSE_ALLOW_POST_PARSE_FAIL)))
-        goto error;
+        return NULL;
 
     if ((autostartLink = virDomainConfigFile(autostartDir, name)) == NULL)
         goto error;
 
-    if ((autostart = virFileLinkPointsTo(autostartLink, configFile)) < 0)
+    if ((*autostart = virFileLinkPointsTo(autostartLink, configFile)) < 0)
         goto error;
 
-    if (!(dom = virDomainObjListAddLocked(doms, def, xmlopt, 0, &oldDef)))
-        goto error;
+    return def;
+
+ error:
+    virDomainDefFree(def);
+    return NULL;
+}
+
+
+static virDomainObj *
+virDomainObjListLoadConfig(virDomainObjList *doms,
+                           virDomainXMLOption *xmlopt,
+                           virDomainDef *def,
+                           int autostart,
+                           virDomainLoadConfigNotify notify,
+                           void *opaque)
+{
+    virDomainObj *dom;
+    virDomainDef *oldDef = NULL;
+
+    if (!(dom = virDomainObjListAddLocked(doms, def, xmlopt, 0, &oldDef))) {
+        virDomainDefFree(def);
+        return NULL;
+    }
 
     dom->autostart = autostart;
 
@@ -520,41 +671,37 @@ virDomainObjListLoadConfig(virDomainObjList *doms,
         (*notify)(dom, oldDef == NULL, opaque);
 
     virDomainDefFree(oldDef);
-    VIR_FREE(configFile);
-    VIR_FREE(autostartLink);
     return dom;
+}
 
- error:
-    VIR_FREE(configFile);
-    VIR_FREE(autostartLink);
-    virDomainDefFree(def);
-    return NULL;
+
+static virDomainObj *
+virDomainObjListParseStatus(virDomainXMLOption *xmlopt,
+                            const char *statusDir,
+                            const char *name)
+{
+    g_autofree char *statusFile = NULL;
+
+    if ((statusFile = virDomainConfigFile(statusDir, name)) == NULL)
+        return NULL;
+
+    return virDomainObjParseFile(statusFile, xmlopt,
+                                 VIR_DOMAIN_DEF_PARSE_STATUS |
+                                 VIR_DOMAIN_DEF_PARSE_ACTUAL_NET |
+                                 VIR_DOMAIN_DEF_PARSE_PCI_ORIG_STATES |
+                                 VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE |
+                                 VIR_DOMAIN_DEF_PARSE_ALLOW_POST_PARSE_FAIL);
 }
 
 
 static virDomainObj *
 virDomainObjListLoadStatus(virDomainObjList *doms,
-                           const char *statusDir,
-                           const char *name,
-                           virDomainXMLOption *xmlopt,
+                           virDomainObj *obj,
                            virDomainLoadConfigNotify notify,
                            void *opaque)
 {
-    char *statusFile = NULL;
-    virDomainObj *obj = NULL;
     char uuidstr[VIR_UUID_STRING_BUFLEN];
 
-    if ((statusFile = virDomainConfigFile(statusDir, name)) == NULL)
-        goto error;
-
-    if (!(obj = virDomainObjParseFile(statusFile, xmlopt,
-                                      VIR_DOMAIN_DEF_PARSE_STATUS |
-                                      VIR_DOMAIN_DEF_PARSE_ACTUAL_NET |
-                                      VIR_DOMAIN_DEF_PARSE_PCI_ORIG_STATES |
-                                      VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE |
-                                      VIR_DOMAIN_DEF_PARSE_ALLOW_POST_PARSE_FAIL)))
-        goto error;
-
     virUUIDFormat(obj->def->uuid, uuidstr);
 
     if (virHashLookup(doms->objs, uuidstr) != NULL) {
@@ -570,16 +717,104 @@ virDomainObjListLoadStatus(virDomainObjList *doms,
     if (notify)
         (*notify)(obj, 1, opaque);
 
-    VIR_FREE(statusFile);
     return obj;
 
  error:
     virDomainObjEndAPI(&obj);
-    VIR_FREE(statusFile);
     return NULL;
 }
 
 
+/* Upper bound of threads parsing config files concurrently */
+#define VIR_DOMAIN_OBJ_LIST_LOAD_WORKERS 8
+
+typedef struct _virDomainObjListLoadData virDomainObjListLoadData;
+struct _virDomainObjListLoadData {
+    virDomainXMLOption *xmlopt;
+    const char *configDir;
+    const char *autostartDir;
+    bool liveStatus;
+
+    char **names;
+    size_t nnames;
+    int next; /* index of the next name to parse, atomic */
+
+    /* Parse results, indexed like @names. Either @objs is filled in for
+     * status files, or @defs and @autostart for persistent configs. The
+     * objects are unlocked, the worker thread which parsed them must not
+     * own their lock. @errors holds the error of each failed parse as it
+     * is thread local. */
+    virDomainObj **objs;
+    virDomainDef **defs;
+    int *autostart;
+    virErrorPtr *errors;
+};
+
+
+static void
+virDomainObjListLoadWorker(void *opaque)
+{
+    virDomainObjListLoadData *data = opaque;
+    int i;
+
+    while ((i = g_atomic_int_add(&data->next, 1)) < (int) data->nnames) {
+        VIR_INFO("Loading config file '%s.xml'", data->names[i]);
+
+        if (data->liveStatus) {
+            data->objs[i] = virDomainObjListParseStatus(data->xmlopt,
+                                                        data->configDir,
+                                                        data->names[i]);
+            if (data->objs[i])
+                virObjectUnlock(data->objs[i]);
+            else
+                virErrorPreserveLast(&data->errors[i]);
+        } else {
+            data->defs[i] = virDomainObjListParseConfig(data->xmlopt,
+                                                        data->configDir,
+                                                        data->autostartDir,
+                                                        data->names[i],
+                                                        &data->autostart[i]);
+            if (!data->defs[i])
+                virErrorPreserveLast(&data->errors[i]);
+        }
+    }
+}
+
+
+/*
+ * The XML parsing dominates the time it takes to load the domains so
+ * the files are parsed by up to VIR_DOMAIN_OBJ_LIST_LOAD_WORKERS threads,
+ * including the calling one. The parsed domains are then added to the
+ * list in the order of the directory listing, just like they would be
+ * if parsed one by one.
+ */
+static void
+virDomainObjListLoadParse(virDomainObjListLoadData *data)
+{
+    g_autofree virThread *threads = NULL;
+    size_t nthreads = MIN(data->nnames, VIR_DOMAIN_OBJ_LIST_LOAD_WORKERS);
+    size_t i;
+
+    if (nthreads > 1)
+        threads = g_new0(virThread, nthreads - 1);
+
+    for (i = 0; i + 1 < nthreads; i++) {
+        if (virThreadCreateFull(&threads[i], true, virDomainObjListLoadWorker,
+                                "dom-load", false, data) < 0) {
+            /* the threads created so far and this one do the work */
+            virResetLastError();
+            break;
+        }
+    }
+    nthreads = i;
+
+    virDomainObjListLoadWorker(data);
+
+    for (i = 0; i < nthreads; i++)
+        virThreadJoin(&threads[i]);
+}
+
+
 int
 virDomainObjListLoadAllConfigs(virDomainObjList *doms,
                                const char *configDir,
@@ -591,6 +826,13 @@ virDomainObjListLoadAllConfigs(virDomainObjList *doms,
 {
     g_autoptr(DIR) dir = NULL;
     struct dirent *entry;
+    virDomainObjListLoadData data = {
+        .xmlopt = xmlopt,
+        .configDir = configDir,
+        .autostartDir = autostartDir,
+        .liveStatus = liveStatus,
+    };
+    size_t i;
     int ret = -1;
     int rc;
 
@@ -599,42 +841,75 @@ virDomainObjListLoadAllConfigs(virDomainObjList *doms,
     if ((rc = virDirOpenIfExists(&dir, configDir)) <= 0)
         return rc;
 
-    virObjectRWLockWrite(doms);
-
     while ((ret = virDirRead(dir, &entry, configDir)) > 0) {
-        virDomainObj *dom;
+        char *name;
 
         if (!virStringStripSuffix(entry->d_name, ".xml"))
             continue;
 
+        name = g_strdup(entry->d_name);
+        ignore_value(VIR_APPEND_ELEMENT(data.names, data.nnames, name));
+    }
+
+    if (data.nnames == 0)
+        return ret;
+
+    if (liveStatus) {
+        data.objs = g_new0(virDomainObj *, data.nnames);
+    } else {
+        data.defs = g_new0(virDomainDef *, data.nnames);
+        data.autostart = g_new0(int, data.nnames);
+    }
+    data.errors = g_new0(virErrorPtr, data.nnames);
+
+    virObjectRWLockWrite(doms);
+
+    virDomainObjListLoadParse(&data);
+
+    for (i = 0; i < data.nnames; i++) {
+        virDomainObj *dom = NULL;
+
         /* NB: ignoring errors, so one malformed config doesn't
            kill the whole process */
-        VIR_INFO("Loading config file '%s.xml'", entry->d_name);
-        if (liveStatus)
-            dom = virDomainObjListLoadStatus(doms,
-                                             configDir,
-                                             entry->d_name,
-                                             xmlopt,
-                                             notify,
-                                             opaque);
-        else
-            dom = virDomainObjListLoadConfig(doms,
-                                             xmlopt,
-                                             configDir,
-                                             autostartDir,
-                                             entry->d_name,
-                                             notify,
-                                             opaque);
+        if (liveStatus) {
+            if (data.objs[i]) {
+                virObjectLock(data.objs[i]);
+                dom = virDomainObjListLoadStatus(doms,
+                                                 data.objs[i],
+                                                 notify,
+                                                 opaque);
+            }
+        } else {
+            if (data.defs[i])
+                dom = virDomainObjListLoadConfig(doms,
+                                                 xmlopt,
+                                                 data.defs[i],
+                                                 data.autostart[i],
+                                                 notify,
+                                                 opaque);
+        }
+
         if (dom) {
             if (!liveStatus)
                 dom->persistent = 1;
             virDomainObjEndAPI(&dom);
         } else {
-            VIR_ERROR(_("Failed to load config for domain '%s'"), entry->d_name);
+            /* make the error of the worker thread the last one here */
+            if (data.errors[i])
+                virErrorRestore(&data.errors[i]);
+            VIR_ERROR(_("Failed to load config for domain '%s'"), data.names[i]);
         }
     }
 
     virObjectRWUnlock(doms);
+
+    for (i = 0; i < data.nnames; i++)
+        g_free(data.names[i]);
+    g_free(data.names);
+    g_free(data.objs);
+    g_free(data.defs);
+    g_free(data.autostart);
+    g_free(data.errors);
     return ret;
 }
 
@@ -647,26 +922,48 @@ struct virDomainObjListData {
 };
 
 
+/*
+ * Returns the published summary of @obj so that enumerating the list
+ * doesn't have to wait for the domain lock which may be held for a long
+ * time by a running job. Only an object which never had one published
+ * is locked to create it.
+ */
+static virDomainObjSummary *
+virDomainObjListGetSummary(virDomainObj *obj)
+{
+    virDomainObjSummary *summary;
+
+    if ((summary = virDomainObjGetSummary(obj)))
+        return summary;
+
+    virObjectLock(obj);
+    virDomainObjPublishSummary(obj);
+    virObjectUnlock(obj);
+
+    return virDomainObjGetSummary(obj);
+}
+
+
 static int
 virDomainObjListCount(void *payload,
                       const char *name G_GNUC_UNUSED,
                       void *opaque)
 {
-    virDomainObj *obj = payload;
+    g_autoptr(virDomainObjSummary) summary = NULL;
     struct virDomainObjListData *data = opaque;
-    virObjectLock(obj);
+
+    if (!(summary = virDomainObjListGetSummary(payload)))
+        return 0;
     if (data->filter &&
-        !data->filter(data->conn, obj->def))
-        goto cleanup;
-    if (virDomainObjIsActive(obj)) {
+        !data->filter(data->conn, summary->def))
+        return 0;
+    if (summary->def->id != -1) {
         if (data->active)
             data->count++;
     } else {
         if (!data->active)
             data->count++;
     }
- cleanup:
-    virObjectUnlock(obj);
     return 0;
 }
 
@@ -699,16 +996,16 @@ virDomainObjListCopyActiveIDs(void *payload,
                               const char *name G_GNUC_UNUSED,
                               void *opaque)
 {
-    virDomainObj *obj = payload;
+    g_autoptr(virDomainObjSummary) summary = NULL;
     struct virDomainIDData *data = opaque;
-    virObjectLock(obj);
+
+    if (!(summary = virDomainObjListGetSummary(payload)))
+        return 0;
     if (data->filter &&
-        !data->filter(data->conn, obj->def))
-        goto cleanup;
-    if (virDomainObjIsActive(obj) && data->numids < data->maxids)
-        data->ids[data->numids++] = obj->def->id;
- cleanup:
-    virObjectUnlock(obj);
+        !data->filter(data->conn, summary->def))
+        return 0;
+    if (summary->def->id != -1 && data->numids < data->maxids)
+        data->ids[data->numids++] = summary->def->id;
     return 0;
 }
 
@@ -744,23 +1041,22 @@ virDomainObjListCopyInactiveNames(void *payload,
                                   const char *name G_GNUC_UNUSED,
                                   void *opaque)
 {
-    virDomainObj *obj = payload;
+    g_autoptr(virDomainObjSummary) summary = NULL;
     struct virDomainNameData *data = opaque;
 
     if (data->oom)
         return 0;
 
-    virObjectLock(obj);
+    if (!(summary = virDomainObjListGetSummary(payload)))
+        return 0;
     if (data->filter &&
-        !data->filter(data->conn, obj->def))
-        goto cleanup;
-    if (!virDomainObjIsActive(obj) && data->numnames < data->maxnames) {
-        data->names[data->numnames] = g_strdup(obj->def->name);
+        !data->filter(data->conn, summary->def))
+        return 0;
+    if (summary->def->id == -1 && data->numnames < data->maxnames) {
+        data->names[data->numnames] = g_strdup(summary->def->name);
         data->numnames++;
     }
 
- cleanup:
-    virObjectUnlock(obj);
     return 0;
 }
 
@@ -846,28 +1142,29 @@ virDomainObjListForEach(virDomainObjList *doms,
 
 #define MATCH(FLAG) (filter & (FLAG))
 static bool
-virDomainObjMatchFilter(virDomainObj *vm,
+virDomainObjMatchFilter(virDomainObjSummary *summary,
+                        virDomainObj *vm,
                         unsigned int filter)
 {
+    bool active = summary->def->id != -1;
+
     /* filter by active state */
     if (MATCH(VIR_CONNECT_LIST_DOMAINS_FILTERS_ACTIVE) &&
-        !((MATCH(VIR_CONNECT_LIST_DOMAINS_ACTIVE) &&
-           virDomainObjIsActive(vm)) ||
-          (MATCH(VIR_CONNECT_LIST_DOMAINS_INACTIVE) &&
-           !virDomainObjIsActive(vm))))
+        !((MATCH(VIR_CONNECT_LIST_DOMAINS_ACTIVE) && active) ||
+          (MATCH(VIR_CONNECT_LIST_DOMAINS_INACTIVE) && !active)))
         return false;
 
     /* filter by persistence */
     if (MATCH(VIR_CONNECT_LIST_DOMAINS_FILTERS_PERSISTENT) &&
         !((MATCH(VIR_CONNECT_LIST_DOMAINS_PERSISTENT) &&
-           vm->persistent) ||
+           summary->persistent) ||
           (MATCH(VIR_CONNECT_LIST_DOMAINS_TRANSIENT) &&
-           !vm->persistent)))
+           !summary->persistent)))
         return false;
 
     /* filter by domain state */
     if (MATCH(VIR_CONNECT_LIST_DOMAINS_FILTERS_STATE)) {
-        int st = virDomainObjGetState(vm, NULL);
+        int st = summary->state.state;
         if (!((MATCH(VIR_CONNECT_LIST_DOMAINS_RUNNING) &&
                st == VIR_DOMAIN_RUNNING) ||
               (MATCH(VIR_CONNECT_LIST_DOMAINS_PAUSED) &&
@@ -884,17 +1181,20 @@ virDomainObjMatchFilter(virDomainObj *vm,
     /* filter by existence of managed save state */
     if (MATCH(VIR_CONNECT_LIST_DOMAINS_FILTERS_MANAGEDSAVE) &&
         !((MATCH(VIR_CONNECT_LIST_DOMAINS_MANAGEDSAVE) &&
-           vm->hasManagedSave) ||
+           summary->hasManagedSave) ||
           (MATCH(VIR_CONNECT_LIST_DOMAINS_NO_MANAGEDSAVE) &&
-           !vm->hasManagedSave)))
+           !summary->hasManagedSave)))
         return false;
 
     /* filter by autostart option */
     if (MATCH(VIR_CONNECT_LIST_DOMAINS_FILTERS_AUTOSTART) &&
-        !((MATCH(VIR_CONNECT_LIST_DOMAINS_AUTOSTART) && vm->autostart) ||
-          (MATCH(VIR_CONNECT_LIST_DOMAINS_NO_AUTOSTART) && !vm->autostart)))
+        !((MATCH(VIR_CONNECT_LIST_DOMAINS_AUTOSTART) && summary->autostart) ||
+          (MATCH(VIR_CONNECT_LIST_DOMAINS_NO_AUTOSTART) && !summary->autostart)))
         return false;
 
+    /* The remaining filters need the full domain object which is passed
+     * (and locked) only when they are requested. */
+
     /* filter by snapshot existence */
     if (MATCH(VIR_CONNECT_LIST_DOMAINS_FILTERS_SNAPSHOT)) {
         int nsnap = virDomainSnapshotObjListNum(vm->snapshots, NULL, 0);
@@ -942,28 +1242,43 @@ virDomainObjListFilter(virDomainObj ***list,
                        virDomainObjListACLFilter filter,
                        unsigned int flags)
 {
+    /* Snapshot and checkpoint lists are not part of the summary */
+    bool needLock = !!(flags & (VIR_CONNECT_LIST_DOMAINS_FILTERS_SNAPSHOT |
+                                VIR_CONNECT_LIST_DOMAINS_FILTERS_CHECKPOINT));
     size_t i = 0;
 
     while (i < *nvms) {
         virDomainObj *vm = (*list)[i];
+        g_autoptr(virDomainObjSummary) summary = NULL;
+        bool match;
 
-        virObjectLock(vm);
+        if (needLock) {
+            virObjectLock(vm);
+            virDomainObjPublishSummary(vm);
+            summary = virDomainObjGetSummary(vm);
+        } else {
+            summary = virDomainObjListGetSummary(vm);
+        }
 
         /* do not list the object if:
          * 1) it's being removed.
          * 2) connection does not have ACL to see it
          * 3) it doesn't match the filter
          */
-        if (vm->removing ||
-            (filter && !filter(conn, vm->def)) ||
-            !virDomainObjMatchFilter(vm, flags)) {
+        match = summary &&
+            !summary->removing &&
+            (!filter || filter(conn, summary->def)) &&
+            virDomainObjMatchFilter(summary, needLock ? vm : NULL, flags);
+
+        if (needLock)
             virObjectUnlock(vm);
+
+        if (!match) {
             virObjectUnref(vm);
             VIR_DELETE_ELEMENT(*list, i, *nvms);
             continue;
         }
 
-        virObjectUnlock(vm);
         i++;
     }
 }
@@ -1072,11 +1387,12 @@ virDomainObjListExport(virDomainObjList *domlist,
         doms = g_new0(virDomainPtr, nvms + 1);
 
         for (i = 0; i < nvms; i++) {
-            virDomainObj *vm = vms[i];
+            g_autoptr(virDomainObjSummary) summary = NULL;
 
-            virObjectLock(vm);
-            doms[i] = virGetDomain(conn, vm->def->name, vm->def->uuid, vm->def->id);
-            virObjectUnlock(vm);
+            /* virDomainObjListFilter made sure every domain has one */
+            summary = virDomainObjGetSummary(vms[i]);
+            doms[i] = virGetDomain(conn, summary->def->name,
+                                   summary->def->uuid, summary->def->id);
 
             if (!doms[i])
                 goto cleanup;
@@ -56,6 +56,9 @@ int virDomainObjListRename(virDomainObjList *doms,
                            virDomainObjListRenameCallback callback,
                            void *opaque);
 
+void virDomainObjListUpdateID(virDomainObjList *doms,
+                              virDomainObj *vm);
+
 void virDomainObjListRemove(virDomainObjList *doms,
                             virDomainObj *dom);
 void virDomainObjListRemoveLocked(virDomainObjList *doms,
@@ -53,6 +53,7 @@ struct _virNetworkObj {
 
     virBitmap *classIdMap; /* bitmap of class IDs for QoS */
     unsigned long long floor_sum; /* sum of all 'floor'-s of attached NICs */
+    char *fwBackend; /* firewall backend which installed the rules */
 
     unsigned int taint;
 
@@ -261,6 +262,22 @@ virNetworkObjSetFloorSum(virNetworkObj *obj,
 }
 
 
+const char *
+virNetworkObjGetFwBackend(virNetworkObj *obj)
+{
+    return obj->fwBackend;
+}
+
+
+void
+virNetworkObjSetFwBackend(virNetworkObj *obj,
+                          const char *fwBackend)
+{
+    g_free(obj->fwBackend);
+    obj->fwBackend = g_strdup(fwBackend);
+}
+
+
 void
 virNetworkObjSetMacMap(virNetworkObj *obj,
                        virMacMap *macmap)
@@ -477,6 +494,7 @@ virNetworkObjDispose(void *opaque)
     virNetworkDefFree(obj->def);
     virNetworkDefFree(obj->newDef);
     virBitmapFree(obj->classIdMap);
+    g_free(obj->fwBackend);
     virObjectUnref(obj->macmap);
 }
 
@@ -825,6 +843,10 @@ virNetworkObjFormat(virNetworkObj *obj,
     virBufferAsprintf(&buf, "<floor sum='%llu'/>\n", obj->floor_sum);
     VIR_FREE(classIdStr);
 
+    if (obj->fwBackend)
+        virBufferEscapeString(&buf, "<firewall backend='%s'/>\n",
+                              obj->fwBackend);
+
     for (i = 0; i < VIR_NETWORK_TAINT_LAST; i++) {
         if (obj->taint & (1 << i))
             virBufferAsprintf(&buf, "<taint flag='%s'/>\n",
@@ -877,6 +899,7 @@ virNetworkLoadState(virNetworkObjList *nets,
     xmlXPathContextPtr ctxt = NULL;
     virBitmap *classIdMap = NULL;
     unsigned long long floor_sum_val = 0;
+    g_autofree char *fwBackend = NULL;
     unsigned int taint = 0;
     int n;
     size_t i;
@@ -936,6 +959,8 @@ virNetworkLoadState(virNetworkObjList *nets,
         }
         VIR_FREE(floor_sum);
 
+        fwBackend = virXPathString("string(./firewall[1]/@backend)", ctxt);
+
         if ((n = virXPathNodeSet("./taint", ctxt, &nodes)) < 0)
             goto error;
 
@@ -973,6 +998,7 @@ virNetworkLoadState(virNetworkObjList *nets,
     if (floor_sum_val > 0)
         obj->floor_sum = floor_sum_val;
 
+    obj->fwBackend = g_steal_pointer(&fwBackend);
     obj->taint = taint;
     obj->active = true; /* network with a state file is by definition active */
 
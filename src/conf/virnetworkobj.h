@@ -83,6 +83,13 @@ void
 virNetworkObjSetFloorSum(virNetworkObj *obj,
                          unsigned long long floor_sum);
 
+const char *
+virNetworkObjGetFwBackend(virNetworkObj *obj);
+
+void
+virNetworkObjSetFwBackend(virNetworkObj *obj,
+                          const char *fwBackend);
+
 void
 virNetworkObjSetMacMap(virNetworkObj *obj,
                        virMacMap *macmap);
@@ -45,6 +45,9 @@ struct _virNWFilterObj {
 struct _virNWFilterObjList {
     size_t count;
     virNWFilterObj **objs;
+
+    /* bumped whenever a filter definition is added, changed or removed */
+    int generation;
 };
 
 
@@ -124,6 +127,29 @@ virNWFilterObjListNew(void)
 }
 
 
+/**
+ * virNWFilterObjListGetGeneration:
+ * @nwfilters: list of filters
+ *
+ * Returns a counter which changes whenever any filter definition in
+ * @nwfilters is added, replaced or removed. Users caching data derived
+ * from the definitions can compare it to find out whether their data
+ * is still current. The counter must be read before the definitions.
+ */
+unsigned int
+virNWFilterObjListGetGeneration(virNWFilterObjList *nwfilters)
+{
+    return g_atomic_int_get(&nwfilters->generation);
+}
+
+
+static void
+virNWFilterObjListBumpGeneration(virNWFilterObjList *nwfilters)
+{
+    g_atomic_int_inc(&nwfilters->generation);
+}
+
+
 void
 virNWFilterObjListRemove(virNWFilterObjList *nwfilters,
                          virNWFilterObj *obj)
@@ -137,6 +163,7 @@ virNWFilterObjListRemove(virNWFilterObjList *nwfilters,
         if (nwfilters->objs[i] == obj) {
             virNWFilterObjUnlock(nwfilters->objs[i]);
             virNWFilterObjFree(nwfilters->objs[i]);
+            virNWFilterObjListBumpGeneration(nwfilters);
 
             VIR_DELETE_ELEMENT(nwfilters->objs, i, nwfilters->count);
             break;
@@ -351,6 +378,7 @@ virNWFilterObjListAssignDef(virNWFilterObjList *nwfilters,
         if (virNWFilterDefEqual(def, objdef)) {
             virNWFilterDefFree(objdef);
             obj->def = def;
+            virNWFilterObjListBumpGeneration(nwfilters);
             return obj;
         }
 
@@ -365,6 +393,7 @@ virNWFilterObjListAssignDef(virNWFilterObjList *nwfilters,
         virNWFilterDefFree(objdef);
         obj->def = def;
         obj->newDef = NULL;
+        virNWFilterObjListBumpGeneration(nwfilters);
         return obj;
     }
 
@@ -378,6 +407,7 @@ virNWFilterObjListAssignDef(virNWFilterObjList *nwfilters,
         return NULL;
     }
     obj->def = def;
+    virNWFilterObjListBumpGeneration(nwfilters);
 
     return obj;
 }
@@ -60,6 +60,9 @@ virNWFilterObjListNew(void);
 void
 virNWFilterObjListFree(virNWFilterObjList *nwfilters);
 
+unsigned int
+virNWFilterObjListGetGeneration(virNWFilterObjList *nwfilters);
+
 void
 virNWFilterObjListRemove(virNWFilterObjList *nwfilters,
                          virNWFilterObj *obj);
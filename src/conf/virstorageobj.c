@@ -92,6 +92,10 @@ struct _virStoragePoolObj {
     virStoragePoolDef *newDef;
 
     virStorageVolObjList *volumes;
+
+    /* volumes known before the refresh in progress started, consulted
+     * by backends which only re-probe changed volumes */
+    virStorageVolObjList *stashedVolumes;
 };
 
 struct _virStoragePoolObjList {
@@ -371,6 +375,7 @@ virStoragePoolObjDispose(void *opaque)
 
     virStoragePoolObjClearVols(obj);
     virObjectUnref(obj->volumes);
+    virObjectUnref(obj->stashedVolumes);
 
     virStoragePoolDefFree(obj->def);
     virStoragePoolDefFree(obj->newDef);
@@ -635,6 +640,87 @@ virStoragePoolObjClearVols(virStoragePoolObj *obj)
 }
 
 
+/**
+ * virStoragePoolObjStashVols:
+ * @obj: pool object
+ *
+ * Moves the current volumes of @obj aside and leaves the pool with an
+ * empty volume list, as virStoragePoolObjClearVols() would. Until
+ * virStoragePoolObjDropStashedVols() is called, the backend refreshing
+ * the pool can reclaim the definition of any unchanged volume through
+ * virStoragePoolObjTakeStashedVol() instead of probing it again.
+ *
+ * Returns 0 on success, -1 on failure (the volumes are cleared then).
+ */
+int
+virStoragePoolObjStashVols(virStoragePoolObj *obj)
+{
+    virStorageVolObjList *volumes;
+
+    if (!(volumes = virStorageVolObjListNew())) {
+        virStoragePoolObjClearVols(obj);
+        return -1;
+    }
+
+    virObjectUnref(obj->stashedVolumes);
+    obj->stashedVolumes = obj->volumes;
+    obj->volumes = volumes;
+
+    return 0;
+}
+
+
+/**
+ * virStoragePoolObjTakeStashedVol:
+ * @obj: pool object
+ * @path: target path of the volume
+ *
+ * Removes the stashed volume with target @path and hands its definition
+ * over to the caller.
+ *
+ * Returns the volume definition or NULL if no such volume was stashed.
+ */
+virStorageVolDef *
+virStoragePoolObjTakeStashedVol(virStoragePoolObj *obj,
+                                const char *path)
+{
+    virStorageVolObjList *volumes = obj->stashedVolumes;
+    virStorageVolObj *volobj;
+    virStorageVolDef *voldef;
+
+    if (!volumes)
+        return NULL;
+
+    virObjectRWLockWrite(volumes);
+
+    if (!(volobj = virHashLookup(volumes->objsPath, path))) {
+        virObjectRWUnlock(volumes);
+        return NULL;
+    }
+
+    virObjectRef(volobj);
+    virObjectLock(volobj);
+
+    voldef = g_steal_pointer(&volobj->voldef);
+    virHashRemoveEntry(volumes->objsKey, voldef->key);
+    virHashRemoveEntry(volumes->objsName, voldef->name);
+    virHashRemoveEntry(volumes->objsPath, voldef->target.path);
+
+    virStorageVolObjEndAPI(&volobj);
+    virObjectRWUnlock(volumes);
+
+    return voldef;
+}
+
+
+void
+virStoragePoolObjDropStashedVols(virStoragePoolObj *obj)
+{
+    virObjectUnref(obj->stashedVolumes);
+    obj->stashedVolumes = NULL;
+}
+
+
 int
 virStoragePoolObjAddVol(virStoragePoolObj *obj,
                         virStorageVolDef *voldef)
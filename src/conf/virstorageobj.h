@@ -173,6 +173,16 @@ virStorageVolDefFindByName(virStoragePoolObj *obj,
 void
 virStoragePoolObjClearVols(virStoragePoolObj *obj);
 
+int
+virStoragePoolObjStashVols(virStoragePoolObj *obj);
+
+virStorageVolDef *
+virStoragePoolObjTakeStashedVol(virStoragePoolObj *obj,
+                                const char *path);
+
+void
+virStoragePoolObjDropStashedVols(virStoragePoolObj *obj);
+
 typedef bool
 (*virStoragePoolVolumeACLFilter)(virConnectPtr conn,
                                  virStoragePoolDef *pool,
@@ -131,6 +131,12 @@ typedef int
                                    virStorageVolPtr **vols,
                                    unsigned int flags);
 
+typedef int
+(*virDrvStoragePoolListAllVolumesInfo)(virStoragePoolPtr pool,
+                                       virTypedParameterPtr *params,
+                                       int *nparams,
+                                       unsigned int flags);
+
 typedef virStorageVolPtr
 (*virDrvStorageVolLookupByName)(virStoragePoolPtr pool,
                                 const char *name);
@@ -259,6 +265,7 @@ struct _virStorageDriver {
     virDrvStoragePoolNumOfVolumes storagePoolNumOfVolumes;
     virDrvStoragePoolListVolumes storagePoolListVolumes;
     virDrvStoragePoolListAllVolumes storagePoolListAllVolumes;
+    virDrvStoragePoolListAllVolumesInfo storagePoolListAllVolumesInfo;
     virDrvStorageVolLookupByName storageVolLookupByName;
     virDrvStorageVolLookupByKey storageVolLookupByKey;
     virDrvStorageVolLookupByPath storageVolLookupByPath;
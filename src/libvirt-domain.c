@@ -11924,6 +11924,11 @@ virConnectGetDomainCapabilities(virConnectPtr conn,
  * is returned for the domain.  That subset being statistics that
  * don't involve querying the underlying hypervisor.
  *
+ * Passing VIR_CONNECT_GET_ALL_DOMAINS_STATS_CACHED in @flags allows the
+ * hypervisor to report statistics gathered recently by another caller
+ * passing the flag instead of querying them again. The maximum age of such
+ * statistics is configured by the hypervisor driver.
+ *
  * Similarly to virConnectListAllDomains, @flags can contain various flags to
  * filter the list of domains to provide stats for.
  *
@@ -12014,6 +12019,11 @@ virConnectGetAllDomainStats(virConnectPtr conn,
  * is returned for the domain.  That subset being statistics that
  * don't involve querying the underlying hypervisor.
  *
+ * Passing VIR_CONNECT_GET_ALL_DOMAINS_STATS_CACHED in @flags allows the
+ * hypervisor to report statistics gathered recently by another caller
+ * passing the flag instead of querying them again. The maximum age of such
+ * statistics is configured by the hypervisor driver.
+ *
  * Note that any of the domain list filtering flags in @flags may be rejected
  * by this function.
  *
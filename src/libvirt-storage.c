@@ -1245,6 +1245,77 @@ virStoragePoolNumOfVolumes(virStoragePoolPtr pool)
 }
 
 
+/**
+ * virStoragePoolListAllVolumesInfo:
+ * @pool: Pointer to storage pool
+ * @params: pointer to a variable to store the array of typed parameters
+ * @nparams: pointer to a variable to store the number of typed parameters
+ * @flags: extra flags; not used yet, so callers should always pass 0
+ *
+ * Collect the basic information about all storage volumes in @pool in a
+ * single call. This is meant for inventorying large pools, where fetching
+ * the volume objects via virStoragePoolListAllVolumes() and then querying
+ * each of them via virStorageVolGetPath() and virStorageVolGetInfo() would
+ * take several round trips per volume.
+ *
+ * The reported values are the ones gathered by the last refresh of the pool
+ * and of the individual volumes; use virStoragePoolRefresh() first if they
+ * need to be current.
+ *
+ * The information is returned as a flat list of typed parameters in the
+ * following format:
+ *
+ *     "vol.count" - number of volumes in the list as unsigned int
+ *     "vol.<num>.name" - name of the volume as string
+ *     "vol.<num>.path" - path of the volume as string
+ *     "vol.<num>.type" - type of the volume as int, one of
+ *                        virStorageVolType
+ *     "vol.<num>.capacity" - logical size of the volume in bytes as unsigned
+ *                            long long
+ *     "vol.<num>.allocation" - current allocation of the volume in bytes as
+ *                              unsigned long long
+ *
+ * where <num> ranges from 0 to vol.count - 1. The volumes are not listed in
+ * any particular order.
+ *
+ * The caller is responsible for calling virTypedParamsFree to free memory
+ * returned in @params.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virStoragePoolListAllVolumesInfo(virStoragePoolPtr pool,
+                                 virTypedParameterPtr *params,
+                                 int *nparams,
+                                 unsigned int flags)
+{
+    VIR_DEBUG("pool=%p, params=%p, nparams=%p, flags=0x%x",
+              pool, params, nparams, flags);
+
+    virResetLastError();
+
+    virCheckStoragePoolReturn(pool, -1);
+    virCheckNonNullArgGoto(params, error);
+    virCheckNonNullArgGoto(nparams, error);
+
+    if (pool->conn->storageDriver &&
+        pool->conn->storageDriver->storagePoolListAllVolumesInfo) {
+        int ret;
+        ret = pool->conn->storageDriver->storagePoolListAllVolumesInfo(pool, params,
+                                                                       nparams, flags);
+        if (ret < 0)
+            goto error;
+        return ret;
+    }
+
+    virReportUnsupportedError();
+
+ error:
+    virDispatchError(pool->conn);
+    return -1;
+}
+
+
 /**
  * virStoragePoolListVolumes:
  * @pool: pointer to storage pool
@@ -903,6 +903,7 @@ libxlDomainCleanup(libxlDriverPrivate *driver,
 
     libxlLoggerCloseFile(cfg->logger, vm->def->id);
     vm->def->id = -1;
+    virDomainObjPublishSummary(vm);
 
     if (priv->deathW) {
         libxl_evdisable_domain_death(cfg->ctx, priv->deathW);
@@ -2161,6 +2161,7 @@ libxlDomainManagedSaveLoad(virDomainObj *vm,
         goto cleanup;
 
     vm->hasManagedSave = virFileExists(name);
+    virDomainObjPublishSummary(vm);
 
     ret = 0;
  cleanup:
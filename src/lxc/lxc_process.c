@@ -225,6 +225,7 @@ static void virLXCProcessCleanup(virLXCDriver *driver,
     virDomainObjSetState(vm, VIR_DOMAIN_SHUTOFF, reason);
     vm->pid = -1;
     vm->def->id = -1;
+    virDomainObjListUpdateID(driver->domains, vm);
 
     if (!!g_atomic_int_dec_and_test(&driver->nactive) && driver->inhibitCallback)
         driver->inhibitCallback(false, driver->inhibitOpaque);
@@ -1449,6 +1450,7 @@ int virLXCProcessStart(virConnectPtr conn,
     priv->stopReason = VIR_DOMAIN_EVENT_STOPPED_FAILED;
     priv->wantReboot = false;
     vm->def->id = vm->pid;
+    virDomainObjListUpdateID(driver->domains, vm);
     virDomainObjSetState(vm, VIR_DOMAIN_RUNNING, reason);
     priv->doneStopEvent = false;
 
@@ -1704,6 +1706,7 @@ virLXCProcessReconnectDomain(virDomainObj *vm,
         vm->def->id = vm->pid;
         virDomainObjSetState(vm, VIR_DOMAIN_RUNNING,
                              VIR_DOMAIN_RUNNING_UNKNOWN);
+        virDomainObjListUpdateID(driver->domains, vm);
 
         if (g_atomic_int_add(&driver->nactive, 1) == 0 && driver->inhibitCallback)
             driver->inhibitCallback(true, driver->inhibitOpaque);
@@ -1751,6 +1754,7 @@ virLXCProcessReconnectDomain(virDomainObj *vm,
 
     } else {
         vm->def->id = -1;
+        virDomainObjListUpdateID(driver->domains, vm);
     }
 
     ret = 0;
@@ -43,6 +43,7 @@
 #include "device_conf.h"
 #include "driver.h"
 #include "virbuffer.h"
+#include "virconf.h"
 #include "virpidfile.h"
 #include "vircommand.h"
 #include "viralloc.h"
@@ -676,6 +677,40 @@ firewalld_dbus_signal_callback(GDBusConnection *connection G_GNUC_UNUSED,
 #endif
 
 
+static int
+networkLoadDriverConfig(virNetworkDriverState *driver,
+                        const char *filename)
+{
+    g_autoptr(virConf) conf = NULL;
+    g_autofree char *firewallBackend = NULL;
+    int backend;
+
+    /* Avoid error from non-existent or unreadable file. */
+    if (access(filename, R_OK) == -1)
+        return 0;
+
+    if (!(conf = virConfReadFile(filename, 0)))
+        return -1;
+
+    if (virConfGetValueString(conf, "firewall_backend", &firewallBackend) < 0)
+        return -1;
+
+    if (firewallBackend) {
+        if ((backend = virNetworkFirewallBackendTypeFromString(firewallBackend)) < 0) {
+            virReportError(VIR_ERR_CONF_SYNTAX,
+                           _("unknown firewall_backend '%s' in %s"),
+                           firewallBackend, filename);
+            return -1;
+        }
+        driver->firewallBackend = backend;
+    }
+
+    VIR_DEBUG("Using %s firewall backend",
+              virNetworkFirewallBackendTypeToString(driver->firewallBackend));
+    return 0;
+}
+
+
 /**
  * networkStateInitialize:
  *
@@ -688,6 +723,7 @@ networkStateInitialize(bool privileged,
                        void *opaque G_GNUC_UNUSED)
 {
     g_autofree char *configdir = NULL;
+    g_autofree char *configfile = NULL;
     g_autofree char *rundir = NULL;
     bool autostart = true;
 #ifdef WITH_FIREWALLD
@@ -718,6 +754,7 @@ networkStateInitialize(bool privileged,
      * /etc/libvirt/... && /var/(run|lib)/libvirt/... (system/privileged).
      */
     if (privileged) {
+        configfile = g_strdup(SYSCONFDIR "/libvirt/network.conf");
         network_driver->networkConfigDir = g_strdup(SYSCONFDIR "/libvirt/qemu/networks");
         network_driver->networkAutostartDir = g_strdup(SYSCONFDIR "/libvirt/qemu/networks/autostart");
         network_driver->stateDir = g_strdup(RUNSTATEDIR "/libvirt/network");
@@ -728,6 +765,7 @@ networkStateInitialize(bool privileged,
         configdir = virGetUserConfigDirectory();
         rundir = virGetUserRuntimeDirectory();
 
+        configfile = g_strdup_printf("%s/network.conf", configdir);
         network_driver->networkConfigDir = g_strdup_printf("%s/qemu/networks", configdir);
         network_driver->networkAutostartDir = g_strdup_printf("%s/qemu/networks/autostart", configdir);
         network_driver->stateDir = g_strdup_printf("%s/network/lib", rundir);
@@ -736,6 +774,9 @@ networkStateInitialize(bool privileged,
         network_driver->radvdStateDir = g_strdup_printf("%s/radvd/lib", rundir);
     }
 
+    if (networkLoadDriverConfig(network_driver, configfile) < 0)
+        goto error;
+
     if (g_mkdir_with_parents(network_driver->stateDir, 0777) < 0) {
         virReportSystemError(errno,
                              _("cannot create directory %s"),
@@ -2109,10 +2150,54 @@ networkRefreshDaemons(virNetworkDriverState *driver)
 }
 
 
+/*
+ * networkGetFirewallBackend:
+ * @obj: the network object
+ *
+ * Returns the firewall backend which installed the rules of the running
+ * network @obj, which may differ from the configured one if the latter
+ * was changed since the network was started.
+ */
+static virNetworkFirewallBackend
+networkGetFirewallBackend(virNetworkObj *obj)
+{
+    const char *name = virNetworkObjGetFwBackend(obj);
+    int backend;
+
+    /* networks started by older libvirt have always used iptables */
+    if (!name)
+        return VIR_NETWORK_FIREWALL_BACKEND_IPTABLES;
+
+    if ((backend = virNetworkFirewallBackendTypeFromString(name)) < 0) {
+        VIR_WARN("Unknown firewall backend '%s' of network '%s'",
+                 name, virNetworkObjGetDef(obj)->name);
+        return VIR_NETWORK_FIREWALL_BACKEND_IPTABLES;
+    }
+
+    return backend;
+}
+
+
+static int
+networkAddFirewallRulesObj(virNetworkDriverState *driver,
+                           virNetworkObj *obj)
+{
+    virNetworkFirewallBackend backend = driver->firewallBackend;
+
+    if (networkAddFirewallRules(virNetworkObjGetDef(obj), backend) < 0)
+        return -1;
+
+    virNetworkObjSetFwBackend(obj,
+                              virNetworkFirewallBackendTypeToString(backend));
+    return 0;
+}
+
+
 static int
 networkReloadFirewallRulesHelper(virNetworkObj *obj,
-                                 void *opaque G_GNUC_UNUSED)
+                                 void *opaque)
 {
+    virNetworkDriverState *driver = opaque;
     virNetworkDef *def;
 
     virObjectLock(obj);
@@ -2126,9 +2211,16 @@ networkReloadFirewallRulesHelper(virNetworkObj *obj,
              * libvirt need to have iptables rules reloaded. The 4th L3
              * network type, forward='open', doesn't need this because it
              * has no iptables rules.
+             *
+             * The rules are removed by the backend which added them, but
+             * the new ones come from the configured one, which is how
+             * networks move over after the backend was changed.
              */
-            networkRemoveFirewallRules(def);
-            ignore_value(networkAddFirewallRules(def));
+            networkRemoveFirewallRules(def, networkGetFirewallBackend(obj));
+            if (networkAddFirewallRulesObj(driver, obj) == 0 &&
+                virNetworkObjSaveStatus(driver->stateDir, obj,
+                                        driver->xmlopt) < 0)
+                VIR_WARN("Unable to save status of network '%s'", def->name);
             break;
 
         case VIR_NETWORK_FORWARD_OPEN:
@@ -2165,7 +2257,7 @@ networkReloadFirewallRules(virNetworkDriverState *driver,
     networkPreReloadFirewallRules(driver, startup, force);
     virNetworkObjListForEach(driver->networks,
                              networkReloadFirewallRulesHelper,
-                             NULL);
+                             driver);
     networkPostReloadFirewallRules(startup);
 }
 
@@ -2391,7 +2483,7 @@ networkStartNetworkVirtual(virNetworkDriverState *driver,
 
     /* Add "once per network" rules */
     if (def->forward.type != VIR_NETWORK_FORWARD_OPEN &&
-        networkAddFirewallRules(def) < 0)
+        networkAddFirewallRulesObj(driver, obj) < 0)
         goto error;
 
     firewalRulesAdded = true;
@@ -2478,7 +2570,7 @@ networkStartNetworkVirtual(virNetworkDriverState *driver,
 
     if (firewalRulesAdded &&
         def->forward.type != VIR_NETWORK_FORWARD_OPEN)
-        networkRemoveFirewallRules(def);
+        networkRemoveFirewallRules(def, networkGetFirewallBackend(obj));
 
     virNetworkObjUnrefMacMap(obj);
 
@@ -2529,7 +2621,7 @@ networkShutdownNetworkVirtual(virNetworkDriverState *driver,
     ignore_value(virNetDevSetOnline(def->bridge, false));
 
     if (def->forward.type != VIR_NETWORK_FORWARD_OPEN)
-        networkRemoveFirewallRules(def);
+        networkRemoveFirewallRules(def, networkGetFirewallBackend(obj));
 
     ignore_value(virNetDevBridgeDelete(def->bridge));
 
@@ -3711,7 +3803,7 @@ networkUpdate(virNetworkPtr net,
                  * old rules (and remember to load new ones after the
                  * update).
                  */
-                networkRemoveFirewallRules(def);
+                networkRemoveFirewallRules(def, networkGetFirewallBackend(obj));
                 needFirewallRefresh = true;
                 break;
             default:
@@ -3739,14 +3831,15 @@ networkUpdate(virNetworkPtr net,
                             parentIndex, xml,
                             network_driver->xmlopt, flags) < 0) {
         if (needFirewallRefresh)
-            ignore_value(networkAddFirewallRules(def));
+            ignore_value(networkAddFirewallRulesObj(driver, obj));
         goto cleanup;
     }
 
     /* @def is replaced */
     def = virNetworkObjGetDef(obj);
 
-    if (needFirewallRefresh && networkAddFirewallRules(def) < 0)
+    if (needFirewallRefresh &&
+        networkAddFirewallRulesObj(driver, obj) < 0)
         goto cleanup;
 
     if (flags & VIR_NETWORK_UPDATE_AFFECT_CONFIG) {
@@ -28,6 +28,7 @@
 #include "virlog.h"
 #include "virfirewall.h"
 #include "virfirewalld.h"
+#include "network_nftables.h"
 
 #define VIR_FROM_THIS VIR_FROM_NONE
 
@@ -164,7 +165,13 @@ networkPreReloadFirewallRules(virNetworkDriverState *driver,
      * Any errors here are saved to be reported at time
      * of starting the network though as that makes them
      * more likely to be seen by a human
+     *
+     * None of this applies to the nftables backend, whose tables
+     * are set up along with the rules of each network.
      */
+    if (driver->firewallBackend == VIR_NETWORK_FIREWALL_BACKEND_NFTABLES)
+        return;
+
     if (chainInitDone && force) {
         /* The Private chains have already been initialized once
          * during this run of libvirtd, so 1) we can't do it again via
@@ -830,28 +837,31 @@ networkRemoveIPSpecificFirewallRules(virFirewall *fw,
 
 
 /* Add all rules for all ip addresses (and general rules) on a network */
-int networkAddFirewallRules(virNetworkDef *def)
+int networkAddFirewallRules(virNetworkDef *def,
+                            virNetworkFirewallBackend backend)
 {
     size_t i;
     virNetworkIPDef *ipdef;
     g_autoptr(virFirewall) fw = virFirewallNew();
 
-    if (virOnce(&createdOnce, networkSetupPrivateChains) < 0)
-        return -1;
+    if (backend == VIR_NETWORK_FIREWALL_BACKEND_IPTABLES) {
+        if (virOnce(&createdOnce, networkSetupPrivateChains) < 0)
+            return -1;
 
-    if (errInitV4 &&
-        (virNetworkDefGetIPByIndex(def, AF_INET, 0) ||
-         virNetworkDefGetRouteByIndex(def, AF_INET, 0))) {
-        virSetError(errInitV4);
-        return -1;
-    }
+        if (errInitV4 &&
+            (virNetworkDefGetIPByIndex(def, AF_INET, 0) ||
+             virNetworkDefGetRouteByIndex(def, AF_INET, 0))) {
+            virSetError(errInitV4);
+            return -1;
+        }
 
-    if (errInitV6 &&
-        (virNetworkDefGetIPByIndex(def, AF_INET6, 0) ||
-         virNetworkDefGetRouteByIndex(def, AF_INET6, 0) ||
-         def->ipv6nogw)) {
-        virSetError(errInitV6);
-        return -1;
+        if (errInitV6 &&
+            (virNetworkDefGetIPByIndex(def, AF_INET6, 0) ||
+             virNetworkDefGetRouteByIndex(def, AF_INET6, 0) ||
+             def->ipv6nogw)) {
+            virSetError(errInitV6);
+            return -1;
+        }
     }
 
     if (def->bridgeZone) {
@@ -920,6 +930,9 @@ int networkAddFirewallRules(virNetworkDef *def)
         }
     }
 
+    if (backend == VIR_NETWORK_FIREWALL_BACKEND_NFTABLES)
+        return networkNftablesAddFirewallRules(def);
+
     virFirewallStartTransaction(fw, 0);
 
     networkAddGeneralFirewallRules(fw, def);
@@ -948,11 +961,19 @@ int networkAddFirewallRules(virNetworkDef *def)
 }
 
 /* Remove all rules for all ip addresses (and general rules) on a network */
-void networkRemoveFirewallRules(virNetworkDef *def)
+void networkRemoveFirewallRules(virNetworkDef *def,
+                                virNetworkFirewallBackend backend)
 {
     size_t i;
     virNetworkIPDef *ipdef;
-    g_autoptr(virFirewall) fw = virFirewallNew();
+    g_autoptr(virFirewall) fw = NULL;
+
+    if (backend == VIR_NETWORK_FIREWALL_BACKEND_NFTABLES) {
+        networkNftablesRemoveFirewallRules(def);
+        return;
+    }
+
+    fw = virFirewallNew();
 
     virFirewallStartTransaction(fw, VIR_FIREWALL_TRANSACTION_IGNORE_ERRORS);
     networkRemoveChecksumFirewallRules(fw, def);
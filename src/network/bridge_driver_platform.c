@@ -23,6 +23,12 @@
 
 #include "bridge_driver_platform.h"
 
+VIR_ENUM_IMPL(virNetworkFirewallBackend,
+              VIR_NETWORK_FIREWALL_BACKEND_LAST,
+              "iptables",
+              "nftables",
+);
+
 #if defined(__linux__)
 # include "bridge_driver_linux.c"
 #else
@@ -26,6 +26,16 @@
 #include "virdnsmasq.h"
 #include "virnetworkobj.h"
 #include "object_event.h"
+#include "virenum.h"
+
+typedef enum {
+    VIR_NETWORK_FIREWALL_BACKEND_IPTABLES,
+    VIR_NETWORK_FIREWALL_BACKEND_NFTABLES,
+
+    VIR_NETWORK_FIREWALL_BACKEND_LAST,
+} virNetworkFirewallBackend;
+
+VIR_ENUM_DECL(virNetworkFirewallBackend);
 
 /* Main driver state */
 struct _virNetworkDriverState {
@@ -48,6 +58,9 @@ struct _virNetworkDriverState {
     char *dnsmasqStateDir;
     char *radvdStateDir;
 
+    /* Immutable value, set from network.conf */
+    virNetworkFirewallBackend firewallBackend;
+
     /* Require lock to get a reference on the object,
      * lockless access thereafter
      */
@@ -66,6 +79,8 @@ void networkPostReloadFirewallRules(bool startup);
 
 int networkCheckRouteCollision(virNetworkDef *def);
 
-int networkAddFirewallRules(virNetworkDef *def);
+int networkAddFirewallRules(virNetworkDef *def,
+                            virNetworkFirewallBackend backend);
 
-void networkRemoveFirewallRules(virNetworkDef *def);
+void networkRemoveFirewallRules(virNetworkDef *def,
+                                virNetworkFirewallBackend backend);
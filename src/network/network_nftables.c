@@ -0,0 +1,775 @@
+/*
+ * network_nftables.c: nftables firewall rules of virtual networks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * All virtual networks share one "libvirt_network" table per address
+ * family. Its base chains contain nothing but lookups in verdict maps
+ * keyed on the bridge (or, for NAT, the source subnet) which jump to
+ * the chains holding the rules of a single network:
+ *
+ *   input        iifname vmap @input_map         -> <bridge>_input
+ *   output       oifname vmap @output_map        -> <bridge>_output
+ *   forward      iifname . oifname @cross accept
+ *                oifname vmap @forward_in_map    -> <bridge>_fwd_in
+ *                iifname vmap @forward_out_map   -> <bridge>_fwd_out
+ *   postrouting  saddr vmap @nat_map             -> <bridge>_nat
+ *
+ * so a packet is classified by a few hash lookups no matter how many
+ * networks are running, and starting or stopping a network only adds
+ * or removes its own chains and map elements in a single transaction.
+ *
+ * Unlike with iptables, no rule fills in the checksum of DHCP replies
+ * as nftables can't compute checksums. That only helped DHCP clients
+ * from before 2010 which didn't cope with checksum offloading.
+ */
+
+#include <config.h>
+
+#include "network_nftables.h"
+#include "virbuffer.h"
+#include "virerror.h"
+#include "virfirewall.h"
+#include "virlog.h"
+#include "virsocketaddr.h"
+
+#define VIR_FROM_THIS VIR_FROM_NETWORK
+
+VIR_LOG_INIT("network.network_nftables");
+
+#define NFTABLES_TABLE "libvirt_network"
+
+typedef struct _networkNftablesFamily networkNftablesFamily;
+struct _networkNftablesFamily {
+    int af;
+    const char *name;     /* table family, also used to match addresses */
+    const char *addrType; /* type of the keys of the NAT map */
+};
+
+static const networkNftablesFamily networkNftablesFamilies[] = {
+    { AF_INET, "ip", "ipv4_addr" },
+    { AF_INET6, "ip6", "ipv6_addr" },
+};
+
+/* Suffixes of the chains holding the rules of a single network */
+static const char *const networkNftablesChains[] = {
+    "input", "output", "fwd_in", "fwd_out", "nat",
+};
+
+/* Verdict maps dispatching to the chains of a network by its bridge */
+static const char *const networkNftablesBridgeMaps[][2] = {
+    { "input_map", "input" },
+    { "output_map", "output" },
+    { "forward_in_map", "fwd_in" },
+    { "forward_out_map", "fwd_out" },
+};
+
+static const char networkLocalMulticastIPv4[] = "224.0.0.0/24";
+static const char networkLocalMulticastIPv6[] = "ff02::/16";
+static const char networkLocalBroadcast[] = "255.255.255.255";
+
+
+/* Chain names are identifiers, so anything but letters and digits
+ * in a bridge name is escaped, which keeps them unique too */
+static char *
+networkNftablesChainName(const char *bridge,
+                         const char *suffix)
+{
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    const char *cur;
+
+    for (cur = bridge; *cur; cur++) {
+        if (g_ascii_isalpha(*cur) ||
+            (g_ascii_isdigit(*cur) && cur != bridge))
+            virBufferAddChar(&buf, *cur);
+        else
+            virBufferAsprintf(&buf, "_%02x", (unsigned char)*cur);
+    }
+    virBufferAsprintf(&buf, "_%s", suffix);
+
+    return virBufferContentAndReset(&buf);
+}
+
+
+static char *
+networkNftablesQuoteIfname(const char *ifname)
+{
+    return g_strdup_printf("\"%s\"", ifname);
+}
+
+
+static char *
+networkNftablesFormatNetwork(virNetworkDef *def,
+                             virNetworkIPDef *ipdef)
+{
+    int prefix = virNetworkIPDefPrefix(ipdef);
+    virSocketAddr network;
+    g_autofree char *netstr = NULL;
+
+    if (prefix < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Invalid prefix or netmask for '%s'"),
+                       def->bridge);
+        return NULL;
+    }
+
+    if (virSocketAddrMaskByPrefix(&ipdef->address, prefix, &network) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Failure to mask address"));
+        return NULL;
+    }
+
+    if (!(netstr = virSocketAddrFormat(&network)))
+        return NULL;
+
+    return g_strdup_printf("%s/%d", netstr, prefix);
+}
+
+
+/* NB: in the case of IPv6, routing rules are added when the
+ * forward mode is NAT. This is because IPv6 has no NAT.
+ */
+static bool
+networkNftablesIsMasqueraded(virNetworkDef *def,
+                             virNetworkIPDef *ipdef)
+{
+    return def->forward.type == VIR_NETWORK_FORWARD_NAT &&
+        (VIR_SOCKET_ADDR_IS_FAMILY(&ipdef->address, AF_INET) ||
+         def->forward.natIPv6 == VIR_TRISTATE_BOOL_YES);
+}
+
+
+static bool
+networkNftablesIsForwarded(virNetworkDef *def)
+{
+    return def->forward.type == VIR_NETWORK_FORWARD_NAT ||
+        def->forward.type == VIR_NETWORK_FORWARD_ROUTE;
+}
+
+
+/* Like with iptables, the general IPv4 rules are always present and
+ * the IPv6 ones only if the network uses IPv6 at all */
+static bool
+networkNftablesHasFamily(virNetworkDef *def,
+                         const networkNftablesFamily *family)
+{
+    if (family->af == AF_INET)
+        return true;
+
+    return virNetworkDefGetIPByIndex(def, AF_INET6, 0) || def->ipv6nogw;
+}
+
+
+static void
+networkNftablesAddBaseChain(virFirewall *fw,
+                            const networkNftablesFamily *family,
+                            const char *chain,
+                            const char *type,
+                            const char *priority)
+{
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                       "add", "chain", family->name, NFTABLES_TABLE, chain,
+                       "{", "type", type, "hook", chain,
+                       "priority", priority, ";", "}",
+                       NULL);
+}
+
+
+static void
+networkNftablesAddBridgeMap(virFirewall *fw,
+                            const networkNftablesFamily *family,
+                            const char *map)
+{
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                       "add", "map", family->name, NFTABLES_TABLE, map,
+                       "{", "type", "ifname", ":", "verdict", ";", "}",
+                       NULL);
+}
+
+
+/* Creates the table with its base chains and maps unless they exist
+ * already. None of the objects is modified if it does. */
+static void
+networkNftablesAddTable(virFirewall *fw,
+                        const networkNftablesFamily *family)
+{
+    size_t i;
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                       "add", "table", family->name, NFTABLES_TABLE, NULL);
+
+    networkNftablesAddBaseChain(fw, family, "input", "filter", "0");
+    networkNftablesAddBaseChain(fw, family, "output", "filter", "0");
+    networkNftablesAddBaseChain(fw, family, "forward", "filter", "0");
+    networkNftablesAddBaseChain(fw, family, "postrouting", "nat", "100");
+
+    for (i = 0; i < G_N_ELEMENTS(networkNftablesBridgeMaps); i++)
+        networkNftablesAddBridgeMap(fw, family, networkNftablesBridgeMaps[i][0]);
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                       "add", "set", family->name, NFTABLES_TABLE, "cross",
+                       "{", "type", "ifname", ".", "ifname", ";", "}",
+                       NULL);
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                       "add", "map", family->name, NFTABLES_TABLE, "nat_map",
+                       "{", "type", family->addrType, ":", "verdict", ";",
+                       "flags", "interval", ";", "}",
+                       NULL);
+}
+
+
+/* (Re)populates the base chains. Flushing them first makes this
+ * idempotent, and since the maps are kept intact, so are the
+ * networks which are already running. */
+static void
+networkNftablesAddDispatchRules(virFirewall *fw,
+                                const networkNftablesFamily *family)
+{
+    const char *table = NFTABLES_TABLE;
+    const char *fam = family->name;
+    virFirewallLayer layer = VIR_FIREWALL_LAYER_NFTABLES;
+
+    virFirewallAddRule(fw, layer, "flush", "chain", fam, table, "input", NULL);
+    virFirewallAddRule(fw, layer, "add", "rule", fam, table, "input",
+                       "iifname", "vmap", "@input_map", NULL);
+
+    virFirewallAddRule(fw, layer, "flush", "chain", fam, table, "output", NULL);
+    virFirewallAddRule(fw, layer, "add", "rule", fam, table, "output",
+                       "oifname", "vmap", "@output_map", NULL);
+
+    /* Allow traffic between guests on the same bridge, before
+     * anything going in or out of a bridge is rejected */
+    virFirewallAddRule(fw, layer, "flush", "chain", fam, table, "forward", NULL);
+    virFirewallAddRule(fw, layer, "add", "rule", fam, table, "forward",
+                       "iifname", ".", "oifname", "@cross", "accept", NULL);
+    virFirewallAddRule(fw, layer, "add", "rule", fam, table, "forward",
+                       "oifname", "vmap", "@forward_in_map", NULL);
+    virFirewallAddRule(fw, layer, "add", "rule", fam, table, "forward",
+                       "iifname", "vmap", "@forward_out_map", NULL);
+
+    virFirewallAddRule(fw, layer, "flush", "chain", fam, table, "postrouting", NULL);
+    virFirewallAddRule(fw, layer, "add", "rule", fam, table, "postrouting",
+                       fam, "saddr", "vmap", "@nat_map", NULL);
+}
+
+
+static virFirewallRule *
+networkNftablesAddRule(virFirewall *fw,
+                       const networkNftablesFamily *family,
+                       virNetworkDef *def,
+                       const char *suffix)
+{
+    g_autofree char *chain = networkNftablesChainName(def->bridge, suffix);
+
+    return virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                              "add", "rule", family->name, NFTABLES_TABLE,
+                              chain, NULL);
+}
+
+
+static void
+networkNftablesAddPortRule(virFirewall *fw,
+                           const networkNftablesFamily *family,
+                           virNetworkDef *def,
+                           const char *suffix,
+                           const char *port1,
+                           const char *port2)
+{
+    virFirewallRule *rule = networkNftablesAddRule(fw, family, def, suffix);
+
+    virFirewallRuleAddArgList(fw, rule,
+                              "meta", "l4proto", "{", "tcp,", "udp", "}",
+                              "th", "dport", NULL);
+
+    if (port2) {
+        virFirewallRuleAddArg(fw, rule, "{");
+        virFirewallRuleAddArgFormat(fw, rule, "%s,", port1);
+        virFirewallRuleAddArgList(fw, rule, port2, "}", NULL);
+    } else
+        virFirewallRuleAddArg(fw, rule, port1);
+
+    virFirewallRuleAddArg(fw, rule, "accept");
+}
+
+
+static void
+networkNftablesAddUdpPortRule(virFirewall *fw,
+                              const networkNftablesFamily *family,
+                              virNetworkDef *def,
+                              const char *suffix,
+                              const char *port)
+{
+    virFirewallRule *rule = networkNftablesAddRule(fw, family, def, suffix);
+
+    virFirewallRuleAddArgList(fw, rule, "udp", "dport", port, "accept", NULL);
+}
+
+
+/* allow DHCP, DNS and TFTP requests through to dnsmasq & back out */
+static void
+networkNftablesAddServiceRules(virFirewall *fw,
+                               const networkNftablesFamily *family,
+                               virNetworkDef *def)
+{
+    size_t i;
+    virNetworkIPDef *ipv4def;
+
+    if (family->af == AF_INET6) {
+        if (!virNetworkDefGetIPByIndex(def, AF_INET6, 0))
+            return;
+
+        networkNftablesAddPortRule(fw, family, def, "input", "53", NULL);
+        networkNftablesAddUdpPortRule(fw, family, def, "input", "547");
+        networkNftablesAddPortRule(fw, family, def, "output", "53", NULL);
+        networkNftablesAddUdpPortRule(fw, family, def, "output", "546");
+        return;
+    }
+
+    /* First look for first IPv4 address that has dhcp or tftpboot defined. */
+    /* We support dhcp config on 1 IPv4 interface only. */
+    for (i = 0;
+         (ipv4def = virNetworkDefGetIPByIndex(def, AF_INET, i));
+         i++) {
+        if (ipv4def->nranges || ipv4def->nhosts || ipv4def->tftproot)
+            break;
+    }
+
+    networkNftablesAddPortRule(fw, family, def, "input", "53", "67");
+    networkNftablesAddPortRule(fw, family, def, "output", "53", "68");
+
+    if (ipv4def && ipv4def->tftproot) {
+        networkNftablesAddUdpPortRule(fw, family, def, "input", "69");
+        networkNftablesAddUdpPortRule(fw, family, def, "output", "69");
+    }
+}
+
+
+static void
+networkNftablesAddForwardRules(virFirewall *fw,
+                               const networkNftablesFamily *family,
+                               virNetworkDef *def,
+                               virNetworkIPDef *ipdef,
+                               const char *network)
+{
+    const char *forwardIf = virNetworkDefForwardIf(def, 0);
+    g_autofree char *forwardIfname = NULL;
+    virFirewallRule *rule;
+
+    if (forwardIf && *forwardIf)
+        forwardIfname = networkNftablesQuoteIfname(forwardIf);
+
+    /* allow forwarding packets from the bridge interface */
+    rule = networkNftablesAddRule(fw, family, def, "fwd_out");
+    if (forwardIfname)
+        virFirewallRuleAddArgList(fw, rule, "oifname", forwardIfname, NULL);
+    virFirewallRuleAddArgList(fw, rule,
+                              family->name, "saddr", network, "accept", NULL);
+
+    /* allow forwarding packets to the bridge interface, if masquerading
+     * only if they are part of an existing connection */
+    rule = networkNftablesAddRule(fw, family, def, "fwd_in");
+    if (forwardIfname)
+        virFirewallRuleAddArgList(fw, rule, "iifname", forwardIfname, NULL);
+    virFirewallRuleAddArgList(fw, rule, family->name, "daddr", network, NULL);
+    if (networkNftablesIsMasqueraded(def, ipdef))
+        virFirewallRuleAddArgList(fw, rule,
+                                  "ct", "state", "established,related", NULL);
+    virFirewallRuleAddArg(fw, rule, "accept");
+}
+
+
+static int
+networkNftablesAddMasqueradeRule(virFirewall *fw,
+                                 const networkNftablesFamily *family,
+                                 virNetworkDef *def,
+                                 const char *network,
+                                 bool ports)
+{
+    const char *forwardIf = virNetworkDefForwardIf(def, 0);
+    virSocketAddrRange *addr = &def->forward.addr;
+    virPortRange *port = &def->forward.port;
+    unsigned int portStart = 1024;
+    unsigned int portEnd = 65535;
+    g_autofree char *addrStartStr = NULL;
+    g_autofree char *addrEndStr = NULL;
+    g_auto(virBuffer) target = VIR_BUFFER_INITIALIZER;
+    virFirewallRule *rule;
+
+    if (ports && (port->start != 0 || port->end != 0)) {
+        if (port->start >= port->end || port->end >= 65536) {
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("Invalid port range '%u-%u'."),
+                           port->start, port->end);
+            return -1;
+        }
+        portStart = port->start;
+        portEnd = port->end;
+    }
+
+    if (VIR_SOCKET_ADDR_IS_FAMILY(&addr->start, family->af)) {
+        if (!(addrStartStr = virSocketAddrFormat(&addr->start)))
+            return -1;
+        if (VIR_SOCKET_ADDR_IS_FAMILY(&addr->end, family->af) &&
+            !(addrEndStr = virSocketAddrFormat(&addr->end)))
+            return -1;
+    }
+
+    rule = networkNftablesAddRule(fw, family, def, "nat");
+    if (forwardIf && *forwardIf) {
+        g_autofree char *forwardIfname = networkNftablesQuoteIfname(forwardIf);
+
+        virFirewallRuleAddArgList(fw, rule, "oifname", forwardIfname, NULL);
+    }
+    virFirewallRuleAddArgList(fw, rule, family->name, "saddr", network, NULL);
+    if (ports)
+        virFirewallRuleAddArgList(fw, rule,
+                                  "meta", "l4proto", "{", "tcp,", "udp", "}",
+                                  NULL);
+
+    /* Use snat if public addr is specified */
+    if (addrStartStr) {
+        /* IPv6 addresses need brackets to be told apart from ports */
+        bool brackets = ports && family->af == AF_INET6;
+
+        if (brackets) {
+            virBufferAsprintf(&target, "[%s]", addrStartStr);
+            if (addrEndStr)
+                virBufferAsprintf(&target, "-[%s]", addrEndStr);
+        } else {
+            virBufferAdd(&target, addrStartStr, -1);
+            if (addrEndStr)
+                virBufferAsprintf(&target, "-%s", addrEndStr);
+        }
+        virFirewallRuleAddArgList(fw, rule, "snat", "to", NULL);
+    } else {
+        virFirewallRuleAddArg(fw, rule, "masquerade");
+        if (ports)
+            virFirewallRuleAddArg(fw, rule, "to");
+    }
+
+    if (ports)
+        virBufferAsprintf(&target, ":%u-%u", portStart, portEnd);
+
+    if (virBufferUse(&target) > 0)
+        virFirewallRuleAddArg(fw, rule, virBufferCurrentContent(&target));
+
+    return 0;
+}
+
+
+static int
+networkNftablesAddNATRules(virFirewall *fw,
+                           const networkNftablesFamily *family,
+                           virNetworkDef *def,
+                           const char *network,
+                           bool first)
+{
+    virFirewallRule *rule;
+
+    /* Packets targeting the local network multicast range are never
+     * forwarded, and strict DHCP clients don't accept replies to the
+     * local broadcast address with changed source ports */
+    if (first) {
+        rule = networkNftablesAddRule(fw, family, def, "nat");
+        virFirewallRuleAddArgList(fw, rule, family->name, "daddr",
+                                  family->af == AF_INET ?
+                                  networkLocalMulticastIPv4 :
+                                  networkLocalMulticastIPv6,
+                                  "return", NULL);
+
+        if (family->af == AF_INET) {
+            rule = networkNftablesAddRule(fw, family, def, "nat");
+            virFirewallRuleAddArgList(fw, rule, family->name, "daddr",
+                                      networkLocalBroadcast, "return", NULL);
+        }
+    }
+
+    /* do not masquerade traffic within the network itself */
+    rule = networkNftablesAddRule(fw, family, def, "nat");
+    virFirewallRuleAddArgList(fw, rule,
+                              family->name, "saddr", network,
+                              family->name, "daddr", network,
+                              "return", NULL);
+
+    /* Guests need to be prevented from using source ports < 1024 for
+     * TCP and UDP, otherwise they can bypass the NFS "security" check
+     * on the source port number. */
+    if (networkNftablesAddMasqueradeRule(fw, family, def, network, true) < 0 ||
+        networkNftablesAddMasqueradeRule(fw, family, def, network, false) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static void
+networkNftablesAddElement(virFirewall *fw,
+                          const networkNftablesFamily *family,
+                          const char *action,
+                          const char *set,
+                          const char *key,
+                          const char *chain)
+{
+    virFirewallRule *rule;
+
+    rule = virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                              action, "element", family->name, NFTABLES_TABLE,
+                              set, "{", key, NULL);
+    if (chain)
+        virFirewallRuleAddArgList(fw, rule, ":", "jump", chain, NULL);
+    virFirewallRuleAddArg(fw, rule, "}");
+}
+
+
+/* Adds (or with @remove, deletes) the elements referring to the chains
+ * of a network. Deleting is preceded by adding, which is a no-op for
+ * existing elements, so that it never fails on missing ones. */
+static int
+networkNftablesUpdateElements(virFirewall *fw,
+                              const networkNftablesFamily *family,
+                              virNetworkDef *def,
+                              bool remove)
+{
+    g_autofree char *bridge = networkNftablesQuoteIfname(def->bridge);
+    g_autofree char *cross = g_strdup_printf("%s . %s", bridge, bridge);
+    g_autofree char *nat = networkNftablesChainName(def->bridge, "nat");
+    virNetworkIPDef *ipdef;
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS(networkNftablesBridgeMaps); i++) {
+        const char *map = networkNftablesBridgeMaps[i][0];
+        g_autofree char *chain = NULL;
+
+        chain = networkNftablesChainName(def->bridge,
+                                         networkNftablesBridgeMaps[i][1]);
+
+        networkNftablesAddElement(fw, family, "add", map, bridge, chain);
+        if (remove)
+            networkNftablesAddElement(fw, family, "delete", map, bridge, NULL);
+    }
+
+    networkNftablesAddElement(fw, family, "add", "cross", cross, NULL);
+    if (remove)
+        networkNftablesAddElement(fw, family, "delete", "cross", cross, NULL);
+
+    for (i = 0;
+         (ipdef = virNetworkDefGetIPByIndex(def, family->af, i));
+         i++) {
+        g_autofree char *network = NULL;
+
+        if (!networkNftablesIsMasqueraded(def, ipdef))
+            continue;
+
+        if (!(network = networkNftablesFormatNetwork(def, ipdef)))
+            return -1;
+
+        networkNftablesAddElement(fw, family, "add", "nat_map", network, nat);
+        if (remove)
+            networkNftablesAddElement(fw, family, "delete", "nat_map", network, NULL);
+    }
+
+    return 0;
+}
+
+
+static int
+networkNftablesAddNetwork(virFirewall *fw,
+                          const networkNftablesFamily *family,
+                          virNetworkDef *def)
+{
+    virNetworkIPDef *ipdef;
+    bool masquerading = false;
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS(networkNftablesChains); i++) {
+        g_autofree char *chain = networkNftablesChainName(def->bridge,
+                                                          networkNftablesChains[i]);
+
+        virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                           "add", "chain", family->name, NFTABLES_TABLE, chain,
+                           NULL);
+        virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                           "flush", "chain", family->name, NFTABLES_TABLE, chain,
+                           NULL);
+    }
+
+    networkNftablesAddServiceRules(fw, family, def);
+
+    for (i = 0;
+         networkNftablesIsForwarded(def) &&
+         (ipdef = virNetworkDefGetIPByIndex(def, family->af, i));
+         i++) {
+        g_autofree char *network = NULL;
+
+        if (!(network = networkNftablesFormatNetwork(def, ipdef)))
+            return -1;
+
+        networkNftablesAddForwardRules(fw, family, def, ipdef, network);
+
+        if (networkNftablesIsMasqueraded(def, ipdef)) {
+            if (networkNftablesAddNATRules(fw, family, def, network,
+                                           !masquerading) < 0)
+                return -1;
+            masquerading = true;
+        }
+    }
+
+    /* Catch all rules to block forwarding to/from bridges */
+    virFirewallRuleAddArg(fw, networkNftablesAddRule(fw, family, def, "fwd_in"),
+                          "reject");
+    virFirewallRuleAddArg(fw, networkNftablesAddRule(fw, family, def, "fwd_out"),
+                          "reject");
+
+    return networkNftablesUpdateElements(fw, family, def, false);
+}
+
+
+static int
+networkNftablesRemoveNetwork(virFirewall *fw,
+                             const networkNftablesFamily *family,
+                             virNetworkDef *def)
+{
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS(networkNftablesChains); i++) {
+        g_autofree char *chain = networkNftablesChainName(def->bridge,
+                                                          networkNftablesChains[i]);
+
+        virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                           "add", "chain", family->name, NFTABLES_TABLE, chain,
+                           NULL);
+    }
+
+    if (networkNftablesUpdateElements(fw, family, def, true) < 0)
+        return -1;
+
+    for (i = 0; i < G_N_ELEMENTS(networkNftablesChains); i++) {
+        g_autofree char *chain = networkNftablesChainName(def->bridge,
+                                                          networkNftablesChains[i]);
+
+        virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                           "flush", "chain", family->name, NFTABLES_TABLE, chain,
+                           NULL);
+        virFirewallAddRule(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                           "delete", "chain", family->name, NFTABLES_TABLE, chain,
+                           NULL);
+    }
+
+    return 0;
+}
+
+
+/* Queues the removal of the network passed in @opaque from the tables
+ * listed in @lines. Tables which don't exist are not created just to
+ * delete nothing from them, since that would hook their base chains. */
+static int
+networkNftablesRemoveRulesQuery(virFirewall *fw,
+                                virFirewallLayer layer G_GNUC_UNUSED,
+                                const char *const *lines,
+                                void *opaque)
+{
+    virNetworkDef *def = opaque;
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS(networkNftablesFamilies); i++) {
+        const networkNftablesFamily *family = &networkNftablesFamilies[i];
+        g_autofree char *table = NULL;
+
+        if (!networkNftablesHasFamily(def, family))
+            continue;
+
+        table = g_strdup_printf("table %s %s", family->name, NFTABLES_TABLE);
+        if (!g_strv_contains(lines, table)) {
+            VIR_DEBUG("No %s table, nothing to remove for '%s'",
+                      family->name, def->bridge);
+            continue;
+        }
+
+        if (networkNftablesRemoveNetwork(fw, family, def) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+
+static void
+networkNftablesRemoveRules(virFirewall *fw,
+                           virNetworkDef *def)
+{
+    virFirewallAddRuleFull(fw, VIR_FIREWALL_LAYER_NFTABLES,
+                           true, networkNftablesRemoveRulesQuery, def,
+                           "list", "tables", NULL);
+}
+
+
+/**
+ * networkNftablesAddFirewallRules:
+ * @def: the network definition
+ *
+ * Creates the chains of the network @def, fills them with its rules
+ * and hooks them up to the shared tables, creating those if needed.
+ * With nft being able to apply them in a batch, all of it takes a
+ * single atomic transaction.
+ *
+ * Returns 0 on success, -1 on failure.
+ */
+int
+networkNftablesAddFirewallRules(virNetworkDef *def)
+{
+    g_autoptr(virFirewall) fw = virFirewallNew();
+    size_t i;
+
+    virFirewallStartTransaction(fw, 0);
+
+    for (i = 0; i < G_N_ELEMENTS(networkNftablesFamilies); i++) {
+        const networkNftablesFamily *family = &networkNftablesFamilies[i];
+
+        if (!networkNftablesHasFamily(def, family))
+            continue;
+
+        networkNftablesAddTable(fw, family);
+        networkNftablesAddDispatchRules(fw, family);
+        if (networkNftablesAddNetwork(fw, family, def) < 0)
+            return -1;
+    }
+
+    virFirewallStartRollback(fw, 0);
+
+    networkNftablesRemoveRules(fw, def);
+
+    return virFirewallApply(fw);
+}
+
+
+/**
+ * networkNftablesRemoveFirewallRules:
+ * @def: the network definition
+ *
+ * Unhooks and deletes all chains of the network @def, leaving the
+ * shared tables and the other networks alone.
+ */
+void
+networkNftablesRemoveFirewallRules(virNetworkDef *def)
+{
+    g_autoptr(virFirewall) fw = virFirewallNew();
+
+    virFirewallStartTransaction(fw, 0);
+
+    networkNftablesRemoveRules(fw, def);
+
+    virFirewallApply(fw);
+}
@@ -29,6 +29,8 @@
 #include "domain_conf.h"
 #include "virerror.h"
 #include "nwfilter_gentech_driver.h"
+#define LIBVIRT_NWFILTER_GENTECH_DRIVER_PRIV_H_ALLOW
+#include "nwfilter_gentech_driver_priv.h"
 #include "nwfilter_ebiptables_driver.h"
 #include "nwfilter_dhcpsnoop.h"
 #include "nwfilter_ipaddrmap.h"
@@ -71,6 +73,56 @@ static virNWFilterTechDriver *filter_tech_drivers[] = {
  */
 static virMutex updateMutex;
 
+
+/* A filter expanded into the flat list of rules of itself and all of
+ * its subfilters, in the order they get instantiated. The expansion
+ * does not depend on the variables of a binding, so it is computed
+ * once per filter and reused by every interface referencing it. The
+ * program holds private copies of the filter definitions, so it stays
+ * usable even if the filters get redefined meanwhile.
+ */
+typedef struct _virNWFilterProgramRule virNWFilterProgramRule;
+struct _virNWFilterProgramRule {
+    virNWFilterDef *def;        /* filter containing the rule */
+    virNWFilterRuleDef *rule;
+    GHashTable *vars;           /* parameters set by the including filters,
+                                   shared among the rules of one filter */
+};
+
+struct _virNWFilterProgram {
+    virNWFilterDef **defs;
+    size_t ndefs;
+    virNWFilterProgramRule *rules;
+    size_t nrules;
+};
+
+/* Filter name -> virNWFilterProgram. Protected by updateMutex and
+ * dropped as a whole when the generation of the filter list changes. */
+static GHashTable *programs;
+static unsigned int programsGeneration;
+
+
+static void
+virNWFilterProgramFree(void *opaque)
+{
+    virNWFilterProgram *prog = opaque;
+    size_t i;
+
+    if (!prog)
+        return;
+
+    for (i = 0; i < prog->nrules; i++)
+        virHashFree(prog->rules[i].vars);
+    g_free(prog->rules);
+
+    for (i = 0; i < prog->ndefs; i++)
+        virNWFilterDefFree(prog->defs[i]);
+    g_free(prog->defs);
+
+    g_free(prog);
+}
+
+
 int virNWFilterTechDriversInit(bool privileged)
 {
     size_t i = 0;
@@ -78,6 +130,8 @@ int virNWFilterTechDriversInit(bool privileged)
     if (virMutexInitRecursive(&updateMutex) < 0)
         return -1;
 
+    programs = virHashNew(virNWFilterProgramFree);
+
     while (filter_tech_drivers[i]) {
         if (!(filter_tech_drivers[i]->flags & TECHDRV_FLAG_INITIALIZED))
             filter_tech_drivers[i]->init(privileged);
@@ -95,6 +149,7 @@ void virNWFilterTechDriversShutdown(void)
             filter_tech_drivers[i]->shutdown();
         i++;
     }
+    g_clear_pointer(&programs, g_hash_table_unref);
     virMutexDestroy(&updateMutex);
 }
 
@@ -401,6 +456,45 @@ virNWFilterDefToInst(virNWFilterDriverState *driver,
 }
 
 
+/**
+ * virNWFilterRuleDetermineMissingVars:
+ * @rule: the rule to check
+ * @vars: variables available to the rule
+ * @missing_vars: hash table to add the names of missing variables to
+ *
+ * Returns 0 on success, -1 on error
+ */
+static int
+virNWFilterRuleDetermineMissingVars(virNWFilterRuleDef *rule,
+                                    GHashTable *vars,
+                                    GHashTable *missing_vars)
+{
+    size_t i;
+
+    for (i = 0; i < rule->nVarAccess; i++) {
+        g_autofree char *varAccess = NULL;
+        g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+        virNWFilterVarValue *val;
+
+        if (virNWFilterVarAccessIsAvailable(rule->varAccess[i], vars))
+            continue;
+
+        virNWFilterVarAccessPrint(rule->varAccess[i], &buf);
+
+        if (!(val = virNWFilterVarValueCreateSimpleCopyValue("1")))
+            return -1;
+
+        varAccess = virBufferContentAndReset(&buf);
+        if (virHashUpdateEntry(missing_vars, varAccess, val) < 0) {
+            virNWFilterVarValueFree(val);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
 static int
 virNWFilterDetermineMissingVarsRec(virNWFilterDef *filter,
                                    GHashTable *vars,
@@ -410,35 +504,17 @@ virNWFilterDetermineMissingVarsRec(virNWFilterDef *filter,
 {
     virNWFilterObj *obj;
     int rc = 0;
-    size_t i, j;
+    size_t i;
     virNWFilterDef *next_filter;
     virNWFilterDef *newNext_filter;
-    virNWFilterVarValue *val;
 
     for (i = 0; i < filter->nentries; i++) {
         virNWFilterRuleDef *   rule = filter->filterEntries[i]->rule;
         virNWFilterIncludeDef *inc  = filter->filterEntries[i]->include;
         if (rule) {
-            /* check all variables of this rule */
-            for (j = 0; j < rule->nVarAccess; j++) {
-                if (!virNWFilterVarAccessIsAvailable(rule->varAccess[j],
-                                                     vars)) {
-                    g_autofree char *varAccess = NULL;
-                    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
-
-                    virNWFilterVarAccessPrint(rule->varAccess[j], &buf);
-
-                    if (!(val = virNWFilterVarValueCreateSimpleCopyValue("1")))
-                        return -1;
-
-                    varAccess = virBufferContentAndReset(&buf);
-                    rc = virHashUpdateEntry(missing_vars, varAccess, val);
-                    if (rc < 0) {
-                        virNWFilterVarValueFree(val);
-                        return -1;
-                    }
-                }
-            }
+            if (virNWFilterRuleDetermineMissingVars(rule, vars,
+                                                    missing_vars) < 0)
+                return -1;
         } else if (inc) {
             g_autoptr(GHashTable) tmpvars = NULL;
 
@@ -479,6 +555,190 @@ virNWFilterDetermineMissingVarsRec(virNWFilterDef *filter,
 }
 
 
+/**
+ * virNWFilterProgramCopyDef:
+ * @prog: the program to take ownership of the copy
+ * @def: the filter definition to copy
+ *
+ * Returns a private copy of @def owned by @prog or NULL on error.
+ */
+static virNWFilterDef *
+virNWFilterProgramCopyDef(virNWFilterProgram *prog,
+                          virNWFilterDef *def)
+{
+    g_autofree char *xml = NULL;
+    virNWFilterDef *copy;
+
+    if (!(xml = virNWFilterDefFormat(def)) ||
+        !(copy = virNWFilterDefParseString(xml)))
+        return NULL;
+
+    if (VIR_APPEND_ELEMENT_COPY(prog->defs, prog->ndefs, copy) < 0) {
+        virNWFilterDefFree(copy);
+        return NULL;
+    }
+
+    return copy;
+}
+
+
+static int
+virNWFilterProgramCompileRec(virNWFilterDriverState *driver,
+                             virNWFilterProgram *prog,
+                             virNWFilterDef *def,
+                             GHashTable *vars)
+{
+    size_t i;
+
+    for (i = 0; i < def->nentries; i++) {
+        virNWFilterRuleDef *rule = def->filterEntries[i]->rule;
+        virNWFilterIncludeDef *inc = def->filterEntries[i]->include;
+
+        if (rule) {
+            virNWFilterProgramRule progrule = {
+                .def = def,
+                .rule = rule,
+                .vars = g_hash_table_ref(vars),
+            };
+
+            if (VIR_APPEND_ELEMENT(prog->rules, prog->nrules, progrule) < 0) {
+                virHashFree(progrule.vars);
+                return -1;
+            }
+        } else if (inc) {
+            g_autoptr(GHashTable) tmpvars = NULL;
+            virNWFilterObj *obj;
+            virNWFilterDef *childdef;
+
+            VIR_DEBUG("Compiling filter %s", inc->filterref);
+            if (!(obj = virNWFilterObjListFindInstantiateFilter(driver->nwfilters,
+                                                                inc->filterref)))
+                return -1;
+
+            childdef = virNWFilterProgramCopyDef(prog,
+                                                 virNWFilterObjGetDef(obj));
+            virNWFilterObjUnlock(obj);
+            if (!childdef)
+                return -1;
+
+            /* the variables of the including filter take precedence */
+            if (!(tmpvars = virNWFilterCreateVarsFrom(inc->params, vars)))
+                return -1;
+
+            if (virNWFilterProgramCompileRec(driver, prog, childdef, tmpvars) < 0)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * virNWFilterProgramGet:
+ * @driver: the driver state pointer
+ * @filter: the filter to get the program of
+ *
+ * Looks up the program of @filter, compiling it if there is no
+ * current one yet. The returned program is owned by the cache and
+ * stays valid as long as updateMutex is held.
+ *
+ * Returns the program or NULL on error.
+ */
+virNWFilterProgram *
+virNWFilterProgramGet(virNWFilterDriverState *driver,
+                      virNWFilterDef *filter)
+{
+    unsigned int generation;
+    virNWFilterProgram *prog;
+    virNWFilterDef *def;
+    g_autoptr(GHashTable) vars = NULL;
+
+    /* read before the definitions get copied, so that a concurrent
+     * change of a filter invalidates the program compiled here */
+    generation = virNWFilterObjListGetGeneration(driver->nwfilters);
+    if (generation != programsGeneration) {
+        virHashRemoveAll(programs);
+        programsGeneration = generation;
+    }
+
+    if ((prog = virHashLookup(programs, filter->name)))
+        return prog;
+
+    VIR_DEBUG("Compiling filter %s", filter->name);
+    prog = g_new0(virNWFilterProgram, 1);
+    vars = virHashNew(virNWFilterVarValueHashFree);
+
+    if (!(def = virNWFilterProgramCopyDef(prog, filter)) ||
+        virNWFilterProgramCompileRec(driver, prog, def, vars) < 0 ||
+        virHashAddEntry(programs, filter->name, prog) < 0) {
+        virNWFilterProgramFree(prog);
+        return NULL;
+    }
+
+    return prog;
+}
+
+
+/**
+ * virNWFilterProgramToRuleInsts:
+ * @prog: the program to instantiate
+ * @vars: the variables of the binding
+ * @rules: array to append the rule instances to
+ * @nrules: number of elements in @rules
+ *
+ * Substitutes @vars into the rules of @prog, where @vars override the
+ * parameters passed by including filters. The rule instances refer to
+ * the definitions held by @prog.
+ *
+ * Returns 0 on success, -1 on error with @rules cleared
+ */
+int
+virNWFilterProgramToRuleInsts(virNWFilterProgram *prog,
+                              GHashTable *vars,
+                              virNWFilterRuleInst ***rules,
+                              size_t *nrules)
+{
+    g_autoptr(GHashTable) rulevars = NULL;
+    GHashTable *incvars = NULL;
+    size_t i;
+
+    for (i = 0; i < prog->nrules; i++) {
+        virNWFilterProgramRule *progrule = &prog->rules[i];
+        virNWFilterRuleInst *ruleinst;
+
+        /* consecutive rules of the same filter share their variables */
+        if (!rulevars || progrule->vars != incvars) {
+            g_clear_pointer(&rulevars, g_hash_table_unref);
+            if (!(rulevars = virNWFilterCreateVarsFrom(progrule->vars, vars)))
+                goto error;
+            incvars = progrule->vars;
+        }
+
+        ruleinst = g_new0(virNWFilterRuleInst, 1);
+        ruleinst->chainSuffix = progrule->def->chainsuffix;
+        ruleinst->chainPriority = progrule->def->chainPriority;
+        ruleinst->def = progrule->rule;
+        ruleinst->priority = progrule->rule->priority;
+        ruleinst->vars = g_hash_table_ref(rulevars);
+
+        if (VIR_APPEND_ELEMENT(*rules, *nrules, ruleinst) < 0) {
+            virNWFilterRuleInstFree(ruleinst);
+            goto error;
+        }
+    }
+
+    return 0;
+
+ error:
+    for (i = 0; i < *nrules; i++)
+        virNWFilterRuleInstFree((*rules)[i]);
+    g_clear_pointer(rules, g_free);
+    *nrules = 0;
+    return -1;
+}
+
+
 /**
  * virNWFilterDoInstantiate:
  * @techdriver: The driver to use for instantiation
@@ -492,7 +752,9 @@ virNWFilterDetermineMissingVarsRec(virNWFilterDef *filter,
  * Instantiate a filter by instantiating the filter itself along with
  * all its subfilters in a depth-first traversal of the tree of referenced
  * filters. The name of the interface to which the rules belong must be
- * provided. Apply the values of variables as needed.
+ * provided. Apply the values of variables as needed. Unless following
+ * updated filter definitions, the tree is not traversed again but taken
+ * from the filter's cached program.
  *
  * Call this function while holding the NWFilter filter update lock
  */
@@ -524,13 +786,39 @@ virNWFilterDoInstantiate(virNWFilterTechDriver *techdriver,
         goto error;
     }
 
-    rc = virNWFilterDetermineMissingVarsRec(filter,
-                                            binding->filterparams,
-                                            missing_vars,
-                                            useNewFilter,
-                                            driver);
-    if (rc < 0)
-        goto error;
+    switch (useNewFilter) {
+    case INSTANTIATE_FOLLOW_NEWFILTER:
+        rc = virNWFilterDetermineMissingVarsRec(filter,
+                                                binding->filterparams,
+                                                missing_vars,
+                                                useNewFilter,
+                                                driver);
+        if (rc < 0)
+            goto error;
+        break;
+
+    case INSTANTIATE_ALWAYS: {
+        virNWFilterProgram *prog;
+        size_t i;
+
+        if (!(prog = virNWFilterProgramGet(driver, filter)) ||
+            virNWFilterProgramToRuleInsts(prog, binding->filterparams,
+                                          &inst.rules, &inst.nrules) < 0) {
+            rc = -1;
+            goto error;
+        }
+
+        for (i = 0; i < inst.nrules; i++) {
+            if (virNWFilterRuleDetermineMissingVars(inst.rules[i]->def,
+                                                    inst.rules[i]->vars,
+                                                    missing_vars) < 0) {
+                rc = -1;
+                goto error;
+            }
+        }
+        break;
+    }
+    }
 
     lv = virHashLookup(binding->filterparams, NWFILTER_VARNAME_CTRL_IP_LEARNING);
     if (lv)
@@ -580,20 +868,20 @@ virNWFilterDoInstantiate(virNWFilterTechDriver *techdriver,
         goto error;
     }
 
-    rc = virNWFilterDefToInst(driver,
-                              filter,
-                              binding->filterparams,
-                              useNewFilter, foundNewFilter,
-                              &inst);
-
-    if (rc < 0)
-        goto error;
-
     switch (useNewFilter) {
     case INSTANTIATE_FOLLOW_NEWFILTER:
+        rc = virNWFilterDefToInst(driver,
+                                  filter,
+                                  binding->filterparams,
+                                  useNewFilter, foundNewFilter,
+                                  &inst);
+        if (rc < 0)
+            goto error;
+
         instantiate = *foundNewFilter;
         break;
     case INSTANTIATE_ALWAYS:
+        /* already expanded from the filter's program */
         instantiate = true;
         break;
     }
@@ -71,6 +71,9 @@ VIR_LOG_INIT("qemu.qemu_conf");
 #define QEMU_MIGRATION_PORT_MIN 49152
 #define QEMU_MIGRATION_PORT_MAX 49215
 
+/* QEMU limits multifd-channels to 255 */
+#define QEMU_SAVE_PARALLEL_CHANNELS_MAX 255
+
 static virClass *virQEMUDriverConfigClass;
 static void virQEMUDriverConfigDispose(void *obj);
 
@@ -277,6 +280,9 @@ virQEMUDriverConfig *virQEMUDriverConfigNew(bool privileged,
 
     cfg->keepAliveInterval = 5;
     cfg->keepAliveCount = 5;
+
+    cfg->statsCacheMaxAge = 1000;
+
     cfg->seccompSandbox = -1;
 
     cfg->logTimestamp = true;
@@ -621,8 +627,18 @@ virQEMUDriverConfigLoadSaveEntry(virQEMUDriverConfig *cfg,
         return -1;
     if (virConfGetValueString(conf, "snapshot_image_format", &cfg->snapshotImageFormat) < 0)
         return -1;
+    if (virConfGetValueUInt(conf, "save_image_parallel_channels", &cfg->saveImageParallelChannels) < 0)
+        return -1;
+    if (cfg->saveImageParallelChannels > QEMU_SAVE_PARALLEL_CHANNELS_MAX) {
+        virReportError(VIR_ERR_CONF_SYNTAX,
+                       _("save_image_parallel_channels must not be greater than %d"),
+                       QEMU_SAVE_PARALLEL_CHANNELS_MAX);
+        return -1;
+    }
     if (virConfGetValueString(conf, "auto_dump_path", &cfg->autoDumpPath) < 0)
         return -1;
+    if (virConfGetValueBool(conf, "save_image_bypass_cache", &cfg->saveImageBypassCache) < 0)
+        return -1;
     if (virConfGetValueBool(conf, "auto_dump_bypass_cache", &cfg->autoDumpBypassCache) < 0)
         return -1;
     if (virConfGetValueBool(conf, "auto_start_bypass_cache", &cfg->autoStartBypassCache) < 0)
@@ -752,6 +768,12 @@ virQEMUDriverConfigLoadRPCEntry(virQEMUDriverConfig *cfg,
 {
     if (virConfGetValueUInt(conf, "max_queued", &cfg->maxQueuedJobs) < 0)
         return -1;
+    if (virConfGetValueUInt(conf, "stats_workers", &cfg->statsWorkers) < 0)
+        return -1;
+    if (virConfGetValueUInt(conf, "stats_cache_max_age", &cfg->statsCacheMaxAge) < 0)
+        return -1;
+    if (virConfGetValueUInt(conf, "reconnect_workers", &cfg->reconnectWorkers) < 0)
+        return -1;
     if (virConfGetValueInt(conf, "keepalive_interval", &cfg->keepAliveInterval) < 0)
         return -1;
     if (virConfGetValueUInt(conf, "keepalive_count", &cfg->keepAliveCount) < 0)
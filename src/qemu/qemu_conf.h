@@ -181,6 +181,9 @@ struct _virQEMUDriverConfig {
     bool dumpGuestCore;
 
     unsigned int maxQueuedJobs;
+    unsigned int statsWorkers;
+    unsigned int statsCacheMaxAge;
+    unsigned int reconnectWorkers;
 
     char **securityDriverNames;
     bool securityDefaultConfined;
@@ -189,6 +192,8 @@ struct _virQEMUDriverConfig {
     char *saveImageFormat;
     char *dumpImageFormat;
     char *snapshotImageFormat;
+    unsigned int saveImageParallelChannels;
+    bool saveImageBypassCache;
 
     char *autoDumpPath;
     bool autoDumpBypassCache;
@@ -1880,6 +1880,8 @@ qemuDomainObjPrivateDataClear(qemuDomainObjPrivate *priv)
         g_slist_free_full(g_steal_pointer(&priv->dbusVMStateIds), g_free);
 
     priv->dbusVMState = false;
+
+    qemuDomainStatsCacheClear(priv);
 }
 
 
@@ -7734,6 +7736,64 @@ qemuDomainDetermineDiskChain(virQEMUDriver *driver,
 }
 
 
+/**
+ * qemuDomainPrefetchDiskChains:
+ * @driver: qemu driver data
+ * @vm: domain object
+ *
+ * Reads the local images of backing chains which qemuDomainDetermineDiskChain
+ * would have to detect for disks of @vm concurrently, so that the detection
+ * itself uses cached image headers rather than reading one layer of one
+ * disk at a time.
+ */
+void
+qemuDomainPrefetchDiskChains(virQEMUDriver *driver,
+                             virDomainObj *vm)
+{
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    g_autofree virStorageSourceMetadataRequest *reqs = NULL;
+    size_t nreqs = 0;
+    size_t i;
+
+    for (i = 0; i < vm->def->ndisks; i++) {
+        virDomainDiskDef *disk = vm->def->disks[i];
+        virStorageSourceMetadataRequest req = { 0 };
+        virStorageSource *src = disk->src;
+
+        if (virStorageSourceIsEmpty(src))
+            continue;
+
+        if (virStorageSourceIsLocalStorage(src) &&
+            src->format > VIR_STORAGE_FILE_NONE &&
+            src->format < VIR_STORAGE_FILE_BACKING)
+            continue;
+
+        while (virStorageSourceHasBacking(src))
+            src = src->backingStore;
+
+        /* chain is terminated, nothing to detect */
+        if (src->backingStore)
+            continue;
+
+        /* only headers of local images are cached, prefetching anything
+         * else would just read it twice */
+        if (!virStorageSourceIsLocalStorage(src))
+            continue;
+
+        req.src = src;
+        qemuDomainGetImageIds(cfg, vm, src, disk->src, &req.uid, &req.gid);
+        ignore_value(VIR_APPEND_ELEMENT(reqs, nreqs, req));
+    }
+
+    /* a single chain is read by qemuDomainDetermineDiskChain just as fast */
+    if (nreqs < 2)
+        return;
+
+    virStorageSourcePrefetchMetadata(reqs, nreqs,
+                                     QEMU_DOMAIN_STORAGE_SOURCE_CHAIN_MAX_DEPTH);
+}
+
+
 /**
  * qemuDomainDiskGetTopNodename:
  *
@@ -11099,6 +11159,26 @@ qemuDomainStorageIdNew(qemuDomainObjPrivate *priv)
 }
 
 
+/**
+ * qemuDomainStatsCacheClear:
+ * @priv: qemu VM private data object.
+ *
+ * Drops the cached bulk stats of the VM, e.g. when it is shut off.
+ */
+void
+qemuDomainStatsCacheClear(qemuDomainObjPrivate *priv)
+{
+    size_t i;
+
+    for (i = 0; i < priv->nstatsCache; i++)
+        virTypedParamsFree(priv->statsCache[i].params,
+                           priv->statsCache[i].nparams);
+
+    g_clear_pointer(&priv->statsCache, g_free);
+    priv->nstatsCache = 0;
+}
+
+
 /**
  * qemuDomainStorageIdReset:
  * @priv: qemu VM private data object.
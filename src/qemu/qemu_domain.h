@@ -124,6 +124,15 @@ struct _qemuDomainSecretInfo {
     } s;
 };
 
+typedef struct _qemuDomainStatsCacheEntry qemuDomainStatsCacheEntry;
+struct _qemuDomainStatsCacheEntry {
+    unsigned int stats; /* the VIR_DOMAIN_STATS_* group */
+    unsigned int privflags; /* flags the group was gathered with */
+    long long timestamp; /* monotonic time of gathering in ms */
+    virTypedParameterPtr params;
+    size_t nparams;
+};
+
 typedef struct _qemuDomainObjPrivate qemuDomainObjPrivate;
 struct _qemuDomainObjPrivate {
     virQEMUDriver *driver;
@@ -258,6 +267,10 @@ struct _qemuDomainObjPrivate {
     GSList *dbusVMStateIds;
     /* true if -object dbus-vmstate was added */
     bool dbusVMState;
+
+    /* snapshot of the most recently gathered bulk stats per group */
+    qemuDomainStatsCacheEntry *statsCache;
+    size_t nstatsCache;
 };
 
 #define QEMU_DOMAIN_PRIVATE(vm) \
@@ -682,6 +695,9 @@ int qemuDomainDetermineDiskChain(virQEMUDriver *driver,
                                  virStorageSource *disksrc,
                                  bool report_broken);
 
+void qemuDomainPrefetchDiskChains(virQEMUDriver *driver,
+                                  virDomainObj *vm);
+
 bool qemuDomainDiskChangeSupported(virDomainDiskDef *disk,
                                    virDomainDiskDef *orig_disk);
 
@@ -988,6 +1004,8 @@ bool qemuDomainDefHasManagedPR(virDomainObj *vm);
 unsigned int qemuDomainStorageIdNew(qemuDomainObjPrivate *priv);
 void qemuDomainStorageIdReset(qemuDomainObjPrivate *priv);
 
+void qemuDomainStatsCacheClear(qemuDomainObjPrivate *priv);
+
 virDomainEventResumedDetailType
 qemuDomainRunningReasonToResumeEvent(virDomainRunningReason reason);
 
@@ -763,6 +763,25 @@ qemuDomainObjReleaseAsyncJob(virDomainObj *obj)
     priv->job.asyncOwner = 0;
 }
 
+/**
+ * qemuDomainObjTransferJob:
+ * @obj: domain object
+ *
+ * Makes the calling thread the owner of the active job of @obj, which was
+ * acquired by another thread and handed over to this one.
+ */
+void
+qemuDomainObjTransferJob(virDomainObj *obj)
+{
+    qemuDomainObjPrivate *priv = obj->privateData;
+
+    VIR_DEBUG("Transferring ownership of '%s' job from thread %llu",
+              qemuDomainJobTypeToString(priv->job.active),
+              priv->job.owner);
+
+    priv->job.owner = virThreadSelfID();
+}
+
 static bool
 qemuDomainNestedJobAllowed(qemuDomainJobObj *jobs, qemuDomainJob newJob)
 {
@@ -253,6 +253,7 @@ int qemuDomainObjRestoreJob(virDomainObj *obj,
 void qemuDomainObjDiscardAsyncJob(virQEMUDriver *driver,
                                   virDomainObj *obj);
 void qemuDomainObjReleaseAsyncJob(virDomainObj *obj);
+void qemuDomainObjTransferJob(virDomainObj *obj);
 
 int qemuDomainJobInfoUpdateTime(qemuDomainJobInfo *jobInfo)
     ATTRIBUTE_NONNULL(1);
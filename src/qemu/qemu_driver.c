@@ -33,6 +33,8 @@
 #include <sys/ioctl.h>
 
 #include "qemu_driver.h"
+#define LIBVIRT_QEMU_DRIVERPRIV_H_ALLOW
+#include "qemu_driverpriv.h"
 #include "qemu_agent.h"
 #include "qemu_alias.h"
 #include "qemu_block.h"
@@ -1792,7 +1794,7 @@ static virDomainPtr qemuDomainCreateXML(virConnectPtr conn,
     }
 
     if (qemuProcessStart(conn, driver, vm, NULL, QEMU_ASYNC_JOB_START,
-                         NULL, -1, NULL, NULL,
+                         NULL, -1, NULL, NULL, NULL,
                          VIR_NETDEV_VPORT_PROFILE_OP_CREATE,
                          start_flags) < 0) {
         virDomainAuditStart(vm, "booted", false);
@@ -3031,6 +3033,7 @@ qemuDomainManagedSaveLoad(virDomainObj *vm,
         goto cleanup;
 
     vm->hasManagedSave = virFileExists(name);
+    virDomainObjPublishSummary(vm);
 
     ret = 0;
  cleanup:
@@ -6608,7 +6611,7 @@ qemuDomainObjStart(virConnectPtr conn,
     }
 
     ret = qemuProcessStart(conn, driver, vm, NULL, asyncJob,
-                           NULL, -1, NULL, NULL,
+                           NULL, -1, NULL, NULL, NULL,
                            VIR_NETDEV_VPORT_PROFILE_OP_CREATE, start_flags);
     virDomainAuditStart(vm, "booted", ret >= 0);
     if (ret >= 0) {
@@ -17548,14 +17551,6 @@ qemuDomainGetStatsState(virQEMUDriver *driver G_GNUC_UNUSED,
 }
 
 
-typedef enum {
-    QEMU_DOMAIN_STATS_HAVE_JOB = 1 << 0, /* job is entered, monitor can be
-                                            accessed */
-    QEMU_DOMAIN_STATS_BACKING  = 1 << 1, /* include backing chain in
-                                            block stats */
-} qemuDomainStatsFlags;
-
-
 #define HAVE_JOB(flags) ((flags) & QEMU_DOMAIN_STATS_HAVE_JOB)
 
 
@@ -17845,11 +17840,10 @@ qemuDomainGetStatsCpuCgroup(virDomainObj *dom,
     if (!priv->cgroup)
         return 0;
 
-    err = virCgroupGetCpuacctUsage(priv->cgroup, &cpu_time);
+    err = virCgroupGetCpuacctTimes(priv->cgroup, &cpu_time,
+                                   &user_time, &sys_time);
     if (!err && virTypedParamListAddULLong(params, cpu_time, "cpu.time") < 0)
         return -1;
-
-    err = virCgroupGetCpuacctStat(priv->cgroup, &user_time, &sys_time);
     if (!err && virTypedParamListAddULLong(params, user_time, "cpu.user") < 0)
         return -1;
     if (!err && virTypedParamListAddULLong(params, sys_time, "cpu.system") < 0)
@@ -18682,25 +18676,161 @@ qemuDomainGetStatsNeedMonitor(unsigned int stats)
 }
 
 
-static int
+static qemuDomainStatsCacheEntry *
+qemuDomainStatsCacheLookup(qemuDomainObjPrivate *priv,
+                           unsigned int stats)
+{
+    size_t i;
+
+    for (i = 0; i < priv->nstatsCache; i++) {
+        if (priv->statsCache[i].stats == stats)
+            return &priv->statsCache[i];
+    }
+
+    return NULL;
+}
+
+
+/**
+ * qemuDomainStatsCacheGetFresh:
+ *
+ * Returns the cache entry of @worker's stats group if it was gathered
+ * at most @maxAge ms before @now and is at least as complete as what
+ * a call with @privflags would produce, NULL otherwise.
+ */
+static qemuDomainStatsCacheEntry *
+qemuDomainStatsCacheGetFresh(virDomainObj *vm,
+                             struct qemuDomainGetStatsWorker *worker,
+                             unsigned int privflags,
+                             long long now,
+                             unsigned int maxAge)
+{
+    qemuDomainStatsCacheEntry *entry;
+
+    if (!(entry = qemuDomainStatsCacheLookup(vm->privateData, worker->stats)))
+        return NULL;
+
+    if (now - entry->timestamp > maxAge)
+        return NULL;
+
+    if ((entry->privflags ^ privflags) & QEMU_DOMAIN_STATS_BACKING)
+        return NULL;
+
+    if (worker->monitor && HAVE_JOB(privflags) && !HAVE_JOB(entry->privflags))
+        return NULL;
+
+    return entry;
+}
+
+
+static void
+qemuDomainStatsCacheUpdate(virDomainObj *vm,
+                           struct qemuDomainGetStatsWorker *worker,
+                           unsigned int privflags,
+                           long long now,
+                           virTypedParameterPtr params,
+                           size_t nparams)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    qemuDomainStatsCacheEntry *entry;
+
+    /* Don't replace complete data by what was gathered without a job */
+    if (worker->monitor && !HAVE_JOB(privflags))
+        return;
+
+    if (!(entry = qemuDomainStatsCacheLookup(priv, worker->stats))) {
+        VIR_EXPAND_N(priv->statsCache, priv->nstatsCache, 1);
+        entry = &priv->statsCache[priv->nstatsCache - 1];
+        entry->stats = worker->stats;
+    }
+
+    virTypedParamsFree(entry->params, entry->nparams);
+    ignore_value(virTypedParamsCopy(&entry->params, params, nparams));
+    entry->nparams = nparams;
+    entry->privflags = privflags & (QEMU_DOMAIN_STATS_HAVE_JOB |
+                                    QEMU_DOMAIN_STATS_BACKING);
+    entry->timestamp = now;
+}
+
+
+/**
+ * qemuDomainGetStatsCachedMonitor:
+ *
+ * Returns true if all the groups in @stats which need to talk to the
+ * monitor can be served from the cache of @vm, i.e. no job is needed.
+ */
+static bool
+qemuDomainGetStatsCachedMonitor(virDomainObj *vm,
+                                unsigned int stats,
+                                unsigned int privflags,
+                                long long now,
+                                unsigned int maxAge)
+{
+    size_t i;
+
+    for (i = 0; qemuDomainGetStatsWorkers[i].func; i++) {
+        struct qemuDomainGetStatsWorker *worker = &qemuDomainGetStatsWorkers[i];
+
+        if (!(stats & worker->stats) || !worker->monitor)
+            continue;
+
+        if (!qemuDomainStatsCacheGetFresh(vm, worker,
+                                          privflags | QEMU_DOMAIN_STATS_HAVE_JOB,
+                                          now, maxAge))
+            return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * qemuDomainGetStats:
+ *
+ * Gathers the requested @stats groups of @dom. If @flags contain
+ * QEMU_DOMAIN_STATS_CACHED and @maxAge is non-zero, groups gathered no
+ * more than @maxAge milliseconds before @now are reported from the cache
+ * in the domain private data and freshly gathered groups are remembered
+ * there. Callers not asking for cached stats never touch the cache.
+ */
+int
 qemuDomainGetStats(virConnectPtr conn,
                    virDomainObj *dom,
                    unsigned int stats,
                    virDomainStatsRecordPtr *record,
+                   long long now,
+                   unsigned int maxAge,
                    unsigned int flags)
 {
     g_autofree virDomainStatsRecordPtr tmp = NULL;
     g_autoptr(virTypedParamList) params = NULL;
+    bool useCache = maxAge > 0 && (flags & QEMU_DOMAIN_STATS_CACHED);
     size_t i;
 
     params = g_new0(virTypedParamList, 1);
 
     for (i = 0; qemuDomainGetStatsWorkers[i].func; i++) {
-        if (stats & qemuDomainGetStatsWorkers[i].stats) {
-            if (qemuDomainGetStatsWorkers[i].func(conn->privateData, dom, params,
-                                                  flags) < 0)
-                return -1;
+        struct qemuDomainGetStatsWorker *worker = &qemuDomainGetStatsWorkers[i];
+        qemuDomainStatsCacheEntry *entry;
+        size_t start = params->npar;
+
+        if (!(stats & worker->stats))
+            continue;
+
+        if (useCache &&
+            (entry = qemuDomainStatsCacheGetFresh(dom, worker, flags,
+                                                  now, maxAge))) {
+            virTypedParamListAddParams(params, entry->params, entry->nparams);
+            continue;
         }
+
+        if (worker->func(conn->privateData, dom, params, flags) < 0)
+            return -1;
+
+        if (useCache)
+            qemuDomainStatsCacheUpdate(dom, worker, flags, now,
+                                       params->par + start,
+                                       params->npar - start);
     }
 
     tmp = g_new0(virDomainStatsRecord, 1);
@@ -18715,6 +18845,174 @@ qemuDomainGetStats(virConnectPtr conn,
 }
 
 
+static int
+qemuConnectGetAllDomainStatsOne(virConnectPtr conn,
+                                virDomainObj *vm,
+                                unsigned int stats,
+                                unsigned int privflags,
+                                virDomainStatsRecordPtr *record,
+                                unsigned int maxAge,
+                                unsigned int flags)
+{
+    virQEMUDriver *driver = conn->privateData;
+    unsigned int domflags = 0;
+    long long now = g_get_monotonic_time() / 1000;
+    int ret = -1;
+
+    virObjectLock(vm);
+
+    if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING)
+        domflags |= QEMU_DOMAIN_STATS_BACKING;
+    if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_CACHED)
+        domflags |= QEMU_DOMAIN_STATS_CACHED;
+
+    /* no need to wait for the job if the monitor is not going to be used */
+    if (HAVE_JOB(privflags) && maxAge > 0 &&
+        (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_CACHED) &&
+        qemuDomainGetStatsCachedMonitor(vm, stats, domflags, now, maxAge))
+        privflags &= ~QEMU_DOMAIN_STATS_HAVE_JOB;
+
+    if (HAVE_JOB(privflags)) {
+        int rv;
+
+        if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT)
+            rv = qemuDomainObjBeginJobNowait(driver, vm, QEMU_JOB_QUERY);
+        else
+            rv = qemuDomainObjBeginJob(driver, vm, QEMU_JOB_QUERY);
+
+        if (rv == 0)
+            domflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
+    }
+    /* else: without a job it's still possible to gather some data */
+
+    if (qemuDomainGetStats(conn, vm, stats, record, now, maxAge, domflags) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    if (HAVE_JOB(domflags))
+        qemuDomainObjEndJob(driver, vm);
+
+    virObjectUnlock(vm);
+    return ret;
+}
+
+
+struct qemuConnectGetAllDomainStatsData {
+    virConnectPtr conn;
+    virDomainObj **vms;
+    size_t nvms;
+    unsigned int stats;
+    unsigned int privflags;
+    unsigned int maxAge;
+    unsigned int flags;
+
+    /* Slot i holds the record of vms[i] so that the caller can return
+     * them in the requested order regardless of completion order. */
+    virDomainStatsRecordPtr *records;
+
+    int next; /* index of the next domain to process, atomic */
+    int failed; /* set once a worker fails, atomic */
+
+    virMutex lock;
+    virErrorPtr err; /* first error reported by any worker, under @lock */
+};
+
+
+static void
+qemuConnectGetAllDomainStatsWorker(void *opaque)
+{
+    struct qemuConnectGetAllDomainStatsData *data = opaque;
+    int i;
+
+    while (!g_atomic_int_get(&data->failed) &&
+           (i = g_atomic_int_add(&data->next, 1)) < (int) data->nvms) {
+        if (qemuConnectGetAllDomainStatsOne(data->conn, data->vms[i],
+                                            data->stats, data->privflags,
+                                            &data->records[i],
+                                            data->maxAge,
+                                            data->flags) < 0) {
+            virMutexLock(&data->lock);
+            if (!data->err)
+                data->err = virErrorCopyNew(virGetLastError());
+            virMutexUnlock(&data->lock);
+
+            g_atomic_int_set(&data->failed, 1);
+            return;
+        }
+    }
+}
+
+
+/**
+ * qemuConnectGetAllDomainStatsParallel:
+ *
+ * Gather stats of @nvms domains using up to @nworkers threads (the
+ * calling thread included), so that monitor round-trips of different
+ * domains overlap. Records are stored into @records at the index of
+ * the corresponding domain in @vms.
+ */
+int
+qemuConnectGetAllDomainStatsParallel(virConnectPtr conn,
+                                     virDomainObj **vms,
+                                     size_t nvms,
+                                     unsigned int stats,
+                                     unsigned int privflags,
+                                     virDomainStatsRecordPtr *records,
+                                     unsigned int nworkers,
+                                     unsigned int maxAge,
+                                     unsigned int flags)
+{
+    struct qemuConnectGetAllDomainStatsData data = {
+        .conn = conn, .vms = vms, .nvms = nvms, .stats = stats,
+        .privflags = privflags, .maxAge = maxAge, .flags = flags,
+        .records = records,
+    };
+    g_autofree virThread *threads = NULL;
+    size_t nthreads = 0;
+    size_t i;
+    int ret = 0;
+
+    if (virMutexInit(&data.lock) < 0) {
+        virReportSystemError(errno, "%s", _("cannot initialize mutex"));
+        return -1;
+    }
+
+    if (nworkers > nvms)
+        nworkers = nvms;
+
+    threads = g_new0(virThread, nworkers);
+
+    /* The calling thread is the first worker. */
+    for (i = 1; i < nworkers; i++) {
+        if (virThreadCreateFull(&threads[nthreads], true,
+                                qemuConnectGetAllDomainStatsWorker,
+                                "qemu-stats", false, &data) < 0) {
+            /* carry on with whatever workers we already have */
+            VIR_WARN("Failed to spawn stats worker thread");
+            virResetLastError();
+            break;
+        }
+        nthreads++;
+    }
+
+    qemuConnectGetAllDomainStatsWorker(&data);
+
+    for (i = 0; i < nthreads; i++)
+        virThreadJoin(&threads[i]);
+
+    if (data.err) {
+        virSetError(data.err);
+        virFreeError(data.err);
+        ret = -1;
+    }
+
+    virMutexDestroy(&data.lock);
+    return ret;
+}
+
+
 static int
 qemuConnectGetAllDomainStats(virConnectPtr conn,
                              virDomainPtr *doms,
@@ -18724,9 +19022,9 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
                              unsigned int flags)
 {
     virQEMUDriver *driver = conn->privateData;
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
     virErrorPtr orig_err = NULL;
     virDomainObj **vms = NULL;
-    virDomainObj *vm;
     size_t nvms;
     virDomainStatsRecordPtr *tmpstats = NULL;
     bool enforce = !!(flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS);
@@ -18734,7 +19032,6 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
     size_t i;
     int ret = -1;
     unsigned int privflags = 0;
-    unsigned int domflags = 0;
     unsigned int lflags = flags & (VIR_CONNECT_LIST_DOMAINS_FILTERS_ACTIVE |
                                    VIR_CONNECT_LIST_DOMAINS_FILTERS_PERSISTENT |
                                    VIR_CONNECT_LIST_DOMAINS_FILTERS_STATE);
@@ -18744,6 +19041,7 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
                   VIR_CONNECT_LIST_DOMAINS_FILTERS_STATE |
                   VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT |
                   VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING |
+                  VIR_CONNECT_GET_ALL_DOMAINS_STATS_CACHED |
                   VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS, -1);
 
     if (virConnectGetAllDomainStatsEnsureACL(conn) < 0)
@@ -18769,43 +19067,35 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
     if (qemuDomainGetStatsNeedMonitor(stats))
         privflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
 
-    for (i = 0; i < nvms; i++) {
-        virDomainStatsRecordPtr tmp = NULL;
-        domflags = 0;
-        vm = vms[i];
-
-        virObjectLock(vm);
+    if (cfg->statsWorkers > 1 && nvms > 1) {
+        int rc = qemuConnectGetAllDomainStatsParallel(conn, vms, nvms, stats,
+                                                      privflags, tmpstats,
+                                                      cfg->statsWorkers,
+                                                      cfg->statsCacheMaxAge,
+                                                      flags);
 
-        if (HAVE_JOB(privflags)) {
-            int rv;
+        /* squash the holes left by domains which produced no record */
+        for (i = 0; i < nvms; i++) {
+            virDomainStatsRecordPtr tmp = g_steal_pointer(&tmpstats[i]);
 
-            if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT)
-                rv = qemuDomainObjBeginJobNowait(driver, vm, QEMU_JOB_QUERY);
-            else
-                rv = qemuDomainObjBeginJob(driver, vm, QEMU_JOB_QUERY);
-
-            if (rv == 0)
-                domflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
+            if (tmp)
+                tmpstats[nstats++] = tmp;
         }
-        /* else: without a job it's still possible to gather some data */
-
-        if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING)
-            domflags |= QEMU_DOMAIN_STATS_BACKING;
-        if (qemuDomainGetStats(conn, vm, stats, &tmp, domflags) < 0) {
-            if (HAVE_JOB(domflags) && vm)
-                qemuDomainObjEndJob(driver, vm);
 
-            virObjectUnlock(vm);
+        if (rc < 0)
             goto cleanup;
-        }
-
-        if (tmp)
-            tmpstats[nstats++] = tmp;
+    } else {
+        for (i = 0; i < nvms; i++) {
+            virDomainStatsRecordPtr tmp = NULL;
 
-        if (HAVE_JOB(domflags))
-            qemuDomainObjEndJob(driver, vm);
+            if (qemuConnectGetAllDomainStatsOne(conn, vms[i], stats, privflags,
+                                                &tmp, cfg->statsCacheMaxAge,
+                                                flags) < 0)
+                goto cleanup;
 
-        virObjectUnlock(vm);
+            if (tmp)
+                tmpstats[nstats++] = tmp;
+        }
     }
 
     *retStats = g_steal_pointer(&tmpstats);
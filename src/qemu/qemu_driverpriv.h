@@ -0,0 +1,58 @@
+/*
+ * qemu_driverpriv.h: private declarations for the QEMU driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LIBVIRT_QEMU_DRIVERPRIV_H_ALLOW
+# error "qemu_driverpriv.h may only be included by qemu_driver.c or test suites"
+#endif /* LIBVIRT_QEMU_DRIVERPRIV_H_ALLOW */
+
+#pragma once
+
+#include "domain_conf.h"
+
+/*
+ * This header file should never be used outside unit tests.
+ */
+
+typedef enum {
+    QEMU_DOMAIN_STATS_HAVE_JOB = 1 << 0, /* job is entered, monitor can be
+                                            accessed */
+    QEMU_DOMAIN_STATS_BACKING  = 1 << 1, /* include backing chain in
+                                            block stats */
+    QEMU_DOMAIN_STATS_CACHED   = 1 << 2, /* stats cached within the
+                                            configured max age may be
+                                            reported */
+} qemuDomainStatsFlags;
+
+int qemuDomainGetStats(virConnectPtr conn,
+                       virDomainObj *dom,
+                       unsigned int stats,
+                       virDomainStatsRecordPtr *record,
+                       long long now,
+                       unsigned int maxAge,
+                       unsigned int flags);
+
+int qemuConnectGetAllDomainStatsParallel(virConnectPtr conn,
+                                         virDomainObj **vms,
+                                         size_t nvms,
+                                         unsigned int stats,
+                                         unsigned int privflags,
+                                         virDomainStatsRecordPtr *records,
+                                         unsigned int nworkers,
+                                         unsigned int maxAge,
+                                         unsigned int flags);
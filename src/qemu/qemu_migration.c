@@ -2151,6 +2151,107 @@ qemuMigrationDstRun(virQEMUDriver *driver,
 }
 
 
+static qemuMigrationParams *
+qemuMigrationAnyParallelParams(unsigned int channels,
+                               qemuMigrationParty party)
+{
+    virTypedParameterPtr params = NULL;
+    int nparams = 0;
+    int maxparams = 0;
+    qemuMigrationParams *migParams;
+
+    if (virTypedParamsAddInt(&params, &nparams, &maxparams,
+                             VIR_MIGRATE_PARAM_PARALLEL_CONNECTIONS,
+                             channels) < 0)
+        return NULL;
+
+    migParams = qemuMigrationParamsFromFlags(params, nparams,
+                                             VIR_MIGRATE_PARALLEL, party);
+    virTypedParamsFree(params, nparams);
+    return migParams;
+}
+
+
+/**
+ * qemuMigrationDstRunParallel:
+ * @driver: qemu driver data
+ * @vm: domain object
+ * @uri: unix socket URI QEMU should listen on
+ * @channels: number of multifd channels
+ * @asyncJob: async job the domain is in
+ * @feed: callback starting to feed the migration stream
+ * @opaque: data passed to @feed
+ *
+ * Similar to qemuMigrationDstRun, but enables multifd with @channels
+ * channels before starting the incoming migration. Once QEMU listens on
+ * @uri, @feed is called (with @vm locked) to connect the main channel
+ * followed by the multifd channels and start sending data through them.
+ * The callback must not block. The caller is responsible for stopping
+ * whatever @feed started regardless of the result.
+ *
+ * Returns 0 once the incoming migration finished, -1 on error.
+ */
+int
+qemuMigrationDstRunParallel(virQEMUDriver *driver,
+                            virDomainObj *vm,
+                            const char *uri,
+                            unsigned int channels,
+                            qemuDomainAsyncJob asyncJob,
+                            qemuMigrationDstFeedFunc feed,
+                            void *opaque)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autoptr(qemuMigrationParams) migParams = NULL;
+    g_autoptr(qemuMigrationParams) origParams = NULL;
+    int ret = -1;
+    int rv;
+
+    VIR_DEBUG("Setting up parallel incoming migration with URI %s "
+              "and %u channels", uri, channels);
+
+    if (!qemuMigrationCapsGet(vm, QEMU_MIGRATION_CAP_MULTIFD)) {
+        virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                       _("QEMU does not support parallel migration"));
+        return -1;
+    }
+
+    if (qemuMigrationParamsFetch(driver, vm, asyncJob, &origParams) < 0)
+        return -1;
+
+    if (!(migParams = qemuMigrationAnyParallelParams(channels,
+                                                     QEMU_MIGRATION_DESTINATION)))
+        return -1;
+
+    if (qemuMigrationParamsApply(driver, vm, asyncJob, migParams) < 0)
+        goto cleanup;
+
+    if (qemuDomainObjEnterMonitorAsync(driver, vm, asyncJob) < 0)
+        goto cleanup;
+
+    rv = qemuMonitorSetDBusVMStateIdList(priv->mon, priv->dbusVMStateIds);
+    if (rv < 0)
+        goto exit_monitor;
+
+    rv = qemuMonitorMigrateIncoming(priv->mon, uri);
+
+ exit_monitor:
+    if (qemuDomainObjExitMonitor(driver, vm) < 0 || rv < 0)
+        goto cleanup;
+
+    if (feed(vm, opaque) < 0)
+        goto cleanup;
+
+    if (qemuMigrationDstWaitForCompletion(driver, vm, asyncJob, false) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    qemuMigrationParamsReset(driver, vm, asyncJob, origParams, 0);
+    return ret;
+}
+
+
 /* This is called for outgoing non-p2p migrations when a connection to the
  * client which initiated the migration was closed but we were waiting for it
  * to follow up with the next phase, that is, in between
@@ -2910,6 +3011,7 @@ qemuMigrationDstPrepareAny(virQEMUDriver *driver,
 
     /* Domain starts inactive, even if the domain XML had an id field. */
     vm->def->id = -1;
+    virDomainObjListUpdateID(driver->domains, vm);
 
     if (flags & VIR_MIGRATE_OFFLINE)
         goto done;
@@ -6036,6 +6138,106 @@ qemuMigrationSrcToFile(virQEMUDriver *driver, virDomainObj *vm,
     return ret;
 }
 
+/**
+ * qemuMigrationSrcToSocket:
+ * @driver: qemu driver data
+ * @vm: domain object
+ * @path: path to a listening unix socket
+ * @channels: number of multifd channels
+ * @asyncJob: async job the domain is in
+ *
+ * Migrates @vm into the unix socket @path using multifd with @channels
+ * channels. QEMU connects the main migration channel first followed by
+ * @channels multifd channels. Helper function called while vm is active.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+qemuMigrationSrcToSocket(virQEMUDriver *driver,
+                         virDomainObj *vm,
+                         const char *path,
+                         unsigned int channels,
+                         qemuDomainAsyncJob asyncJob)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    unsigned long saveMigBandwidth = priv->migMaxBandwidth;
+    g_autoptr(qemuMigrationParams) migParams = NULL;
+    g_autoptr(qemuMigrationParams) origParams = NULL;
+    virErrorPtr orig_err = NULL;
+    int ret = -1;
+    int rc;
+
+    if (qemuMigrationSetDBusVMState(driver, vm) < 0)
+        return -1;
+
+    if (qemuMigrationParamsFetch(driver, vm, asyncJob, &origParams) < 0)
+        return -1;
+
+    if (!(migParams = qemuMigrationAnyParallelParams(channels,
+                                                     QEMU_MIGRATION_SOURCE)))
+        return -1;
+
+    /* Increase migration bandwidth to unlimited since target is a file. */
+    if (qemuMigrationParamsSetULL(migParams,
+                                  QEMU_MIGRATION_PARAM_MAX_BANDWIDTH,
+                                  QEMU_DOMAIN_MIG_BANDWIDTH_MAX * 1024 * 1024) < 0)
+        return -1;
+
+    if (qemuMigrationParamsApply(driver, vm, asyncJob, migParams) < 0)
+        goto cleanup;
+
+    priv->migMaxBandwidth = QEMU_DOMAIN_MIG_BANDWIDTH_MAX;
+
+    if (!virDomainObjIsActive(vm)) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("guest unexpectedly quit"));
+        goto cleanup;
+    }
+
+    if (qemuDomainObjEnterMonitorAsync(driver, vm, asyncJob) < 0)
+        goto cleanup;
+
+    qemuSecurityDomainSetPathLabel(driver, vm, path, false);
+    rc = qemuMonitorMigrateToSocket(priv->mon,
+                                    QEMU_MONITOR_MIGRATE_BACKGROUND,
+                                    path);
+
+    if (qemuDomainObjExitMonitor(driver, vm) < 0)
+        goto cleanup;
+    if (rc < 0)
+        goto cleanup;
+
+    rc = qemuMigrationSrcWaitForCompletion(driver, vm, asyncJob, NULL, 0);
+
+    if (rc < 0) {
+        if (rc == -2) {
+            virErrorPreserveLast(&orig_err);
+            if (virDomainObjIsActive(vm) &&
+                qemuDomainObjEnterMonitorAsync(driver, vm, asyncJob) == 0) {
+                qemuMonitorMigrateCancel(priv->mon);
+                ignore_value(qemuDomainObjExitMonitor(driver, vm));
+            }
+        }
+        goto cleanup;
+    }
+
+    qemuDomainEventEmitJobCompleted(driver, vm);
+    ret = 0;
+
+ cleanup:
+    if (ret < 0 && !orig_err)
+        virErrorPreserveLast(&orig_err);
+
+    if (virDomainObjIsActive(vm)) {
+        qemuMigrationParamsReset(driver, vm, asyncJob, origParams, 0);
+        priv->migMaxBandwidth = saveMigBandwidth;
+    }
+
+    virErrorRestore(&orig_err);
+
+    return ret;
+}
+
 
 int
 qemuMigrationSrcCancel(virQEMUDriver *driver,
@@ -212,6 +212,15 @@ qemuMigrationSrcToFile(virQEMUDriver *driver,
                        qemuDomainAsyncJob asyncJob)
     ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) G_GNUC_WARN_UNUSED_RESULT;
 
+int
+qemuMigrationSrcToSocket(virQEMUDriver *driver,
+                         virDomainObj *vm,
+                         const char *path,
+                         unsigned int channels,
+                         qemuDomainAsyncJob asyncJob)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) ATTRIBUTE_NONNULL(3)
+    G_GNUC_WARN_UNUSED_RESULT;
+
 int
 qemuMigrationSrcCancel(virQEMUDriver *driver,
                        virDomainObj *vm);
@@ -249,6 +258,20 @@ qemuMigrationDstRun(virQEMUDriver *driver,
                     const char *uri,
                     qemuDomainAsyncJob asyncJob);
 
+typedef int (*qemuMigrationDstFeedFunc)(virDomainObj *vm,
+                                        void *opaque);
+
+int
+qemuMigrationDstRunParallel(virQEMUDriver *driver,
+                            virDomainObj *vm,
+                            const char *uri,
+                            unsigned int channels,
+                            qemuDomainAsyncJob asyncJob,
+                            qemuMigrationDstFeedFunc feed,
+                            void *opaque)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) ATTRIBUTE_NONNULL(3)
+    ATTRIBUTE_NONNULL(6) G_GNUC_WARN_UNUSED_RESULT;
+
 void
 qemuMigrationAnyPostcopyFailed(virQEMUDriver *driver,
                             virDomainObj *vm);
@@ -94,6 +94,11 @@ struct _qemuMonitor {
     size_t bufferLength;
     char *buffer;
 
+    /* Parser fed the first @bufferParsed bytes of @buffer, so
+     * that partially received replies aren't parsed again */
+    virJSONStreamParser *parser;
+    size_t bufferParsed;
+
     /* If anything went wrong, this will be fed back
      * the next monitor msg */
     virError lastError;
@@ -241,6 +246,7 @@ qemuMonitorDispose(void *obj)
     virResetError(&mon->lastError);
     virCondDestroy(&mon->notify);
     g_free(mon->buffer);
+    virJSONStreamParserFree(mon->parser);
     g_free(mon->balloonpath);
 }
 
@@ -345,6 +351,7 @@ qemuMonitorIOProcess(qemuMonitor *mon)
 
     len = qemuMonitorJSONIOProcess(mon,
                                    mon->buffer, mon->bufferOffset,
+                                   mon->parser, &mon->bufferParsed,
                                    msg);
     if (len < 0)
         return -1;
@@ -469,15 +476,22 @@ qemuMonitorIORead(qemuMonitor *mon)
     int ret = 0;
 
     if (avail < 1024) {
+        size_t grow;
+
         if (mon->bufferLength >= QEMU_MONITOR_MAX_RESPONSE) {
             virReportError(VIR_ERR_INTERNAL_ERROR,
                            _("QEMU monitor reply exceeds buffer size (%d bytes)"),
                            QEMU_MONITOR_MAX_RESPONSE);
             return -1;
         }
-        VIR_REALLOC_N(mon->buffer, mon->bufferLength + 1024);
-        mon->bufferLength += 1024;
-        avail += 1024;
+
+        /* grow geometrically so that large replies aren't copied over
+         * and over again */
+        grow = MAX(1024, MIN(mon->bufferLength,
+                             QEMU_MONITOR_MAX_RESPONSE - mon->bufferLength));
+        VIR_REALLOC_N(mon->buffer, mon->bufferLength + grow);
+        mon->bufferLength += grow;
+        avail += grow;
     }
 
     /* Read as much as we can get into our buffer,
@@ -694,6 +708,8 @@ qemuMonitorOpenInternal(virDomainObj *vm,
                        _("cannot initialize monitor condition"));
         goto cleanup;
     }
+    if (!(mon->parser = virJSONStreamParserNew()))
+        goto cleanup;
     mon->fd = fd;
     mon->context = g_main_context_ref(context);
     mon->vm = virObjectRef(vm);
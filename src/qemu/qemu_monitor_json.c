@@ -50,7 +50,6 @@ VIR_LOG_INIT("qemu.qemu_monitor_json");
 
 #define QOM_CPU_PATH  "/machine/unattached/device[0]"
 
-#define LINE_ENDING "\r\n"
 
 VIR_ENUM_IMPL(qemuMonitorJob,
               QEMU_MONITOR_JOB_TYPE_LAST,
@@ -212,84 +211,116 @@ qemuMonitorJSONIOProcessEvent(qemuMonitor *mon,
 }
 
 int
-qemuMonitorJSONIOProcessLine(qemuMonitor *mon,
-                             const char *line,
-                             qemuMonitorMessage *msg)
+qemuMonitorJSONIOProcessObject(qemuMonitor *mon,
+                               virJSONValue *obj,
+                               const char *line,
+                               qemuMonitorMessage *msg)
 {
-    virJSONValue *obj = NULL;
-    int ret = -1;
-
-    VIR_DEBUG("Line [%s]", line);
-
-    if (!(obj = virJSONValueFromString(line)))
-        goto cleanup;
+    g_autoptr(virJSONValue) value = obj;
 
-    if (virJSONValueGetType(obj) != VIR_JSON_TYPE_OBJECT) {
+    if (virJSONValueGetType(value) != VIR_JSON_TYPE_OBJECT) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
                        _("Parsed JSON reply '%s' isn't an object"), line);
-        goto cleanup;
+        return -1;
     }
 
-    if (virJSONValueObjectHasKey(obj, "QMP") == 1) {
-        ret = 0;
-    } else if (virJSONValueObjectHasKey(obj, "event") == 1) {
+    if (virJSONValueObjectHasKey(value, "QMP") == 1)
+        return 0;
+
+    if (virJSONValueObjectHasKey(value, "event") == 1) {
         PROBE(QEMU_MONITOR_RECV_EVENT,
               "mon=%p event=%s", mon, line);
-        ret = qemuMonitorJSONIOProcessEvent(mon, obj);
-    } else if (virJSONValueObjectHasKey(obj, "error") == 1 ||
-               virJSONValueObjectHasKey(obj, "return") == 1) {
+        return qemuMonitorJSONIOProcessEvent(mon, value);
+    }
+
+    if (virJSONValueObjectHasKey(value, "error") == 1 ||
+        virJSONValueObjectHasKey(value, "return") == 1) {
         PROBE(QEMU_MONITOR_RECV_REPLY,
               "mon=%p reply=%s", mon, line);
-        if (msg) {
-            msg->rxObject = g_steal_pointer(&obj);
-            msg->finished = 1;
-            ret = 0;
-        } else {
+        if (!msg) {
             virReportError(VIR_ERR_INTERNAL_ERROR,
                            _("Unexpected JSON reply '%s'"), line);
+            return -1;
         }
-    } else {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("Unknown JSON reply '%s'"), line);
+
+        msg->rxObject = g_steal_pointer(&value);
+        msg->finished = 1;
+        return 0;
     }
 
- cleanup:
-    virJSONValueFree(obj);
-    return ret;
+    virReportError(VIR_ERR_INTERNAL_ERROR,
+                   _("Unknown JSON reply '%s'"), line);
+    return -1;
 }
 
+
+/**
+ * qemuMonitorJSONIOProcess:
+ * @mon: monitor object
+ * @data: buffer of data received from the monitor
+ * @len: length of @data
+ * @parser: stream parser which was fed the first @parsed bytes of @data
+ * @parsed: number of bytes of @data already fed to @parser
+ * @msg: message waiting for a reply, if any
+ *
+ * Feeds the not yet seen data to @parser, so that each received byte is
+ * scanned and parsed just once no matter how many reads it takes for a
+ * reply to arrive, and processes all complete messages.
+ *
+ * Returns the number of bytes of @data which can be discarded by the
+ * caller (@parsed is adjusted accordingly), or -1 on error.
+ */
 int qemuMonitorJSONIOProcess(qemuMonitor *mon,
                              const char *data,
                              size_t len,
+                             virJSONStreamParser *parser,
+                             size_t *parsed,
                              qemuMonitorMessage *msg)
 {
-    int used = 0;
+    size_t used = 0;
     /*VIR_DEBUG("Data %d bytes [%s]", len, data);*/
 
-    while (used < len) {
-        char *nl = strstr(data + used, LINE_ENDING);
-
-        if (nl) {
-            int got = nl - (data + used);
-            char *line;
-            line = g_strndup(data + used, got);
-            used += got + strlen(LINE_ENDING);
-            line[got] = '\0'; /* kill \n */
-            if (qemuMonitorJSONIOProcessLine(mon, line, msg) < 0) {
-                VIR_FREE(line);
-                return -1;
-            }
+    while (*parsed < len) {
+        const char *start = data + *parsed;
+        const char *nl = memchr(start, '\n', len - *parsed);
+        size_t chunk = nl ? nl - start : len - *parsed;
+        g_autofree char *line = NULL;
+        size_t linelen;
+        virJSONValue *obj;
 
-            VIR_FREE(line);
-        } else {
+        if (virJSONStreamParserFeed(parser, start, chunk) < 0)
+            return -1;
+
+        *parsed += chunk;
+
+        if (!nl)
             break;
-        }
+
+        /* strip the line ending */
+        linelen = nl - (data + used);
+        if (linelen > 0 && data[used + linelen - 1] == '\r')
+            linelen--;
+        line = g_strndup(data + used, linelen);
+
+        *parsed += 1;
+        used = *parsed;
+
+        VIR_DEBUG("Line [%s]", line);
+
+        if (!(obj = virJSONStreamParserFinish(parser)))
+            return -1;
+
+        if (qemuMonitorJSONIOProcessObject(mon, obj, line, msg) < 0)
+            return -1;
     }
 
 #if DEBUG_IO
-    VIR_DEBUG("Total used %d bytes out of %zd available in buffer", used, len);
+    VIR_DEBUG("Total used %zu bytes out of %zu available in buffer", used, len);
 #endif
 
+    /* the caller discards the data we've used */
+    *parsed -= used;
+
     return used;
 }
 
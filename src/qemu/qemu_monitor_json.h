@@ -28,13 +28,16 @@
 #include "cpu/cpu.h"
 #include "util/virgic.h"
 
-int qemuMonitorJSONIOProcessLine(qemuMonitor *mon,
-                                 const char *line,
-                                 qemuMonitorMessage *msg) G_GNUC_NO_INLINE;
+int qemuMonitorJSONIOProcessObject(qemuMonitor *mon,
+                                   virJSONValue *obj,
+                                   const char *line,
+                                   qemuMonitorMessage *msg) G_GNUC_NO_INLINE;
 
 int qemuMonitorJSONIOProcess(qemuMonitor *mon,
                              const char *data,
                              size_t len,
+                             virJSONStreamParser *parser,
+                             size_t *parsed,
                              qemuMonitorMessage *msg);
 
 int qemuMonitorJSONHumanCommand(qemuMonitor *mon,
@@ -5718,6 +5718,7 @@ qemuProcessInit(virQEMUDriver *driver,
         }
     } else {
         vm->def->id = qemuDriverAllocateID(driver);
+        virDomainObjListUpdateID(driver->domains, vm);
         qemuDomainSetFakeReboot(driver, vm, false);
         virDomainObjSetState(vm, VIR_DOMAIN_PAUSED, VIR_DOMAIN_PAUSED_STARTING_UP);
 
@@ -6705,6 +6706,17 @@ qemuProcessPrepareHostStorage(virQEMUDriver *driver,
     bool cold_boot = flags & VIR_QEMU_PROCESS_START_COLD;
     bool blockdev = virQEMUCapsGet(priv->qemuCaps, QEMU_CAPS_BLOCKDEV);
 
+    for (i = 0; i < vm->def->ndisks; i++) {
+        virDomainDiskDef *disk = vm->def->disks[i];
+
+        /* backing chain needs to be redetected if we aren't using blockdev */
+        if (!virStorageSourceIsEmpty(disk->src) &&
+            (!blockdev || qemuDiskBusIsSD(disk->bus)))
+            virStorageSourceBackingStoreClear(disk->src);
+    }
+
+    qemuDomainPrefetchDiskChains(driver, vm);
+
     for (i = vm->def->ndisks; i > 0; i--) {
         size_t idx = i - 1;
         virDomainDiskDef *disk = vm->def->disks[idx];
@@ -6712,10 +6724,6 @@ qemuProcessPrepareHostStorage(virQEMUDriver *driver,
         if (virStorageSourceIsEmpty(disk->src))
             continue;
 
-        /* backing chain needs to be redetected if we aren't using blockdev */
-        if (!blockdev || qemuDiskBusIsSD(disk->bus))
-            virStorageSourceBackingStoreClear(disk->src);
-
         /*
          * Go to applying startup policy for optional disk with nonexistent
          * source file immediately as determining chain will surely fail
@@ -7567,6 +7575,7 @@ qemuProcessStart(virConnectPtr conn,
                  const char *migrateFrom,
                  int migrateFd,
                  const char *migratePath,
+                 const qemuProcessIncomingFeed *feed,
                  virDomainMomentObj *snapshot,
                  virNetDevVPortProfileOp vmop,
                  unsigned int flags)
@@ -7580,12 +7589,12 @@ qemuProcessStart(virConnectPtr conn,
     int rv;
 
     VIR_DEBUG("conn=%p driver=%p vm=%p name=%s id=%d asyncJob=%s "
-              "migrateFrom=%s migrateFd=%d migratePath=%s "
+              "migrateFrom=%s migrateFd=%d migratePath=%s feed=%p "
               "snapshot=%p vmop=%d flags=0x%x",
               conn, driver, vm, vm->def->name, vm->def->id,
               qemuDomainAsyncJobTypeToString(asyncJob),
               NULLSTR(migrateFrom), migrateFd, NULLSTR(migratePath),
-              snapshot, vmop, flags);
+              feed, snapshot, vmop, flags);
 
     virCheckFlagsGoto(VIR_QEMU_PROCESS_START_COLD |
                       VIR_QEMU_PROCESS_START_PAUSED |
@@ -7604,6 +7613,12 @@ qemuProcessStart(virConnectPtr conn,
                                              migrateFd, migratePath);
         if (!incoming)
             goto stop;
+
+        if (feed && !incoming->deferredURI) {
+            virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                           _("this QEMU does not support parallel incoming migration"));
+            goto stop;
+        }
     }
 
     if (qemuProcessPrepareDomain(driver, vm, flags) < 0)
@@ -7628,9 +7643,16 @@ qemuProcessStart(virConnectPtr conn,
     relabel = true;
 
     if (incoming) {
-        if (incoming->deferredURI &&
-            qemuMigrationDstRun(driver, vm, incoming->deferredURI, asyncJob) < 0)
+        if (feed) {
+            if (qemuMigrationDstRunParallel(driver, vm, incoming->deferredURI,
+                                            feed->channels, asyncJob,
+                                            feed->func, feed->opaque) < 0)
+                goto stop;
+        } else if (incoming->deferredURI &&
+                   qemuMigrationDstRun(driver, vm, incoming->deferredURI,
+                                       asyncJob) < 0) {
             goto stop;
+        }
     } else {
         /* Refresh state of devices from QEMU. During migration this happens
          * in qemuMigrationDstFinish to ensure that state information is fully
@@ -7923,6 +7945,7 @@ void qemuProcessStop(virQEMUDriver *driver,
     qemuDBusStop(driver, vm);
 
     vm->def->id = -1;
+    virDomainObjListUpdateID(driver->domains, vm);
 
     virFileDeleteTree(priv->libDir);
     virFileDeleteTree(priv->channelTargetDir);
@@ -8508,6 +8531,16 @@ struct qemuProcessReconnectData {
     virQEMUDriver *driver;
     virDomainObj *obj;
     virIdentity *identity;
+
+    /* monotonic time in ms when the reconnect was scheduled */
+    long long queued;
+
+    /* Set when qemuProcessReconnectPrepare already restored the job
+     * from the status XML into @oldjob and acquired a modify job which
+     * is handed over to the thread doing the reconnect. */
+    bool jobRestored;
+    bool jobStarted;
+    qemuDomainJobObj oldjob;
 };
 /*
  * Open an existing VM's monitor, re-detect VCPU threads
@@ -8545,23 +8578,40 @@ qemuProcessReconnect(void *opaque)
     bool jobStarted = false;
     bool retry = true;
     bool tryMonReconn = false;
+    long long queued = data->queued;
+    long long started = g_get_monotonic_time() / 1000;
 
     virIdentitySetCurrent(data->identity);
     g_clear_object(&data->identity);
+
+    if (data->jobRestored) {
+        /* the domain object was unlocked while waiting in the queue */
+        virObjectLock(obj);
+        oldjob = data->oldjob;
+    } else {
+        qemuDomainObjRestoreJob(obj, &oldjob);
+    }
+
+    if (data->jobStarted) {
+        qemuDomainObjTransferJob(obj);
+        jobStarted = true;
+    }
+
     VIR_FREE(data);
 
     cfg = virQEMUDriverGetConfig(driver);
     priv = obj->privateData;
 
-    qemuDomainObjRestoreJob(obj, &oldjob);
     if (oldjob.asyncJob == QEMU_ASYNC_JOB_MIGRATION_IN)
         stopFlags |= VIR_QEMU_PROCESS_STOP_MIGRATED;
     if (oldjob.asyncJob == QEMU_ASYNC_JOB_BACKUP && priv->backup)
         priv->backup->apiFlags = oldjob.apiFlags;
 
-    if (qemuDomainObjBeginJob(driver, obj, QEMU_JOB_MODIFY) < 0)
-        goto error;
-    jobStarted = true;
+    if (!jobStarted) {
+        if (qemuDomainObjBeginJob(driver, obj, QEMU_JOB_MODIFY) < 0)
+            goto error;
+        jobStarted = true;
+    }
 
     /* XXX If we ever gonna change pid file pattern, come up with
      * some intelligence here to deal with old paths. */
@@ -8792,6 +8842,11 @@ qemuProcessReconnect(void *opaque)
         driver->inhibitCallback(true, driver->inhibitOpaque);
 
  cleanup:
+    VIR_INFO("Reconnect to domain '%s' %s after %lld ms (%lld ms queued)",
+             obj->def->name,
+             virDomainObjIsActive(obj) ? "finished" : "failed",
+             g_get_monotonic_time() / 1000 - queued, started - queued);
+
     if (jobStarted) {
         if (!virDomainObjIsActive(obj))
             qemuDomainRemoveInactive(driver, obj);
@@ -8851,6 +8906,7 @@ qemuProcessReconnectHelper(virDomainObj *obj,
     memcpy(data, src, sizeof(*data));
     data->obj = obj;
     data->identity = virIdentityGetCurrent();
+    data->queued = g_get_monotonic_time() / 1000;
 
     virNWFilterReadLockFilterUpdates();
 
@@ -8885,18 +8941,149 @@ qemuProcessReconnectHelper(virDomainObj *obj,
     return 0;
 }
 
+struct qemuProcessReconnectQueue {
+    virQEMUDriver *driver;
+    struct qemuProcessReconnectData **items;
+    size_t nitems;
+    int next; /* index of the next item to process, atomic */
+    int refs; /* atomic */
+    long long start; /* monotonic time in ms */
+};
+
+
+static void
+qemuProcessReconnectQueueUnref(struct qemuProcessReconnectQueue *queue)
+{
+    if (!g_atomic_int_dec_and_test(&queue->refs))
+        return;
+
+    VIR_INFO("Reconnect to %zu domains finished after %lld ms",
+             queue->nitems, g_get_monotonic_time() / 1000 - queue->start);
+
+    g_free(queue->items);
+    g_free(queue);
+}
+
+
+static void
+qemuProcessReconnectWorker(void *opaque)
+{
+    struct qemuProcessReconnectQueue *queue = opaque;
+    int i;
+
+    while ((i = g_atomic_int_add(&queue->next, 1)) < (int) queue->nitems)
+        qemuProcessReconnect(g_steal_pointer(&queue->items[i]));
+
+    qemuProcessReconnectQueueUnref(queue);
+}
+
+
+/*
+ * Queue a reconnect of a live VM for the reconnect workers. Unlike
+ * qemuProcessReconnectHelper this doesn't keep the domain object locked
+ * until a worker gets to it. The job stored in the status XML is
+ * restored and a modify job is acquired instead, so that no API can
+ * change the domain until it's reconnected while APIs which only read
+ * the domain definition or state don't have to wait.
+ */
+static int
+qemuProcessReconnectPrepare(virDomainObj *obj,
+                            void *opaque)
+{
+    struct qemuProcessReconnectQueue *queue = opaque;
+    struct qemuProcessReconnectData *data;
+
+    /* If the VM was inactive, we don't need to reconnect */
+    if (!obj->pid)
+        return 0;
+
+    data = g_new0(struct qemuProcessReconnectData, 1);
+    data->driver = queue->driver;
+    data->obj = virObjectRef(obj);
+    data->identity = virIdentityGetCurrent();
+    data->queued = g_get_monotonic_time() / 1000;
+
+    virNWFilterReadLockFilterUpdates();
+
+    virObjectLock(obj);
+
+    qemuDomainObjRestoreJob(obj, &data->oldjob);
+    data->jobRestored = true;
+
+    /* Nobody else can have a job yet; should this fail anyway, the
+     * reconnect thread will retry and deal with the failure. */
+    if (qemuDomainObjBeginJob(queue->driver, obj, QEMU_JOB_MODIFY) == 0)
+        data->jobStarted = true;
+    else
+        virResetLastError();
+
+    virObjectUnlock(obj);
+
+    ignore_value(VIR_APPEND_ELEMENT(queue->items, queue->nitems, data));
+
+    return 0;
+}
+
+
 /**
  * qemuProcessReconnectAll
  *
  * Try to re-open the resources for live VMs that we care
  * about.
+ *
+ * With reconnect_workers configured the reconnects are processed by a
+ * bounded number of threads, otherwise each VM gets its own thread.
  */
 void
 qemuProcessReconnectAll(virQEMUDriver *driver)
 {
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
     struct qemuProcessReconnectData data = {.driver = driver};
-    virDomainObjListForEach(driver->domains, true,
-                            qemuProcessReconnectHelper, &data);
+    struct qemuProcessReconnectQueue *queue;
+    size_t nworkers;
+    size_t i;
+
+    if (cfg->reconnectWorkers == 0) {
+        virDomainObjListForEach(driver->domains, true,
+                                qemuProcessReconnectHelper, &data);
+        return;
+    }
+
+    queue = g_new0(struct qemuProcessReconnectQueue, 1);
+    queue->driver = driver;
+    queue->start = g_get_monotonic_time() / 1000;
+    queue->refs = 1;
+
+    virDomainObjListForEach(driver->domains, false,
+                            qemuProcessReconnectPrepare, queue);
+
+    nworkers = MIN(cfg->reconnectWorkers, queue->nitems);
+
+    VIR_DEBUG("Reconnecting to %zu domains using %zu threads",
+              queue->nitems, nworkers);
+
+    for (i = 0; i < nworkers; i++) {
+        virThread thread;
+        g_autofree char *name = g_strdup_printf("init-worker-%zu", i);
+
+        g_atomic_int_inc(&queue->refs);
+        if (virThreadCreateFull(&thread, false, qemuProcessReconnectWorker,
+                                name, false, queue) < 0) {
+            ignore_value(g_atomic_int_dec_and_test(&queue->refs));
+            break;
+        }
+    }
+
+    if (i == 0 && queue->nitems > 0) {
+        /* The domains must not be left with a job nobody would ever end */
+        VIR_WARN("Could not create reconnect threads, reconnecting "
+                 "domains synchronously");
+        virResetLastError();
+        qemuProcessReconnectWorker(queue);
+        return;
+    }
+
+    qemuProcessReconnectQueueUnref(queue);
 }
 
 
@@ -83,6 +83,15 @@ typedef enum {
                                                      ie no FD passing and the like */
 } qemuProcessStartFlags;
 
+/* Describes how to feed an incoming migration over multifd channels,
+ * see qemuMigrationDstRunParallel */
+typedef struct _qemuProcessIncomingFeed qemuProcessIncomingFeed;
+struct _qemuProcessIncomingFeed {
+    unsigned int channels; /* number of multifd channels */
+    int (*func)(virDomainObj *vm, void *opaque);
+    void *opaque;
+};
+
 int qemuProcessStart(virConnectPtr conn,
                      virQEMUDriver *driver,
                      virDomainObj *vm,
@@ -91,6 +100,7 @@ int qemuProcessStart(virConnectPtr conn,
                      const char *migrateFrom,
                      int stdin_fd,
                      const char *stdin_path,
+                     const qemuProcessIncomingFeed *feed,
                      virDomainMomentObj *snapshot,
                      virNetDevVPortProfileOp vmop,
                      unsigned int flags);
@@ -30,6 +30,7 @@
 #include "virlog.h"
 #include "viralloc.h"
 #include "virqemu.h"
+#include "virsocket.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -49,6 +50,7 @@ typedef enum {
      */
     QEMU_SAVE_FORMAT_XZ = 3,
     QEMU_SAVE_FORMAT_LZOP = 4,
+    QEMU_SAVE_FORMAT_ZSTD = 5,
     /* Note: add new members only at the end.
        These values are used in the on-disk format.
        Do not change or re-use numbers. */
@@ -64,6 +66,7 @@ VIR_ENUM_IMPL(qemuSaveCompression,
               "bzip2",
               "xz",
               "lzop",
+              "zstd",
 );
 
 static inline void
@@ -74,6 +77,8 @@ qemuSaveImageBswapHeader(virQEMUSaveHeader *hdr)
     hdr->was_running = GUINT32_SWAP_LE_BE(hdr->was_running);
     hdr->compressed = GUINT32_SWAP_LE_BE(hdr->compressed);
     hdr->cookieOffset = GUINT32_SWAP_LE_BE(hdr->cookieOffset);
+    hdr->channels = GUINT32_SWAP_LE_BE(hdr->channels);
+    hdr->nchunks = GUINT32_SWAP_LE_BE(hdr->nchunks);
 }
 
 
@@ -155,9 +160,12 @@ virQEMUSaveDataWrite(virQEMUSaveData *data,
     if (header->data_len == 0) {
         /* This 64kb padding allows the user to edit the XML in
          * a saved state image and have the new XML be larger
-         * that what was originally saved
+         * that what was originally saved. The padding is extended
+         * so that the migration stream starts at an offset suitable
+         * for direct I/O.
          */
-        header->data_len = len + (64 * 1024);
+        header->data_len = VIR_ROUND_UP(sizeof(*header) + len + (64 * 1024),
+                                        VIR_FILE_DIRECT_ALIGNMENT) - sizeof(*header);
     } else {
         if (len > header->data_len) {
             virReportError(VIR_ERR_OPERATION_FAILED, "%s",
@@ -205,7 +213,14 @@ virQEMUSaveDataWrite(virQEMUSaveData *data,
 }
 
 
-static int
+/* virQEMUSaveDataFinish:
+ *
+ * Marks the image as complete by writing the header with the final magic
+ * at the current position of @fd, which is closed afterwards.
+ *
+ * Returns -1 on failure, or 0 on success.
+ */
+int
 virQEMUSaveDataFinish(virQEMUSaveData *data,
                       int *fd,
                       const char *path)
@@ -249,6 +264,633 @@ qemuSaveImageGetCompressionCommand(virQEMUSaveFormat compression)
 }
 
 
+/* Layout of a parallel save image (QEMU_SAVE_VERSION_PARALLEL):
+ *
+ *   header | domain XML and cookie | chunks | chunk index
+ *
+ * The main migration channel and each of the @channels multifd channels
+ * are split into chunks of at most QEMU_SAVE_PARALLEL_CHUNK_SIZE bytes
+ * stored in the order they were received. The index at the end of the file
+ * consists of @nchunks little endian qemuSaveImageChunk entries. Chunks of
+ * a single channel appear in the index in the stream order.
+ */
+#define QEMU_SAVE_PARALLEL_CHUNK_SIZE (1024 * 1024)
+
+typedef struct _qemuSaveImageChunk qemuSaveImageChunk;
+struct _qemuSaveImageChunk {
+    uint64_t offset;
+    uint64_t length;
+    uint32_t channel; /* 0 is the main migration channel */
+    uint32_t unused;
+};
+
+G_STATIC_ASSERT(sizeof(qemuSaveImageChunk) == 24);
+
+typedef struct _qemuSaveImageParallel qemuSaveImageParallel;
+
+typedef struct _qemuSaveImageChannel qemuSaveImageChannel;
+struct _qemuSaveImageChannel {
+    qemuSaveImageParallel *parallel;
+    unsigned int id;
+    int sock;
+    virThread thread;
+    bool started;
+};
+
+struct _qemuSaveImageParallel {
+    virMutex lock;
+
+    int fd; /* not owned */
+    char *sockpath;
+
+    qemuSaveImageChunk *chunks;
+    size_t nchunks;
+    size_t nchunks_max;
+    off_t end; /* end of the last reserved chunk when saving */
+
+    int listenfd;
+    virThread acceptThread;
+    bool acceptStarted;
+
+    size_t nchannels; /* including the main channel */
+    qemuSaveImageChannel *channels;
+
+    bool quit;
+    int err; /* errno of the first failure in any of the threads */
+};
+
+
+static void
+qemuSaveImageParallelFree(qemuSaveImageParallel *p)
+{
+    size_t i;
+
+    if (!p)
+        return;
+
+    for (i = 0; i < p->nchannels; i++)
+        VIR_FORCE_CLOSE(p->channels[i].sock);
+    VIR_FORCE_CLOSE(p->listenfd);
+
+    g_free(p->channels);
+    g_free(p->chunks);
+    g_free(p->sockpath);
+    virMutexDestroy(&p->lock);
+    g_free(p);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(qemuSaveImageParallel, qemuSaveImageParallelFree);
+
+
+static qemuSaveImageParallel *
+qemuSaveImageParallelNew(int fd,
+                         size_t nchannels)
+{
+    qemuSaveImageParallel *p = g_new0(qemuSaveImageParallel, 1);
+    size_t i;
+
+    if (virMutexInit(&p->lock) < 0) {
+        virReportSystemError(errno, "%s", _("unable to init mutex"));
+        g_free(p);
+        return NULL;
+    }
+
+    p->fd = fd;
+    p->listenfd = -1;
+    p->nchannels = nchannels;
+    p->channels = g_new0(qemuSaveImageChannel, nchannels);
+
+    for (i = 0; i < nchannels; i++) {
+        p->channels[i].parallel = p;
+        p->channels[i].id = i;
+        p->channels[i].sock = -1;
+    }
+
+    return p;
+}
+
+
+static void
+qemuSaveImageParallelFail(qemuSaveImageParallel *p,
+                          int err)
+{
+    virMutexLock(&p->lock);
+    if (!p->quit && p->err == 0)
+        p->err = err;
+    virMutexUnlock(&p->lock);
+}
+
+
+/* Stops accepting new channels and with @abort set also interrupts
+ * transfers on all channels. Threads have to be joined afterwards. */
+static void
+qemuSaveImageParallelStop(qemuSaveImageParallel *p,
+                          bool abort)
+{
+    size_t i;
+
+    virMutexLock(&p->lock);
+    p->quit = true;
+
+    if (p->listenfd >= 0)
+        shutdown(p->listenfd, SHUT_RDWR);
+
+    for (i = 0; abort && i < p->nchannels; i++) {
+        if (p->channels[i].started)
+            shutdown(p->channels[i].sock, SHUT_RDWR);
+    }
+    virMutexUnlock(&p->lock);
+}
+
+
+static void
+qemuSaveImageParallelJoin(qemuSaveImageParallel *p)
+{
+    size_t i;
+
+    if (p->acceptStarted)
+        virThreadJoin(&p->acceptThread);
+    p->acceptStarted = false;
+
+    for (i = 0; i < p->nchannels; i++) {
+        if (p->channels[i].started)
+            virThreadJoin(&p->channels[i].thread);
+        p->channels[i].started = false;
+    }
+}
+
+
+static int
+qemuSaveImagePWrite(int fd,
+                    const char *buf,
+                    size_t len,
+                    off_t offset)
+{
+    while (len > 0) {
+        ssize_t rc = pwrite(fd, buf, len, offset);
+
+        if (rc < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        buf += rc;
+        len -= rc;
+        offset += rc;
+    }
+
+    return 0;
+}
+
+
+static int
+qemuSaveImagePRead(int fd,
+                   char *buf,
+                   size_t len,
+                   off_t offset)
+{
+    while (len > 0) {
+        ssize_t rc = pread(fd, buf, len, offset);
+
+        if (rc < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        if (rc == 0) {
+            errno = EIO;
+            return -1;
+        }
+
+        buf += rc;
+        len -= rc;
+        offset += rc;
+    }
+
+    return 0;
+}
+
+
+/* Copies data received on a channel into chunks appended to the image */
+static void
+qemuSaveImageParallelWrite(void *opaque)
+{
+    qemuSaveImageChannel *chan = opaque;
+    qemuSaveImageParallel *p = chan->parallel;
+    g_autofree char *buf = g_new0(char, QEMU_SAVE_PARALLEL_CHUNK_SIZE);
+
+    while (true) {
+        qemuSaveImageChunk chunk = { 0 };
+        ssize_t got;
+
+        if ((got = saferead(chan->sock, buf, QEMU_SAVE_PARALLEL_CHUNK_SIZE)) < 0)
+            goto error;
+
+        if (got == 0)
+            return;
+
+        virMutexLock(&p->lock);
+        chunk.offset = p->end;
+        chunk.length = got;
+        chunk.channel = chan->id;
+        p->end += got;
+        VIR_RESIZE_N(p->chunks, p->nchunks_max, p->nchunks, 1);
+        p->chunks[p->nchunks++] = chunk;
+        virMutexUnlock(&p->lock);
+
+        if (qemuSaveImagePWrite(p->fd, buf, got, chunk.offset) < 0)
+            goto error;
+    }
+
+ error:
+    qemuSaveImageParallelFail(p, errno);
+    /* Make QEMU notice the failure instead of waiting on a full socket */
+    shutdown(chan->sock, SHUT_RDWR);
+}
+
+
+/* Accepts connections from QEMU. The main migration channel connects first
+ * and thus the order of connections matches the channel IDs. */
+static void
+qemuSaveImageParallelAccept(void *opaque)
+{
+    qemuSaveImageParallel *p = opaque;
+    size_t i;
+
+    for (i = 0; i < p->nchannels; i++) {
+        qemuSaveImageChannel *chan = &p->channels[i];
+        int sock;
+
+        do {
+            sock = accept(p->listenfd, NULL, NULL);
+        } while (sock < 0 && errno == EINTR);
+
+        if (sock < 0) {
+            qemuSaveImageParallelFail(p, errno);
+            return;
+        }
+
+        virMutexLock(&p->lock);
+        chan->sock = sock;
+        if (p->quit ||
+            virThreadCreateFull(&chan->thread, true,
+                                qemuSaveImageParallelWrite,
+                                "qemu-save-write", false, chan) < 0) {
+            if (p->err == 0 && !p->quit)
+                p->err = errno;
+            virMutexUnlock(&p->lock);
+            return;
+        }
+        chan->started = true;
+        virMutexUnlock(&p->lock);
+    }
+}
+
+
+/* Sends chunks belonging to a channel to QEMU */
+static void
+qemuSaveImageParallelRead(void *opaque)
+{
+    qemuSaveImageChannel *chan = opaque;
+    qemuSaveImageParallel *p = chan->parallel;
+    g_autofree char *buf = g_new0(char, QEMU_SAVE_PARALLEL_CHUNK_SIZE);
+    size_t i;
+
+    for (i = 0; i < p->nchunks; i++) {
+        qemuSaveImageChunk *chunk = &p->chunks[i];
+
+        if (chunk->channel != chan->id)
+            continue;
+
+        if (qemuSaveImagePRead(p->fd, buf, chunk->length, chunk->offset) < 0 ||
+            safewrite(chan->sock, buf, chunk->length) < 0) {
+            qemuSaveImageParallelFail(p, errno);
+            shutdown(chan->sock, SHUT_RDWR);
+            return;
+        }
+    }
+
+    shutdown(chan->sock, SHUT_WR);
+}
+
+
+static int
+qemuSaveImageSocketAddr(const char *path,
+                        struct sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (virStrcpyStatic(addr->sun_path, path) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("UNIX socket path '%s' too long"), path);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+qemuSaveImageListen(const char *path,
+                    int backlog)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (qemuSaveImageSocketAddr(path, &addr) < 0)
+        return -1;
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to create UNIX socket"));
+        return -1;
+    }
+
+    if (unlink(path) < 0 && errno != ENOENT) {
+        virReportSystemError(errno, _("Unable to unlink %s"), path);
+        goto error;
+    }
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        virReportSystemError(errno,
+                             _("Unable to bind to UNIX socket path '%s'"),
+                             path);
+        goto error;
+    }
+
+    if (listen(fd, backlog) < 0) {
+        virReportSystemError(errno,
+                             _("Unable to listen to UNIX socket path '%s'"),
+                             path);
+        goto error;
+    }
+
+    return fd;
+
+ error:
+    VIR_FORCE_CLOSE(fd);
+    return -1;
+}
+
+
+static int
+qemuSaveImageConnect(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (qemuSaveImageSocketAddr(path, &addr) < 0)
+        return -1;
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to create UNIX socket"));
+        return -1;
+    }
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        virReportSystemError(errno,
+                             _("Unable to connect to UNIX socket path '%s'"),
+                             path);
+        VIR_FORCE_CLOSE(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/* Migrates the domain into a parallel save image. Expects @fd to point
+ * right after the domain XML and fills in the chunk count in @data. */
+static int
+qemuSaveImageCreateParallel(virQEMUDriver *driver,
+                            virDomainObj *vm,
+                            int fd,
+                            const char *path,
+                            virQEMUSaveData *data,
+                            qemuDomainAsyncJob asyncJob)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    unsigned int channels = data->header.channels;
+    g_autoptr(qemuSaveImageParallel) p = NULL;
+    g_autofree qemuSaveImageChunk *index = NULL;
+    off_t start;
+    size_t i;
+    int rc;
+    int ret = -1;
+
+    if ((start = lseek(fd, 0, SEEK_CUR)) < 0) {
+        virReportSystemError(errno, _("unable to seek in '%s'"), path);
+        return -1;
+    }
+
+    if (!(p = qemuSaveImageParallelNew(fd, channels + 1)))
+        return -1;
+
+    p->end = start;
+    p->sockpath = g_strdup_printf("%s/save.sock", priv->libDir);
+
+    if (qemuSecuritySetSocketLabel(driver->securityManager, vm->def) < 0)
+        return -1;
+    p->listenfd = qemuSaveImageListen(p->sockpath, p->nchannels);
+    if (qemuSecurityClearSocketLabel(driver->securityManager, vm->def) < 0 ||
+        p->listenfd < 0)
+        goto cleanup;
+
+    if (virThreadCreateFull(&p->acceptThread, true,
+                            qemuSaveImageParallelAccept,
+                            "qemu-save-accept", false, p) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("unable to create thread for parallel save"));
+        goto cleanup;
+    }
+    p->acceptStarted = true;
+
+    rc = qemuMigrationSrcToSocket(driver, vm, p->sockpath, channels, asyncJob);
+
+    qemuSaveImageParallelStop(p, rc < 0);
+    qemuSaveImageParallelJoin(p);
+
+    if (rc < 0)
+        goto cleanup;
+
+    if (p->err != 0) {
+        virReportSystemError(p->err,
+                             _("failed to write domain save file '%s'"),
+                             path);
+        goto cleanup;
+    }
+
+    index = g_new0(qemuSaveImageChunk, p->nchunks);
+    for (i = 0; i < p->nchunks; i++) {
+        index[i].offset = GUINT64_TO_LE(p->chunks[i].offset);
+        index[i].length = GUINT64_TO_LE(p->chunks[i].length);
+        index[i].channel = GUINT32_TO_LE(p->chunks[i].channel);
+    }
+
+    if (qemuSaveImagePWrite(fd, (const char *)index,
+                            sizeof(*index) * p->nchunks, p->end) < 0) {
+        virReportSystemError(errno,
+                             _("failed to write chunk index to '%s'"),
+                             path);
+        goto cleanup;
+    }
+
+    data->header.nchunks = p->nchunks;
+    ret = 0;
+
+ cleanup:
+    if (unlink(p->sockpath) < 0 && errno != ENOENT)
+        VIR_WARN("Unable to remove %s", p->sockpath);
+    return ret;
+}
+
+
+static qemuSaveImageParallel *
+qemuSaveImageParallelLoad(int fd,
+                          const char *path,
+                          virQEMUSaveHeader *header)
+{
+    g_autoptr(qemuSaveImageParallel) p = NULL;
+    size_t indexLen = sizeof(qemuSaveImageChunk) * header->nchunks;
+    uint64_t dataEnd;
+    struct stat sb;
+    size_t i;
+
+    if (fstat(fd, &sb) < 0) {
+        virReportSystemError(errno, _("cannot stat file '%s'"), path);
+        return NULL;
+    }
+
+    /* QEMU limits the number of multifd channels to 255 */
+    if (header->compressed != QEMU_SAVE_FORMAT_RAW ||
+        header->channels == 0 || header->channels > UINT8_MAX ||
+        sb.st_size < 0 || (uint64_t) sb.st_size < indexLen)
+        goto invalid;
+
+    dataEnd = sb.st_size - indexLen;
+
+    if (!(p = qemuSaveImageParallelNew(fd, header->channels + 1)))
+        return NULL;
+
+    p->chunks = g_new0(qemuSaveImageChunk, header->nchunks);
+    p->nchunks = p->nchunks_max = header->nchunks;
+
+    if (qemuSaveImagePRead(fd, (char *)p->chunks, indexLen, dataEnd) < 0) {
+        virReportSystemError(errno,
+                             _("failed to read chunk index from '%s'"),
+                             path);
+        return NULL;
+    }
+
+    for (i = 0; i < p->nchunks; i++) {
+        qemuSaveImageChunk *chunk = &p->chunks[i];
+
+        chunk->offset = GUINT64_FROM_LE(chunk->offset);
+        chunk->length = GUINT64_FROM_LE(chunk->length);
+        chunk->channel = GUINT32_FROM_LE(chunk->channel);
+
+        if (chunk->channel >= p->nchannels ||
+            chunk->length > QEMU_SAVE_PARALLEL_CHUNK_SIZE ||
+            chunk->offset > dataEnd ||
+            chunk->length > dataEnd - chunk->offset)
+            goto invalid;
+    }
+
+    return g_steal_pointer(&p);
+
+ invalid:
+    virReportError(VIR_ERR_OPERATION_FAILED,
+                   _("invalid layout of parallel save image '%s'"), path);
+    return NULL;
+}
+
+
+static int
+qemuSaveImageParallelConnect(virDomainObj *vm G_GNUC_UNUSED,
+                             void *opaque)
+{
+    qemuSaveImageParallel *p = opaque;
+    size_t i;
+
+    /* QEMU expects the main channel to connect first */
+    for (i = 0; i < p->nchannels; i++) {
+        qemuSaveImageChannel *chan = &p->channels[i];
+
+        if ((chan->sock = qemuSaveImageConnect(p->sockpath)) < 0)
+            return -1;
+
+        if (virThreadCreateFull(&chan->thread, true,
+                                qemuSaveImageParallelRead,
+                                "qemu-restore-read", false, chan) < 0) {
+            virReportSystemError(errno, "%s",
+                                 _("unable to create thread for parallel restore"));
+            return -1;
+        }
+        chan->started = true;
+    }
+
+    return 0;
+}
+
+
+/* Starts QEMU for incoming migration from a parallel save image with the
+ * migration stream fed by a thread per channel reading the corresponding
+ * chunks of the image. */
+static int
+qemuSaveImageStartProcessParallel(virConnectPtr conn,
+                                  virQEMUDriver *driver,
+                                  virDomainObj *vm,
+                                  virCPUDef *updatedCPU,
+                                  virQEMUSaveData *data,
+                                  const char *path,
+                                  qemuDomainAsyncJob asyncJob)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autoptr(qemuSaveImageParallel) p = NULL;
+    qemuProcessIncomingFeed feed = { 0 };
+    g_autofree char *uri = NULL;
+    VIR_AUTOCLOSE fd = -1;
+    int rc;
+
+    if ((fd = qemuDomainOpenFile(driver, NULL, path, O_RDONLY, NULL)) < 0)
+        return -1;
+
+    if (!(p = qemuSaveImageParallelLoad(fd, path, &data->header)))
+        return -1;
+
+    /* the socket lives in the private directory which is normally
+     * set up only while starting the process */
+    if (qemuDomainSetPrivatePaths(driver, vm) < 0)
+        return -1;
+
+    p->sockpath = g_strdup_printf("%s/restore.sock", priv->libDir);
+    uri = g_strdup_printf("unix:%s", p->sockpath);
+
+    feed.channels = data->header.channels;
+    feed.func = qemuSaveImageParallelConnect;
+    feed.opaque = p;
+
+    rc = qemuProcessStart(conn, driver, vm, updatedCPU, asyncJob,
+                          uri, -1, NULL, &feed, NULL,
+                          VIR_NETDEV_VPORT_PROFILE_OP_RESTORE,
+                          VIR_QEMU_PROCESS_START_PAUSED |
+                          VIR_QEMU_PROCESS_START_GEN_VMID);
+
+    qemuSaveImageParallelStop(p, rc < 0);
+    qemuSaveImageParallelJoin(p);
+
+    if (rc < 0 && p->err != 0)
+        virReportSystemError(p->err,
+                             _("failed to read domain save file '%s'"),
+                             path);
+
+    return rc;
+}
+
+
 /* Helper function to execute a migration to file with a correct save header
  * the caller needs to make sure that the processors are stopped and do all other
  * actions besides saving memory */
@@ -268,6 +910,21 @@ qemuSaveImageCreate(virQEMUDriver *driver,
     int directFlag = 0;
     virFileWrapperFd *wrapperFd = NULL;
     unsigned int wrapperFlags = VIR_FILE_WRAPPER_NON_BLOCKING;
+    bool parallel = false;
+
+    if (cfg->saveImageBypassCache)
+        flags |= VIR_DOMAIN_SAVE_BYPASS_CACHE;
+
+    if (!compressor && !(flags & VIR_DOMAIN_SAVE_BYPASS_CACHE) &&
+        cfg->saveImageParallelChannels > 0) {
+        if (qemuMigrationCapsGet(vm, QEMU_MIGRATION_CAP_MULTIFD)) {
+            parallel = true;
+            data->header.version = QEMU_SAVE_VERSION_PARALLEL;
+            data->header.channels = cfg->saveImageParallelChannels;
+        } else {
+            VIR_DEBUG("QEMU does not support multifd, saving a single stream");
+        }
+    }
 
     /* Obtain the file handle.  */
     if ((flags & VIR_DOMAIN_SAVE_BYPASS_CACHE)) {
@@ -289,6 +946,24 @@ qemuSaveImageCreate(virQEMUDriver *driver,
     if (qemuSecuritySetImageFDLabel(driver->securityManager, vm->def, fd) < 0)
         goto cleanup;
 
+    if (parallel) {
+        if (virQEMUSaveDataWrite(data, fd, path) < 0 ||
+            qemuSaveImageCreateParallel(driver, vm, fd, path, data, asyncJob) < 0)
+            goto cleanup;
+
+        /* The header is rewritten in place with the chunk count filled in */
+        if (lseek(fd, 0, SEEK_SET) < 0) {
+            virReportSystemError(errno, _("unable to seek in '%s'"), path);
+            goto cleanup;
+        }
+
+        if (virQEMUSaveDataFinish(data, &fd, path) < 0)
+            goto cleanup;
+
+        ret = 0;
+        goto cleanup;
+    }
+
     if (!(wrapperFd = virFileWrapperFdNew(&fd, path, wrapperFlags)))
         goto cleanup;
 
@@ -379,6 +1054,12 @@ qemuSaveImageGetCompressionProgram(const char *imageFormat,
     if (ret == QEMU_SAVE_FORMAT_XZ)
         virCommandAddArg(*compressor, "-3");
 
+    /* Unlike the other formats, zstd can compress a stream with as many
+     * worker threads as there are CPUs, and its output still decompresses
+     * with a single plain 'zstd -dc'. */
+    if (ret == QEMU_SAVE_FORMAT_ZSTD)
+        virCommandAddArg(*compressor, "-T0");
+
     return ret;
 
  error:
@@ -413,6 +1094,43 @@ qemuSaveImageGetCompressionProgram(const char *imageFormat,
 }
 
 
+/* Replaces @fd with a file wrapper reading the rest of the image from
+ * the current position using @oflags which request direct I/O. */
+static int
+qemuSaveImageOpenDirect(virQEMUDriver *driver,
+                        const char *path,
+                        int oflags,
+                        int *fd,
+                        virFileWrapperFd **wrapperFd)
+{
+    VIR_AUTOCLOSE directfd = -1;
+    off_t pos;
+
+    if ((pos = lseek(*fd, 0, SEEK_CUR)) < 0) {
+        virReportSystemError(errno, _("unable to seek in '%s'"), path);
+        return -1;
+    }
+
+    if ((directfd = qemuDomainOpenFile(driver, NULL, path, oflags, NULL)) < 0)
+        return -1;
+
+    if (lseek(directfd, pos, SEEK_SET) < 0) {
+        virReportSystemError(errno, _("unable to seek in '%s'"), path);
+        return -1;
+    }
+
+    if (!(*wrapperFd = virFileWrapperFdNew(&directfd, path,
+                                           VIR_FILE_WRAPPER_BYPASS_CACHE)))
+        return -1;
+
+    VIR_FORCE_CLOSE(*fd);
+    *fd = directfd;
+    directfd = -1;
+
+    return 0;
+}
+
+
 /**
  * qemuSaveImageOpen:
  * @driver: qemu driver data
@@ -420,7 +1138,8 @@ qemuSaveImageGetCompressionProgram(const char *imageFormat,
  * @path: path of the save image
  * @ret_def: returns domain definition created from the XML stored in the image
  * @ret_data: returns structure filled with data from the image header
- * @bypass_cache: bypass cache when opening the file
+ * @bypass_cache: bypass cache when reading the migration stream, implied by
+ *                save_image_bypass_cache in qemu.conf if @wrapperFd is given
  * @wrapperFd: returns the file wrapper structure
  * @open_write: open the file for writing (for updates)
  * @unlink_corrupt: remove the image file if it is corrupted
@@ -445,28 +1164,29 @@ qemuSaveImageOpen(virQEMUDriver *driver,
     g_autoptr(virQEMUSaveData) data = NULL;
     virQEMUSaveHeader *header;
     g_autoptr(virDomainDef) def = NULL;
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
     int oflags = open_write ? O_RDWR : O_RDONLY;
+    int directFlag = 0;
     size_t xml_len;
     size_t cookie_len;
 
+    if (wrapperFd && cfg->saveImageBypassCache)
+        bypass_cache = true;
+
     if (bypass_cache) {
-        int directFlag = virFileDirectFdFlag();
+        directFlag = virFileDirectFdFlag();
         if (directFlag < 0) {
             virReportError(VIR_ERR_OPERATION_FAILED, "%s",
                            _("bypass cache unsupported by this system"));
             return -1;
         }
-        oflags |= directFlag;
     }
 
+    /* The header and domain XML are read through the cache, only the
+     * migration stream following them bypasses it */
     if ((fd = qemuDomainOpenFile(driver, NULL, path, oflags, NULL)) < 0)
         return -1;
 
-    if (bypass_cache &&
-        !(*wrapperFd = virFileWrapperFdNew(&fd, path,
-                                           VIR_FILE_WRAPPER_BYPASS_CACHE)))
-        return -1;
-
     data = g_new0(virQEMUSaveData, 1);
 
     header = &data->header;
@@ -510,15 +1230,15 @@ qemuSaveImageOpen(virQEMUDriver *driver,
         return -1;
     }
 
-    if (header->version > QEMU_SAVE_VERSION) {
+    if (header->version > QEMU_SAVE_VERSION_PARALLEL) {
         /* convert endianness and try again */
         qemuSaveImageBswapHeader(header);
     }
 
-    if (header->version > QEMU_SAVE_VERSION) {
+    if (header->version > QEMU_SAVE_VERSION_PARALLEL) {
         virReportError(VIR_ERR_OPERATION_FAILED,
                        _("image version is not supported (%d > %d)"),
-                       header->version, QEMU_SAVE_VERSION);
+                       header->version, QEMU_SAVE_VERSION_PARALLEL);
         return -1;
     }
 
@@ -559,6 +1279,17 @@ qemuSaveImageOpen(virQEMUDriver *driver,
                                         VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE)))
         return -1;
 
+    if (bypass_cache) {
+        if (header->version == QEMU_SAVE_VERSION_PARALLEL) {
+            /* Channels of parallel images are read directly by
+             * qemuSaveImageStartVM */
+            VIR_DEBUG("Not bypassing cache for parallel save image '%s'", path);
+        } else if (qemuSaveImageOpenDirect(driver, path, oflags | directFlag,
+                                           &fd, wrapperFd) < 0) {
+            return -1;
+        }
+    }
+
     *ret_def = g_steal_pointer(&def);
     *ret_data = g_steal_pointer(&data);
 
@@ -594,7 +1325,7 @@ qemuSaveImageStartVM(virConnectPtr conn,
                                  virDomainXMLOptionGetSaveCookie(driver->xmlopt)) < 0)
         goto cleanup;
 
-    if ((header->version == 2) &&
+    if ((header->version >= 2) &&
         (header->compressed != QEMU_SAVE_FORMAT_RAW)) {
         if (!(cmd = qemuSaveImageGetCompressionCommand(header->compressed)))
             goto cleanup;
@@ -624,12 +1355,18 @@ qemuSaveImageStartVM(virConnectPtr conn,
     if (cookie && !cookie->slirpHelper)
         priv->disableSlirp = true;
 
-    if (qemuProcessStart(conn, driver, vm, cookie ? cookie->cpu : NULL,
-                         asyncJob, "stdio", *fd, path, NULL,
-                         VIR_NETDEV_VPORT_PROFILE_OP_RESTORE,
-                         VIR_QEMU_PROCESS_START_PAUSED |
-                         VIR_QEMU_PROCESS_START_GEN_VMID) == 0)
+    if (header->version == QEMU_SAVE_VERSION_PARALLEL) {
+        if (qemuSaveImageStartProcessParallel(conn, driver, vm,
+                                              cookie ? cookie->cpu : NULL,
+                                              data, path, asyncJob) == 0)
+            started = true;
+    } else if (qemuProcessStart(conn, driver, vm, cookie ? cookie->cpu : NULL,
+                                asyncJob, "stdio", *fd, path, NULL, NULL,
+                                VIR_NETDEV_VPORT_PROFILE_OP_RESTORE,
+                                VIR_QEMU_PROCESS_START_PAUSED |
+                                VIR_QEMU_PROCESS_START_GEN_VMID) == 0) {
         started = true;
+    }
 
     if (intermediatefd != -1) {
         virErrorPtr orig_err = NULL;
@@ -31,6 +31,8 @@
 #define QEMU_SAVE_MAGIC   "LibvirtQemudSave"
 #define QEMU_SAVE_PARTIAL "LibvirtQemudPart"
 #define QEMU_SAVE_VERSION 2
+/* images containing parallel (multifd) migration streams */
+#define QEMU_SAVE_VERSION_PARALLEL 3
 
 G_STATIC_ASSERT(sizeof(QEMU_SAVE_MAGIC) == sizeof(QEMU_SAVE_PARTIAL));
 
@@ -42,7 +44,9 @@ struct _virQEMUSaveHeader {
     uint32_t was_running;
     uint32_t compressed;
     uint32_t cookieOffset;
-    uint32_t unused[14];
+    uint32_t channels; /* multifd channels of a parallel image */
+    uint32_t nchunks; /* entries in the chunk index of a parallel image */
+    uint32_t unused[12];
 };
 
 
@@ -103,6 +107,11 @@ virQEMUSaveDataWrite(virQEMUSaveData *data,
                      int fd,
                      const char *path);
 
+int
+virQEMUSaveDataFinish(virQEMUSaveData *data,
+                      int *fd,
+                      const char *path);
+
 virQEMUSaveData *
 virQEMUSaveDataNew(char *domXML,
                    qemuDomainSaveCookie *cookieObj,
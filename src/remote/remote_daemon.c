@@ -986,6 +986,14 @@ int main(int argc, char **argv) {
         }
     }
 
+    /* Only now, as the writer thread would not survive the fork above */
+    if (config->log_async &&
+        virLogSetAsync(true) < 0) {
+        VIR_ERROR(_("Can't enable asynchronous logging: %s"),
+                  virGetLastErrorMessage());
+        goto cleanup;
+    }
+
     /* Try to claim the pidfile, exiting if we can't */
     if ((pid_file_fd = virPidFileAcquirePath(pid_file, false, getpid())) < 0) {
         ret = VIR_DAEMON_ERR_PIDFILE;
@@ -1235,6 +1243,9 @@ int main(int argc, char **argv) {
     virObjectUnref(srv);
     virObjectUnref(dmn);
 
+    /* Write out the messages still queued for the log writer thread */
+    virLogSetAsync(false);
+
     virNetlinkShutdown();
 
     if (pid_file_fd != -1)
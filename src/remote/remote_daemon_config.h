@@ -78,6 +78,7 @@ struct daemonConfig {
     unsigned int log_level;
     char *log_filters;
     char *log_outputs;
+    bool log_async;
 
     unsigned int audit_level;
     bool audit_logging;
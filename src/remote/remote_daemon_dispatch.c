@@ -7250,6 +7250,47 @@ remoteDispatchDomainGetGuestInfo(virNetServer *server G_GNUC_UNUSED,
     return rv;
 }
 
+static int
+remoteDispatchStoragePoolListAllVolumesInfo(virNetServer *server G_GNUC_UNUSED,
+                                            virNetServerClient *client,
+                                            virNetMessage *msg G_GNUC_UNUSED,
+                                            struct virNetMessageError *rerr,
+                                            remote_storage_pool_list_all_volumes_info_args *args,
+                                            remote_storage_pool_list_all_volumes_info_ret *ret)
+{
+    int rv = -1;
+    virConnectPtr conn = remoteGetStorageConn(client);
+    virStoragePoolPtr pool = NULL;
+    virTypedParameterPtr params = NULL;
+    int nparams = 0;
+
+    if (!conn)
+        goto cleanup;
+
+    if (!(pool = get_nonnull_storage_pool(conn, args->pool)))
+        goto cleanup;
+
+    if (virStoragePoolListAllVolumesInfo(pool, &params, &nparams, args->flags) < 0)
+        goto cleanup;
+
+    if (virTypedParamsSerialize(params, nparams,
+                                REMOTE_STORAGE_POOL_VOLUMES_INFO_PARAMS_MAX,
+                                (struct _virTypedParameterRemote **) &ret->params.params_val,
+                                &ret->params.params_len,
+                                VIR_TYPED_PARAM_STRING_OKAY) < 0)
+        goto cleanup;
+
+    rv = 0;
+
+ cleanup:
+    if (rv < 0)
+        virNetMessageSaveError(rerr);
+    virTypedParamsFree(params, nparams);
+    virObjectUnref(pool);
+
+    return rv;
+}
+
 static int
 remoteDispatchDomainAuthorizedSshKeysGet(virNetServer *server G_GNUC_UNUSED,
                                          virNetServerClient *client,
@@ -7976,6 +7976,47 @@ remoteDomainGetGuestInfo(virDomainPtr dom,
     return rv;
 }
 
+static int
+remoteStoragePoolListAllVolumesInfo(virStoragePoolPtr pool,
+                                    virTypedParameterPtr *params,
+                                    int *nparams,
+                                    unsigned int flags)
+{
+    int rv = -1;
+    struct private_data *priv = pool->conn->privateData;
+    remote_storage_pool_list_all_volumes_info_args args;
+    remote_storage_pool_list_all_volumes_info_ret ret;
+
+    remoteDriverLock(priv);
+
+    make_nonnull_storage_pool(&args.pool, pool);
+    args.flags = flags;
+
+    memset(&ret, 0, sizeof(ret));
+
+    if (call(pool->conn, priv, 0, REMOTE_PROC_STORAGE_POOL_LIST_ALL_VOLUMES_INFO,
+             (xdrproc_t)xdr_remote_storage_pool_list_all_volumes_info_args, (char *)&args,
+             (xdrproc_t)xdr_remote_storage_pool_list_all_volumes_info_ret, (char *)&ret) == -1)
+        goto done;
+
+    if (virTypedParamsDeserialize((struct _virTypedParameterRemote *) ret.params.params_val,
+                                  ret.params.params_len,
+                                  REMOTE_STORAGE_POOL_VOLUMES_INFO_PARAMS_MAX,
+                                  params,
+                                  nparams) < 0)
+        goto cleanup;
+
+    rv = 0;
+
+ cleanup:
+    xdr_free((xdrproc_t)xdr_remote_storage_pool_list_all_volumes_info_ret,
+             (char *) &ret);
+
+ done:
+    remoteDriverUnlock(priv);
+    return rv;
+}
+
 static int
 remoteDomainAuthorizedSSHKeysGet(virDomainPtr domain,
                                  const char *user,
@@ -8621,6 +8662,7 @@ static virStorageDriver storage_driver = {
     .storagePoolNumOfVolumes = remoteStoragePoolNumOfVolumes, /* 0.4.1 */
     .storagePoolListVolumes = remoteStoragePoolListVolumes, /* 0.4.1 */
     .storagePoolListAllVolumes = remoteStoragePoolListAllVolumes, /* 0.10.0 */
+    .storagePoolListAllVolumesInfo = remoteStoragePoolListAllVolumesInfo, /* 7.7.0 */
 
     .storageVolLookupByName = remoteStorageVolLookupByName, /* 0.4.1 */
     .storageVolLookupByKey = remoteStorageVolLookupByKey, /* 0.4.1 */
@@ -286,6 +286,11 @@ const REMOTE_DOMAIN_AUTHORIZED_SSH_KEYS_MAX = 2048;
 /* Upper limit on number of messages */
 const REMOTE_DOMAIN_MESSAGES_MAX = 2048;
 
+/* Upper limit on number of parameters describing volumes of a pool:
+ * 5 per volume for up to REMOTE_STORAGE_VOL_LIST_MAX volumes and the
+ * count itself */
+const REMOTE_STORAGE_POOL_VOLUMES_INFO_PARAMS_MAX = 81921;
+
 
 /* UUID.  VIR_UUID_BUFLEN definition comes from libvirt.h */
 typedef opaque remote_uuid[VIR_UUID_BUFLEN];
@@ -3003,6 +3008,15 @@ struct remote_storage_pool_list_all_volumes_ret { /* insert@1 */
     unsigned int ret;
 };
 
+struct remote_storage_pool_list_all_volumes_info_args {
+    remote_nonnull_storage_pool pool;
+    unsigned int flags;
+};
+
+struct remote_storage_pool_list_all_volumes_info_ret {
+    remote_typed_param params<REMOTE_STORAGE_POOL_VOLUMES_INFO_PARAMS_MAX>;
+};
+
 struct remote_connect_list_all_networks_args {
     int need_results;
     unsigned int flags;
@@ -6784,6 +6798,14 @@ enum remote_procedure {
      * @priority: high
      * @acl: node_device:start
      */
-    REMOTE_PROC_NODE_DEVICE_CREATE = 430
+    REMOTE_PROC_NODE_DEVICE_CREATE = 430,
+
+    /**
+     * @generate: none
+     * @priority: high
+     * @acl: storage_pool:search_storage_vols
+     * @aclfilter: storage_vol:getattr
+     */
+    REMOTE_PROC_STORAGE_POOL_LIST_ALL_VOLUMES_INFO = 431
 
 };
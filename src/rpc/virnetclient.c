@@ -1149,7 +1149,7 @@ virNetClientCallDispatchReply(virNetClient *client)
         return -1;
     }
 
-    VIR_REALLOC_N(thecall->msg->buffer, client->msg.bufferLength);
+    virNetMessageBufferReserve(thecall->msg, client->msg.bufferLength);
 
     memcpy(thecall->msg->buffer, client->msg.buffer, client->msg.bufferLength);
     memcpy(&thecall->msg->header, &client->msg.header, sizeof(client->msg.header));
@@ -1416,7 +1416,7 @@ virNetClientIOReadMessage(virNetClient *client)
     /* Start by reading length word */
     if (client->msg.bufferLength == 0) {
         client->msg.bufferLength = 4;
-        client->msg.buffer = g_new0(char, client->msg.bufferLength);
+        virNetMessageBufferReserve(&client->msg, client->msg.bufferLength);
     }
 
     wantData = client->msg.bufferLength - client->msg.bufferOffset;
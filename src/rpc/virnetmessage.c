@@ -29,11 +29,169 @@
 #include "virfile.h"
 #include "virutil.h"
 #include "virstring.h"
+#include "virthread.h"
 
 #define VIR_FROM_THIS VIR_FROM_RPC
 
 VIR_LOG_INIT("rpc.netmessage");
 
+/*
+ * Message buffers are recycled through a process wide pool with a few
+ * size classes, VIR_NET_MESSAGE_INITIAL growing by a factor of 4, so
+ * that steady RPC traffic doesn't allocate and free a buffer of up to
+ * several megabytes for every single message. Free buffers of a class
+ * are chained through the pointer stored at their beginning. Each
+ * class keeps at most VIR_NET_MESSAGE_BUFFER_CLASS_BYTES worth of
+ * buffers, anything else goes back to the heap.
+ */
+#define VIR_NET_MESSAGE_BUFFER_CLASSES 4
+#define VIR_NET_MESSAGE_BUFFER_CLASS_BYTES (8 * 1024 * 1024)
+
+typedef struct _virNetMessageBufferClass virNetMessageBufferClass;
+struct _virNetMessageBufferClass {
+    char *head;
+    size_t count;
+};
+
+static virMutex virNetMessageBufferLock = VIR_MUTEX_INITIALIZER;
+static virNetMessageBufferClass virNetMessageBufferPool[VIR_NET_MESSAGE_BUFFER_CLASSES];
+static virNetMessageBufferStats virNetMessageBufferPoolStats;
+
+
+static size_t
+virNetMessageBufferClassSize(size_t cls)
+{
+    return ((size_t) VIR_NET_MESSAGE_INITIAL << (2 * cls)) +
+        VIR_NET_MESSAGE_LEN_MAX;
+}
+
+
+static char *
+virNetMessageBufferGet(size_t len,
+                       size_t *alloc)
+{
+    virNetMessageBufferClass *pool;
+    char *buf;
+    size_t cls;
+
+    for (cls = 0; cls < VIR_NET_MESSAGE_BUFFER_CLASSES; cls++) {
+        if (len <= virNetMessageBufferClassSize(cls))
+            break;
+    }
+
+    if (cls == VIR_NET_MESSAGE_BUFFER_CLASSES) {
+        virMutexLock(&virNetMessageBufferLock);
+        virNetMessageBufferPoolStats.misses++;
+        virMutexUnlock(&virNetMessageBufferLock);
+
+        *alloc = len;
+        return g_new(char, len);
+    }
+
+    pool = &virNetMessageBufferPool[cls];
+    *alloc = virNetMessageBufferClassSize(cls);
+
+    virMutexLock(&virNetMessageBufferLock);
+    if ((buf = pool->head)) {
+        memcpy(&pool->head, buf, sizeof(pool->head));
+        pool->count--;
+        virNetMessageBufferPoolStats.hits++;
+        virNetMessageBufferPoolStats.pooled--;
+        virNetMessageBufferPoolStats.pooledBytes -= *alloc;
+    } else {
+        virNetMessageBufferPoolStats.misses++;
+    }
+    virMutexUnlock(&virNetMessageBufferLock);
+
+    if (!buf)
+        buf = g_new(char, *alloc);
+
+    return buf;
+}
+
+
+static void
+virNetMessageBufferPut(char *buf,
+                       size_t alloc)
+{
+    virNetMessageBufferClass *pool = NULL;
+    size_t cls;
+
+    if (!buf)
+        return;
+
+    for (cls = 0; cls < VIR_NET_MESSAGE_BUFFER_CLASSES; cls++) {
+        if (alloc == virNetMessageBufferClassSize(cls)) {
+            pool = &virNetMessageBufferPool[cls];
+            break;
+        }
+    }
+
+    virMutexLock(&virNetMessageBufferLock);
+    if (pool &&
+        (pool->count + 1) * alloc <= VIR_NET_MESSAGE_BUFFER_CLASS_BYTES) {
+        memcpy(buf, &pool->head, sizeof(pool->head));
+        pool->head = g_steal_pointer(&buf);
+        pool->count++;
+        virNetMessageBufferPoolStats.recycled++;
+        virNetMessageBufferPoolStats.pooled++;
+        virNetMessageBufferPoolStats.pooledBytes += alloc;
+    } else if (alloc) {
+        virNetMessageBufferPoolStats.discarded++;
+    }
+    virMutexUnlock(&virNetMessageBufferLock);
+
+    g_free(buf);
+}
+
+
+/**
+ * virNetMessageBufferReserve:
+ * @msg: the message
+ * @len: the number of bytes needed
+ *
+ * Make sure the buffer of @msg can hold at least @len bytes while
+ * preserving its current content. Buffers are taken from and later
+ * returned to the pool of message buffers, so callers must not free or
+ * reallocate @msg->buffer behind its back. A buffer not allocated by
+ * this function is simply reallocated, as before.
+ */
+void
+virNetMessageBufferReserve(virNetMessage *msg,
+                           size_t len)
+{
+    char *buf;
+    size_t alloc;
+
+    if (msg->buffer && msg->bufferAlloc == 0) {
+        VIR_REALLOC_N(msg->buffer, len);
+        return;
+    }
+
+    if (msg->buffer && len <= msg->bufferAlloc)
+        return;
+
+    buf = virNetMessageBufferGet(len, &alloc);
+
+    if (msg->buffer) {
+        memcpy(buf, msg->buffer, msg->bufferAlloc);
+        virNetMessageBufferPut(msg->buffer, msg->bufferAlloc);
+    }
+
+    msg->buffer = buf;
+    msg->bufferAlloc = alloc;
+}
+
+
+void
+virNetMessageGetBufferStats(virNetMessageBufferStats *stats)
+{
+    virMutexLock(&virNetMessageBufferLock);
+    *stats = virNetMessageBufferPoolStats;
+    virMutexUnlock(&virNetMessageBufferLock);
+}
+
+
 virNetMessage *virNetMessageNew(bool tracked)
 {
     virNetMessage *msg;
@@ -61,7 +219,8 @@ virNetMessageClearPayload(virNetMessage *msg)
 
     msg->bufferOffset = 0;
     msg->bufferLength = 0;
-    VIR_FREE(msg->buffer);
+    virNetMessageBufferPut(g_steal_pointer(&msg->buffer), msg->bufferAlloc);
+    msg->bufferAlloc = 0;
 }
 
 
@@ -151,7 +310,7 @@ int virNetMessageDecodeLength(virNetMessage *msg)
     /* Extend our declared buffer length and carry
        on reading the header + payload */
     msg->bufferLength += len;
-    VIR_REALLOC_N(msg->buffer, msg->bufferLength);
+    virNetMessageBufferReserve(msg, msg->bufferLength);
 
     VIR_DEBUG("Got length, now need %zu total (%u more)",
               msg->bufferLength, len);
@@ -227,7 +386,7 @@ int virNetMessageEncodeHeader(virNetMessage *msg)
     unsigned int len = 0;
 
     msg->bufferLength = VIR_NET_MESSAGE_INITIAL + VIR_NET_MESSAGE_LEN_MAX;
-    VIR_REALLOC_N(msg->buffer, msg->bufferLength);
+    virNetMessageBufferReserve(msg, msg->bufferLength);
     msg->bufferOffset = 0;
 
     /* Format the header. */
@@ -367,7 +526,7 @@ int virNetMessageEncodePayload(virNetMessage *msg,
 
         msg->bufferLength = newlen + VIR_NET_MESSAGE_LEN_MAX;
 
-        VIR_REALLOC_N(msg->buffer, msg->bufferLength);
+        virNetMessageBufferReserve(msg, msg->bufferLength);
 
         xdrmem_create(&xdr, msg->buffer + msg->bufferOffset,
                       msg->bufferLength - msg->bufferOffset, XDR_ENCODE);
@@ -450,7 +609,7 @@ int virNetMessageEncodePayloadRaw(virNetMessage *msg,
 
         msg->bufferLength = msg->bufferOffset + len;
 
-        VIR_REALLOC_N(msg->buffer, msg->bufferLength);
+        virNetMessageBufferReserve(msg, msg->bufferLength);
 
         VIR_DEBUG("Increased message buffer length = %zu", msg->bufferLength);
     }
@@ -33,6 +33,8 @@ struct _virNetMessage {
                   /* Maximum   VIR_NET_MESSAGE_MAX     + VIR_NET_MESSAGE_LEN_MAX */
     size_t bufferLength;
     size_t bufferOffset;
+    size_t bufferAlloc; /* size of @buffer if obtained by
+                           virNetMessageBufferReserve, 0 otherwise */
 
     virNetMessageHeader header;
 
@@ -47,8 +49,25 @@ struct _virNetMessage {
 };
 
 
+typedef struct _virNetMessageBufferStats virNetMessageBufferStats;
+struct _virNetMessageBufferStats {
+    unsigned long long hits; /* buffers reused from the pool */
+    unsigned long long misses; /* buffers allocated from the heap */
+    unsigned long long recycled; /* buffers returned to the pool */
+    unsigned long long discarded; /* buffers freed rather than pooled */
+    unsigned long long pooled; /* buffers currently in the pool */
+    unsigned long long pooledBytes; /* total size of pooled buffers */
+};
+
 virNetMessage *virNetMessageNew(bool tracked);
 
+void virNetMessageBufferReserve(virNetMessage *msg,
+                                size_t len)
+    ATTRIBUTE_NONNULL(1);
+
+void virNetMessageGetBufferStats(virNetMessageBufferStats *stats)
+    ATTRIBUTE_NONNULL(1);
+
 void virNetMessageClearPayload(virNetMessage *msg);
 
 void virNetMessageClear(virNetMessage *);
@@ -219,7 +219,7 @@ virNetServerDispatchNewMessage(virNetServerClient *client,
             priority = virNetServerProgramGetPriority(prog, msg->header.proc);
         }
 
-        if (virThreadPoolSendJob(srv->workers, priority, job) < 0) {
+        if (virThreadPoolSendJobFull(srv->workers, priority, client, job) < 0) {
             virObjectUnref(client);
             VIR_FREE(job);
             virObjectUnref(prog);
@@ -992,6 +992,19 @@ virNetServerGetThreadPoolParameters(virNetServer *srv,
     return 0;
 }
 
+size_t
+virNetServerGetClientJobQueueDepth(virNetServer *srv,
+                                   virNetServerClient *client)
+{
+    size_t ret;
+
+    virObjectLock(srv);
+    ret = virThreadPoolGetOwnerJobQueueDepth(srv->workers, client);
+    virObjectUnlock(srv);
+
+    return ret;
+}
+
 int
 virNetServerSetThreadPoolParameters(virNetServer *srv,
                                     long long int minWorkers,
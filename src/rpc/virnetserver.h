@@ -110,6 +110,9 @@ int virNetServerGetThreadPoolParameters(virNetServer *srv,
                                         size_t *nPrioWorkers,
                                         size_t *jobQueueDepth);
 
+size_t virNetServerGetClientJobQueueDepth(virNetServer *srv,
+                                          virNetServerClient *client);
+
 int virNetServerSetThreadPoolParameters(virNetServer *srv,
                                         long long int minWorkers,
                                         long long int maxWorkers,
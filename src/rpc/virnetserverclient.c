@@ -309,7 +309,7 @@ virNetServerClientCheckAccess(virNetServerClient *client)
      * (NB. The '\1' byte is sent in an encrypted record).
      */
     confirm->bufferLength = 1;
-    confirm->buffer = g_new0(char, confirm->bufferLength);
+    virNetMessageBufferReserve(confirm, confirm->bufferLength);
     confirm->bufferOffset = 0;
     confirm->buffer[0] = '\1';
 
@@ -409,7 +409,7 @@ virNetServerClientNewInternal(unsigned long long id,
     if (!(client->rx = virNetMessageNew(true)))
         goto error;
     client->rx->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
-    client->rx->buffer = g_new0(char, client->rx->bufferLength);
+    virNetMessageBufferReserve(client->rx, client->rx->bufferLength);
     client->nrequests = 1;
 
     PROBE(RPC_SERVER_CLIENT_NEW,
@@ -1293,7 +1293,7 @@ static virNetMessage *virNetServerClientDispatchRead(virNetServerClient *client)
                 client->wantClose = true;
             } else {
                 client->rx->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
-                client->rx->buffer = g_new0(char, client->rx->bufferLength);
+                virNetMessageBufferReserve(client->rx, client->rx->bufferLength);
                 client->nrequests++;
             }
         }
@@ -1304,9 +1304,16 @@ static virNetMessage *virNetServerClientDispatchRead(virNetServerClient *client)
 }
 
 
+/* Maximum number of queued messages written at once */
+#define VIR_NET_SERVER_CLIENT_TX_VEC_MAX 64
+
 /*
  * Send client->tx using no encoding
  *
+ * Messages queued after the first one are written along with it, up to
+ * the first message which passes file descriptors or enables SASL, as
+ * neither must be overtaken by data of the following messages.
+ *
  * Returns:
  *   -1 on error or EOF
  *    0 on EAGAIN
@@ -1314,6 +1321,10 @@ static virNetMessage *virNetServerClientDispatchRead(virNetServerClient *client)
  */
 static ssize_t virNetServerClientWrite(virNetServerClient *client)
 {
+    GOutputVector vec[VIR_NET_SERVER_CLIENT_TX_VEC_MAX];
+    size_t nvec = 0;
+    virNetMessage *msg;
+    size_t done;
     ssize_t ret;
 
     if (client->tx->bufferLength < client->tx->bufferOffset) {
@@ -1327,13 +1338,38 @@ static ssize_t virNetServerClientWrite(virNetServerClient *client)
     if (client->tx->bufferLength == client->tx->bufferOffset)
         return 1;
 
-    ret = virNetSocketWrite(client->sock,
-                            client->tx->buffer + client->tx->bufferOffset,
-                            client->tx->bufferLength - client->tx->bufferOffset);
+    for (msg = client->tx; msg && nvec < G_N_ELEMENTS(vec); msg = msg->next) {
+        if (msg->bufferOffset < msg->bufferLength) {
+            vec[nvec].buffer = msg->buffer + msg->bufferOffset;
+            vec[nvec].size = msg->bufferLength - msg->bufferOffset;
+            nvec++;
+        }
+
+        if (msg->nfds > 0)
+            break;
+#if WITH_SASL
+        if (client->sasl)
+            break;
+#endif
+    }
+
+    ret = virNetSocketWriteVec(client->sock, vec, nvec);
     if (ret <= 0)
         return ret; /* -1 error, 0 = egain */
 
-    client->tx->bufferOffset += ret;
+    done = ret;
+    for (msg = client->tx; msg && done > 0; msg = msg->next) {
+        size_t len;
+
+        if (msg->bufferOffset >= msg->bufferLength)
+            continue;
+
+        len = MIN(done, msg->bufferLength - msg->bufferOffset);
+
+        msg->bufferOffset += len;
+        done -= len;
+    }
+
     return ret;
 }
 
@@ -1394,7 +1430,7 @@ virNetServerClientDispatchWrite(virNetServerClient *client)
                     /* Ready to recv more messages */
                     virNetMessageClear(msg);
                     msg->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
-                    msg->buffer = g_new0(char, msg->bufferLength);
+                    virNetMessageBufferReserve(msg, msg->bufferLength);
                     client->rx = g_steal_pointer(&msg);
                     client->nrequests++;
                 }
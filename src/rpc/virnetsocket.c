@@ -37,6 +37,10 @@
 # include <selinux/selinux.h>
 #endif
 
+#ifndef WIN32
+# include <sys/uio.h>
+#endif
+
 #include "virsocket.h"
 #include "virnetsocket.h"
 #include "virutil.h"
@@ -62,6 +66,13 @@
 
 VIR_LOG_INIT("rpc.netsocket");
 
+/* Maximum number of buffers passed to a single writev() */
+#define VIR_NET_SOCKET_WRITEV_MAX 64
+
+/* Maximum payload of a TLS record, smaller buffers are coalesced
+ * up to this size so that they're sent in a single record */
+#define VIR_NET_SOCKET_TLS_RECORD_MAX 16384
+
 struct _virNetSocket {
     virObjectLockable parent;
 
@@ -86,6 +97,7 @@ struct _virNetSocket {
     char *remoteAddrStrURI;
 
     virNetTLSSession *tlsSession;
+    char *tlsCoalesced; /* VIR_NET_SOCKET_TLS_RECORD_MAX bytes */
 #if WITH_SASL
     virNetSASLSession *saslSession;
 
@@ -1346,6 +1358,7 @@ void virNetSocketDispose(void *obj)
     g_free(sock->localAddrStrSASL);
     g_free(sock->remoteAddrStrSASL);
     g_free(sock->remoteAddrStrURI);
+    g_free(sock->tlsCoalesced);
 }
 
 
@@ -1990,6 +2003,126 @@ ssize_t virNetSocketWrite(virNetSocket *sock, const char *buf, size_t len)
 }
 
 
+static ssize_t
+virNetSocketWriteVecTLS(virNetSocket *sock,
+                        const GOutputVector *vec,
+                        size_t nvec)
+{
+    size_t len = 0;
+    size_t i;
+
+    /* Large enough buffer fills a record on its own */
+    if (vec[0].size >= VIR_NET_SOCKET_TLS_RECORD_MAX)
+        return virNetSocketWriteWire(sock, vec[0].buffer, vec[0].size);
+
+    /* If the write doesn't complete, the TLS session keeps the record and
+     * sends it on the next call. That's fine because the data is only
+     * ever appended to, so the next call starts with the same bytes. */
+    if (!sock->tlsCoalesced)
+        sock->tlsCoalesced = g_new0(char, VIR_NET_SOCKET_TLS_RECORD_MAX);
+
+    for (i = 0; i < nvec && len < VIR_NET_SOCKET_TLS_RECORD_MAX; i++) {
+        size_t n = MIN(vec[i].size, VIR_NET_SOCKET_TLS_RECORD_MAX - len);
+
+        memcpy(sock->tlsCoalesced + len, vec[i].buffer, n);
+        len += n;
+    }
+
+    return virNetSocketWriteWire(sock, sock->tlsCoalesced, len);
+}
+
+
+static ssize_t
+virNetSocketWriteVecWire(virNetSocket *sock,
+                         const GOutputVector *vec,
+                         size_t nvec)
+{
+#ifndef WIN32
+    struct iovec iov[VIR_NET_SOCKET_WRITEV_MAX];
+    ssize_t ret;
+    size_t i;
+#endif
+
+#if WITH_SSH2
+    if (sock->sshSession)
+        return virNetSocketWriteWire(sock, vec[0].buffer, vec[0].size);
+#endif
+
+#if WITH_LIBSSH
+    if (sock->libsshSession)
+        return virNetSocketWriteWire(sock, vec[0].buffer, vec[0].size);
+#endif
+
+    if (sock->tlsSession &&
+        virNetTLSSessionGetHandshakeStatus(sock->tlsSession) ==
+        VIR_NET_TLS_HANDSHAKE_COMPLETE)
+        return virNetSocketWriteVecTLS(sock, vec, nvec);
+
+#ifndef WIN32
+    nvec = MIN(nvec, G_N_ELEMENTS(iov));
+    for (i = 0; i < nvec; i++) {
+        iov[i].iov_base = (void *) vec[i].buffer;
+        iov[i].iov_len = vec[i].size;
+    }
+
+ rewrite:
+    ret = writev(sock->fd, iov, nvec);
+
+    if (ret < 0) {
+        if (errno == EINTR)
+            goto rewrite;
+        if (errno == EAGAIN)
+            return 0;
+
+        virReportSystemError(errno, "%s",
+                             _("Cannot write data"));
+        return -1;
+    }
+    if (ret == 0) {
+        virReportSystemError(EIO, "%s",
+                             _("End of file while writing data"));
+        return -1;
+    }
+
+    return ret;
+#else /* WIN32 */
+    return virNetSocketWriteWire(sock, vec[0].buffer, vec[0].size);
+#endif /* WIN32 */
+}
+
+
+/**
+ * virNetSocketWriteVec:
+ * @sock: the socket
+ * @vec: buffers to write
+ * @nvec: number of buffers in @vec, must be at least 1
+ *
+ * Write as much as possible of the data in @vec, in order, as if the
+ * buffers were concatenated. Plain sockets write several buffers with
+ * a single syscall and for TLS small buffers are coalesced into a
+ * single record. Other transports write at most the first buffer.
+ *
+ * Returns number of bytes written, 0 if the write would block or -1
+ * on error.
+ */
+ssize_t virNetSocketWriteVec(virNetSocket *sock,
+                             const GOutputVector *vec,
+                             size_t nvec)
+{
+    ssize_t ret;
+
+    virObjectLock(sock);
+#if WITH_SASL
+    if (sock->saslSession)
+        ret = virNetSocketWriteSASL(sock, vec[0].buffer, vec[0].size);
+    else
+#endif
+        ret = virNetSocketWriteVecWire(sock, vec, nvec);
+    virObjectUnlock(sock);
+    return ret;
+}
+
+
 /*
  * Returns 1 if an FD was sent, 0 if it would block, -1 on error
  */
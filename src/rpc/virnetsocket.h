@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include <gio/gio.h>
+
 #include "virsocketaddr.h"
 #include "vircommand.h"
 #include "virnettlscontext.h"
@@ -144,6 +146,9 @@ void virNetSocketSetQuietEOF(virNetSocket *sock);
 
 ssize_t virNetSocketRead(virNetSocket *sock, char *buf, size_t len);
 ssize_t virNetSocketWrite(virNetSocket *sock, const char *buf, size_t len);
+ssize_t virNetSocketWriteVec(virNetSocket *sock,
+                             const GOutputVector *vec,
+                             size_t nvec);
 
 int virNetSocketSendFD(virNetSocket *sock, int fd);
 int virNetSocketRecvFD(virNetSocket *sock, int *fd);
@@ -50,6 +50,7 @@
 #include "viraccessapicheck.h"
 #include "storage_util.h"
 #include "virutil.h"
+#include "virtypedparam.h"
 
 #define VIR_FROM_THIS VIR_FROM_STORAGE
 
@@ -98,12 +99,16 @@ storagePoolRefreshImpl(virStorageBackend *backend,
                        virStoragePoolObj *obj,
                        const char *stateFile)
 {
-    virStoragePoolObjClearVols(obj);
+    /* Keep the old volumes around so that backends can reuse the
+     * definitions of volumes which did not change since last time */
+    ignore_value(virStoragePoolObjStashVols(obj));
     if (backend->refreshPool(obj) < 0) {
+        virStoragePoolObjDropStashedVols(obj);
         storagePoolRefreshFailCleanup(backend, obj, stateFile);
         return -1;
     }
 
+    virStoragePoolObjDropStashedVols(obj);
     return 0;
 }
 
@@ -1524,6 +1529,96 @@ storagePoolListAllVolumes(virStoragePoolPtr pool,
     return ret;
 }
 
+
+struct storagePoolListAllVolumesInfoData {
+    virConnectPtr conn;
+    virStoragePoolDef *def;
+    virTypedParamList *params;
+    unsigned int nvols;
+    bool error;
+};
+
+
+static int
+storagePoolListAllVolumesInfoIter(virStorageVolDef *voldef,
+                                  const void *opaque)
+{
+    struct storagePoolListAllVolumesInfoData *data = (void *)opaque;
+    unsigned int n = data->nvols;
+
+    if (data->error ||
+        !virStoragePoolListAllVolumesInfoCheckACL(data->conn, data->def, voldef))
+        return 0;
+
+    if (virTypedParamListAddString(data->params, voldef->name,
+                                   "vol.%u.name", n) < 0 ||
+        virTypedParamListAddString(data->params, voldef->target.path,
+                                   "vol.%u.path", n) < 0 ||
+        virTypedParamListAddInt(data->params, voldef->type,
+                                "vol.%u.type", n) < 0 ||
+        virTypedParamListAddULLong(data->params, voldef->target.capacity,
+                                   "vol.%u.capacity", n) < 0 ||
+        virTypedParamListAddULLong(data->params, voldef->target.allocation,
+                                   "vol.%u.allocation", n) < 0) {
+        data->error = true;
+        return -1;
+    }
+
+    data->nvols++;
+    return 0;
+}
+
+
+static int
+storagePoolListAllVolumesInfo(virStoragePoolPtr pool,
+                              virTypedParameterPtr *params,
+                              int *nparams,
+                              unsigned int flags)
+{
+    virStoragePoolObj *obj;
+    virStoragePoolDef *def;
+    g_autoptr(virTypedParamList) list = g_new0(virTypedParamList, 1);
+    struct storagePoolListAllVolumesInfoData data = { 0 };
+    int ret = -1;
+
+    virCheckFlags(0, -1);
+
+    if (!(obj = virStoragePoolObjFromStoragePool(pool)))
+        return -1;
+    def = virStoragePoolObjGetDef(obj);
+
+    if (virStoragePoolListAllVolumesInfoEnsureACL(pool->conn, def) < 0)
+        goto cleanup;
+
+    if (!virStoragePoolObjIsActive(obj)) {
+        virReportError(VIR_ERR_OPERATION_INVALID,
+                       _("storage pool '%s' is not active"), def->name);
+        goto cleanup;
+    }
+
+    /* Report straight from the volume definitions, without creating
+     * a volume object or refreshing each volume like
+     * virStorageVolGetInfo() would */
+    data.conn = pool->conn;
+    data.def = def;
+    data.params = list;
+
+    if (virStoragePoolObjForEachVolume(obj, storagePoolListAllVolumesInfoIter,
+                                       &data) < 0 ||
+        data.error)
+        goto cleanup;
+
+    if (virTypedParamListAddUInt(list, data.nvols, "vol.count") < 0)
+        goto cleanup;
+
+    *nparams = virTypedParamListStealParams(list, params);
+    ret = 0;
+
+ cleanup:
+    virStoragePoolObjEndAPI(&obj);
+    return ret;
+}
+
 static virStorageVolPtr
 storageVolLookupByName(virStoragePoolPtr pool,
                        const char *name)
@@ -2867,6 +2962,7 @@ static virStorageDriver storageDriver = {
     .storagePoolNumOfVolumes = storagePoolNumOfVolumes, /* 0.4.0 */
     .storagePoolListVolumes = storagePoolListVolumes, /* 0.4.0 */
     .storagePoolListAllVolumes = storagePoolListAllVolumes, /* 0.10.2 */
+    .storagePoolListAllVolumesInfo = storagePoolListAllVolumesInfo, /* 7.7.0 */
 
     .storageVolLookupByName = storageVolLookupByName, /* 0.4.0 */
     .storageVolLookupByKey = storageVolLookupByKey, /* 0.4.0 */
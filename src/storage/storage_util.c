@@ -124,12 +124,207 @@ reflinkCloneFile(int dest_fd G_GNUC_UNUSED,
 #endif
 
 
+#ifdef __linux__
+/* Largest chunk handed to the kernel by a single copy call */
+# define COPY_RANGE_CHUNK_SIZE (1024 * 1024 * 1024)
+
+/*
+ * Move up to @len bytes from @inputfd at *@inoff to @fd at *@outoff
+ * inside the kernel, advancing both offsets. copy_file_range() is
+ * preferred as it lets the filesystem share extents or offload the copy;
+ * if it can't handle this pair of files *@use_splice is set and the data
+ * is spliced through @pipefd instead (opened on first use).
+ *
+ * Returns the number of bytes copied, 0 on EOF of @inputfd or -1 with
+ * errno set.
+ */
+static ssize_t
+storageBackendCopyRange(int inputfd,
+                        off_t *inoff,
+                        int fd,
+                        off_t *outoff,
+                        size_t len,
+                        int pipefd[2],
+                        bool *use_splice)
+{
+    ssize_t got;
+    ssize_t left;
+
+# if WITH_COPY_FILE_RANGE
+    if (!*use_splice) {
+        got = copy_file_range(inputfd, inoff, fd, outoff, len, 0);
+        if (got >= 0 ||
+            (errno != ENOSYS && errno != EXDEV &&
+             errno != EINVAL && errno != EOPNOTSUPP))
+            return got;
+
+        VIR_DEBUG("copy_file_range not usable, falling back to splice: %s",
+                  g_strerror(errno));
+        *use_splice = true;
+    }
+# endif /* WITH_COPY_FILE_RANGE */
+
+    if (pipefd[0] < 0 && virPipeQuiet(pipefd) < 0)
+        return -1;
+
+    if ((got = splice(inputfd, inoff, pipefd[1], NULL, len, SPLICE_F_MOVE)) <= 0)
+        return got;
+
+    for (left = got; left > 0;) {
+        ssize_t put = splice(pipefd[0], NULL, fd, outoff, left, SPLICE_F_MOVE);
+
+        if (put < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        left -= put;
+    }
+
+    return got;
+}
+
+
+/*
+ * Copy up to *@total bytes from the start of @inputfd to the current
+ * position in @fd without bouncing the data through userspace. Only the
+ * data extents reported by SEEK_DATA/SEEK_HOLE are copied and holes are
+ * left untouched in @fd, so the time taken is bounded by the allocated
+ * size of the input rather than its capacity. Since the filesystem may
+ * share extents between the files, this must only be used for sparse
+ * copies. *@total is decreased by the number of bytes covered.
+ *
+ * Returns 0 on success, 1 if the kernel can't copy between these files
+ * and nothing was written (the caller should use plain read/write then),
+ * -1 on error with error reported.
+ */
+static int
+storageBackendCopyExtents(virStorageVolDef *vol,
+                          virStorageVolDef *inputvol,
+                          int inputfd,
+                          int fd,
+                          unsigned long long *total)
+{
+    int pipefd[2] = { -1, -1 };
+    bool use_splice = false;
+    bool copied = false;
+    off_t offset = 0;
+    off_t base;
+    off_t end;
+    int ret = -1;
+
+    if ((base = lseek(fd, 0, SEEK_CUR)) < 0 ||
+        (end = lseek(inputfd, 0, SEEK_END)) < 0) {
+        ret = 1;
+        goto cleanup;
+    }
+
+    if ((unsigned long long) end > *total)
+        end = *total;
+
+    while (offset < end) {
+        off_t extent_end = end;
+        off_t inoff;
+        off_t outoff;
+
+# if WITH_DECL_SEEK_HOLE
+        off_t data = lseek(inputfd, offset, SEEK_DATA);
+
+        /* ENXIO means there's only a hole up to EOF, any other error
+         * that the file doesn't know about holes so copy everything */
+        if (data < 0 && errno == ENXIO)
+            break;
+
+        if (data >= 0) {
+            off_t hole;
+
+            if ((offset = data) >= end)
+                break;
+
+            if ((hole = lseek(inputfd, offset, SEEK_HOLE)) > offset &&
+                hole < end)
+                extent_end = hole;
+        }
+# endif /* WITH_DECL_SEEK_HOLE */
+
+        inoff = offset;
+        outoff = base + offset;
+
+        while (inoff < extent_end) {
+            ssize_t got = storageBackendCopyRange(inputfd, &inoff, fd, &outoff,
+                                                  MIN(extent_end - inoff,
+                                                      COPY_RANGE_CHUNK_SIZE),
+                                                  pipefd, &use_splice);
+
+            if (got < 0) {
+                if (errno == EINTR)
+                    continue;
+
+                if (!copied &&
+                    (errno == ENOSYS || errno == EINVAL ||
+                     errno == EXDEV || errno == EOPNOTSUPP)) {
+                    VIR_DEBUG("in-kernel copy not usable: %s",
+                              g_strerror(errno));
+                    ret = 1;
+                    goto cleanup;
+                }
+
+                virReportSystemError(errno,
+                                     _("failed copying from '%s' to '%s'"),
+                                     inputvol->target.path, vol->target.path);
+                goto cleanup;
+            }
+
+            /* the input was truncated under us */
+            if (got == 0) {
+                end = inoff;
+                break;
+            }
+
+            copied = true;
+        }
+
+        offset = extent_end;
+    }
+
+    *total -= end;
+    ret = 0;
+
+ cleanup:
+    /* the read/write fallback expects to start at the beginning */
+    if (ret == 1 && lseek(inputfd, 0, SEEK_SET) < 0) {
+        virReportSystemError(errno,
+                             _("cannot seek in file '%s'"),
+                             inputvol->target.path);
+        ret = -1;
+    }
+    VIR_FORCE_CLOSE(pipefd[0]);
+    VIR_FORCE_CLOSE(pipefd[1]);
+    return ret;
+}
+
+#else /* !__linux__ */
+
+static int
+storageBackendCopyExtents(virStorageVolDef *vol G_GNUC_UNUSED,
+                          virStorageVolDef *inputvol G_GNUC_UNUSED,
+                          int inputfd G_GNUC_UNUSED,
+                          int fd G_GNUC_UNUSED,
+                          unsigned long long *total G_GNUC_UNUSED)
+{
+    return 1;
+}
+
+#endif /* !__linux__ */
+
+
 static int ATTRIBUTE_NONNULL(2)
 virStorageBackendCopyToFD(virStorageVolDef *vol,
                           virStorageVolDef *inputvol,
                           int fd,
                           unsigned long long *total,
                           bool want_sparse,
+                          bool sparse_target,
                           bool reflink_copy)
 {
     int amtread = -1;
@@ -137,7 +332,6 @@ virStorageBackendCopyToFD(virStorageVolDef *vol,
     int wbytes = 0;
     int interval;
     struct stat st;
-    g_autofree char *zerobuf = NULL;
     g_autofree char *buf = NULL;
     VIR_AUTOCLOSE inputfd = -1;
 
@@ -157,8 +351,6 @@ virStorageBackendCopyToFD(virStorageVolDef *vol,
     if (wbytes < WRITE_BLOCK_SIZE_DEFAULT)
         wbytes = WRITE_BLOCK_SIZE_DEFAULT;
 
-    zerobuf = g_new0(char, wbytes);
-
     buf = g_new0(char, rbytes);
 
     if (reflink_copy) {
@@ -173,6 +365,21 @@ virStorageBackendCopyToFD(virStorageVolDef *vol,
         }
     }
 
+    /* an in-kernel copy may reflink the data or leave holes, undoing
+     * any preallocation of a non-sparse volume */
+    if (sparse_target) {
+        switch (storageBackendCopyExtents(vol, inputvol, inputfd, fd, total)) {
+        case 0:
+            VIR_DEBUG("in-kernel copy finished.");
+            amtread = 0;
+            break;
+        case 1:
+            break;
+        default:
+            return -1;
+        }
+    }
+
     while (amtread != 0) {
         int amtleft;
 
@@ -194,7 +401,7 @@ virStorageBackendCopyToFD(virStorageVolDef *vol,
             int offset = amtread - amtleft;
             interval = ((wbytes > amtleft) ? amtleft : wbytes);
 
-            if (want_sparse && memcmp(buf+offset, zerobuf, interval) == 0) {
+            if (want_sparse && virStringBufferIsZero(buf+offset, interval)) {
                 if (lseek(fd, interval, SEEK_CUR) < 0) {
                     virReportSystemError(errno,
                                          _("cannot extend file '%s'"),
@@ -266,7 +473,7 @@ storageBackendCreateBlockFrom(virStoragePoolObj *pool G_GNUC_UNUSED,
 
     if (inputvol) {
         if (virStorageBackendCopyToFD(vol, inputvol, fd, &remain,
-                                      false, reflink_copy) < 0)
+                                      false, false, reflink_copy) < 0)
             return -1;
     }
 
@@ -312,13 +519,16 @@ createRawFile(int fd, virStorageVolDef *vol,
               bool reflink_copy)
 {
     bool need_alloc = true;
+    bool sparse = false;
     unsigned long long pos = 0;
 
     /* If the new allocation is lower than the capacity of the original file,
      * the cloned volume will be sparse */
     if (inputvol &&
-        vol->target.allocation < inputvol->target.capacity)
+        vol->target.allocation < inputvol->target.capacity) {
         need_alloc = false;
+        sparse = true;
+    }
 
     /* Seek to the final size, so the capacity is available upfront
      * for progress reporting */
@@ -356,7 +566,7 @@ createRawFile(int fd, virStorageVolDef *vol,
          * allocation (allocation < capacity) or we have already
          * been able to allocate the required space. */
         if (virStorageBackendCopyToFD(vol, inputvol, fd, &remain,
-                                      !need_alloc, reflink_copy) < 0)
+                                      !need_alloc, sparse, reflink_copy) < 0)
             return -1;
 
         /* If the new allocation is greater than the original capacity,
@@ -2576,6 +2786,96 @@ storageBackendVolZeroSparseFileLocal(const char *path,
 }
 
 
+/*
+ * Let the kernel zero @len bytes of @fd starting at @offset. Block
+ * devices are asked to BLKZEROOUT the range, which is turned into WRITE
+ * ZEROES (or a discard which guarantees zeroed reads) where supported
+ * and into in-kernel writes otherwise. On filesystems the range is
+ * converted into unwritten extents, or punched out like
+ * storageBackendVolZeroSparseFileLocal does for sparse files.
+ *
+ * Returns 0 on success, 1 if no such method is usable for @fd (and
+ * nothing was changed), -1 on error with error reported.
+ */
+#ifdef __linux__
+static int
+storageBackendWipeLocalOffload(const char *path,
+                               int fd,
+                               off_t offset,
+                               unsigned long long len)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) < 0)
+        return 1;
+
+# ifdef BLKZEROOUT
+    if (S_ISBLK(st.st_mode)) {
+        uint64_t range[2] = { offset, len };
+
+        if (ioctl(fd, BLKZEROOUT, range) == 0) {
+            VIR_DEBUG("Zeroed %llu bytes of '%s' with BLKZEROOUT", len, path);
+            return 0;
+        }
+
+        /* EINVAL covers ranges not aligned to the logical block size */
+        if (errno != ENOTTY && errno != EINVAL && errno != EOPNOTSUPP) {
+            virReportSystemError(errno,
+                                 _("Failed to zero %llu bytes of "
+                                   "storage volume with path '%s'"),
+                                 len, path);
+            return -1;
+        }
+
+        VIR_DEBUG("BLKZEROOUT not usable for '%s': %s",
+                  path, g_strerror(errno));
+        return 1;
+    }
+# endif /* BLKZEROOUT */
+
+# if WITH_FALLOCATE - 0 && defined(FALLOC_FL_ZERO_RANGE) && \
+    defined(FALLOC_FL_PUNCH_HOLE)
+    if (S_ISREG(st.st_mode)) {
+        int rc = fallocate(fd, FALLOC_FL_ZERO_RANGE, offset, len);
+
+        /* Unlike zeroing, punching a hole never extends the file */
+        if (rc < 0 && (errno == EOPNOTSUPP || errno == ENOSYS) &&
+            (unsigned long long) (st.st_size - offset) >= len)
+            rc = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                           offset, len);
+
+        if (rc == 0) {
+            VIR_DEBUG("Zeroed %llu bytes of '%s' with fallocate", len, path);
+            return 0;
+        }
+
+        if (errno != EOPNOTSUPP && errno != ENOSYS) {
+            virReportSystemError(errno,
+                                 _("Failed to zero %llu bytes of "
+                                   "storage volume with path '%s'"),
+                                 len, path);
+            return -1;
+        }
+
+        VIR_DEBUG("fallocate can't zero '%s': %s", path, g_strerror(errno));
+        return 1;
+    }
+# endif /* WITH_FALLOCATE */
+
+    return 1;
+}
+#else /* !__linux__ */
+static int
+storageBackendWipeLocalOffload(const char *path G_GNUC_UNUSED,
+                               int fd G_GNUC_UNUSED,
+                               off_t offset G_GNUC_UNUSED,
+                               unsigned long long len G_GNUC_UNUSED)
+{
+    return 1;
+}
+#endif /* !__linux__ */
+
+
 static int
 storageBackendWipeLocal(const char *path,
                         int fd,
@@ -2586,8 +2886,7 @@ storageBackendWipeLocal(const char *path,
     unsigned long long remaining = 0;
     off_t size;
     g_autofree char *writebuf = NULL;
-
-    writebuf = g_new0(char, writebuf_length);
+    int rc;
 
     if (!zero_end) {
         if ((size = lseek(fd, 0, SEEK_SET)) < 0) {
@@ -2609,7 +2908,14 @@ storageBackendWipeLocal(const char *path,
 
     VIR_DEBUG("wiping start: %zd len: %llu", (ssize_t)size, wipe_len);
 
-    remaining = wipe_len;
+    if ((rc = storageBackendWipeLocalOffload(path, fd, size, wipe_len)) < 0)
+        return -1;
+
+    if (rc > 0) {
+        remaining = wipe_len;
+        writebuf = g_new0(char, writebuf_length);
+    }
+
     while (remaining > 0) {
         size_t write_size = MIN(writebuf_length, remaining);
         int written = safewrite(fd, writebuf, write_size);
@@ -3564,9 +3870,84 @@ virStorageBackendRefreshVolTargetUpdate(virStorageVolDef *vol)
 }
 
 
+static bool
+storageBackendTimespecEqual(const struct timespec *a,
+                            const struct timespec *b)
+{
+    return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+
+/*
+ * storageBackendRefreshLocalReuse:
+ * @pool: pool being refreshed
+ * @path: path of the directory entry
+ *
+ * Look up the volume which was known under @path before the refresh
+ * started and hand it back if the file was not modified since it was
+ * last probed. Only the modification and change times along with the
+ * size are compared, which is what a write, truncate, chmod, chown,
+ * relabel or rename over the entry bump. Directories and ploop volumes
+ * are always probed again as their contents are not reflected there.
+ *
+ * Returns the reusable volume definition or NULL if the entry has to be
+ * probed.
+ */
+static virStorageVolDef *
+storageBackendRefreshLocalReuse(virStoragePoolObj *pool,
+                                const char *path)
+{
+    g_autoptr(virStorageVolDef) vol = NULL;
+    struct stat sb;
+    struct timespec modified;
+    struct timespec changed;
+
+    if (!(vol = virStoragePoolObjTakeStashedVol(pool, path)))
+        return NULL;
+
+    if (vol->type != VIR_STORAGE_VOL_FILE ||
+        !vol->target.timestamps ||
+        stat(path, &sb) < 0 ||
+        !S_ISREG(sb.st_mode) ||
+        (unsigned long long)sb.st_size != vol->target.physical)
+        return NULL;
+
+#ifdef __APPLE__
+    modified = sb.st_mtimespec;
+    changed = sb.st_ctimespec;
+#else
+    modified = sb.st_mtim;
+    changed = sb.st_ctim;
+#endif
+
+    if (!storageBackendTimespecEqual(&modified, &vol->target.timestamps->mtime) ||
+        !storageBackendTimespecEqual(&changed, &vol->target.timestamps->ctime))
+        return NULL;
+
+#ifdef __APPLE__
+    vol->target.timestamps->atime = sb.st_atimespec;
+#else
+    vol->target.timestamps->atime = sb.st_atim;
+#endif
+
+    /* The backing file lives outside of this entry, refresh it as
+     * virStorageBackendRefreshVolTargetUpdate() would */
+    if (virStorageSourceHasBacking(&vol->target))
+        ignore_value(storageBackendUpdateVolTargetInfo(VIR_STORAGE_VOL_FILE,
+                                                       vol->target.backingStore,
+                                                       false,
+                                                       VIR_STORAGE_VOL_OPEN_DEFAULT, 0));
+
+    return g_steal_pointer(&vol);
+}
+
+
 /**
  * Iterate over the pool's directory and enumerate all disk images
  * within it. This is non-recursive.
+ *
+ * Volumes known from the previous refresh whose files did not change
+ * since are reused as they are instead of being opened and probed again.
  */
 int
 virStorageBackendRefreshLocal(virStoragePoolObj *pool)
@@ -3585,6 +3966,7 @@ virStorageBackendRefreshLocal(virStoragePoolObj *pool)
         return -1;
 
     while ((direrr = virDirRead(dir, &ent, def->target.path)) > 0) {
+        g_autofree char *path = NULL;
         int err;
 
         if (virStringHasControlChars(ent->d_name)) {
@@ -3593,12 +3975,23 @@ virStorageBackendRefreshLocal(virStoragePoolObj *pool)
             continue;
         }
 
+        path = g_strdup_printf("%s/%s", def->target.path, ent->d_name);
+
+        if ((vol = storageBackendRefreshLocalReuse(pool, path))) {
+            VIR_DEBUG("Reusing unchanged volume '%s'", path);
+
+            if (virStoragePoolObjAddVol(pool, vol) < 0)
+                return -1;
+            vol = NULL;
+            continue;
+        }
+
         vol = g_new0(virStorageVolDef, 1);
 
         vol->name = g_strdup(ent->d_name);
 
         vol->type = VIR_STORAGE_VOL_FILE;
-        vol->target.path = g_strdup_printf("%s/%s", def->target.path, vol->name);
+        vol->target.path = g_steal_pointer(&path);
 
         vol->key = g_strdup(vol->target.path);
 
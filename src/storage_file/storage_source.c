@@ -22,12 +22,14 @@
 #include <config.h>
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "internal.h"
 #include "storage_file_backend.h"
 #include "storage_file_probe.h"
-#include "storage_source.h"
+#define LIBVIRT_STORAGE_SOURCE_PRIV_H_ALLOW
+#include "storage_source_priv.h"
 #include "storage_source_backingstore.h"
 #include "viralloc.h"
 #include "virerror.h"
@@ -37,6 +39,7 @@
 #include "virobject.h"
 #include "virstoragefile.h"
 #include "virstring.h"
+#include "virthread.h"
 #include "virutil.h"
 
 #define VIR_FROM_THIS VIR_FROM_STORAGE
@@ -1256,6 +1259,121 @@ virStorageSourceReportBrokenChain(int errcode,
 }
 
 
+/*
+ * Headers of local image files read while detecting backing chains are
+ * cached so that starting domains sharing base images doesn't need to
+ * read them over and over again. An entry is valid as long as the file
+ * keeps its size and modification times. Files changed within the last
+ * few seconds are not cached as a later modification might not change
+ * the timestamps. The cache is emptied when it gets full.
+ */
+#define VIR_STORAGE_SOURCE_HEADER_CACHE_MAX 256
+#define VIR_STORAGE_SOURCE_HEADER_CACHE_SETTLE 2
+
+typedef struct _virStorageSourceHeaderCacheEntry virStorageSourceHeaderCacheEntry;
+struct _virStorageSourceHeaderCacheEntry {
+    off_t size;
+    time_t mtime;
+    time_t ctime;
+    char *buf;
+    size_t len;
+};
+
+static virMutex virStorageSourceHeaderCacheLock = VIR_MUTEX_INITIALIZER;
+static GHashTable *virStorageSourceHeaderCache;
+
+
+static void
+virStorageSourceHeaderCacheEntryFree(void *opaque)
+{
+    virStorageSourceHeaderCacheEntry *entry = opaque;
+
+    g_free(entry->buf);
+    g_free(entry);
+}
+
+
+static char *
+virStorageSourceHeaderCacheKey(const struct stat *st,
+                               uid_t uid,
+                               gid_t gid)
+{
+    /* The image is read as @uid:@gid, so don't let others see it */
+    return g_strdup_printf("%llu:%llu:%u:%u",
+                           (unsigned long long)st->st_dev,
+                           (unsigned long long)st->st_ino,
+                           (unsigned int)uid, (unsigned int)gid);
+}
+
+
+bool
+virStorageSourceHeaderCacheLookup(const struct stat *st,
+                                  uid_t uid,
+                                  gid_t gid,
+                                  char **buf,
+                                  size_t *len)
+{
+    g_autofree char *key = virStorageSourceHeaderCacheKey(st, uid, gid);
+    virStorageSourceHeaderCacheEntry *entry;
+    bool ret = false;
+
+    virMutexLock(&virStorageSourceHeaderCacheLock);
+
+    if (virStorageSourceHeaderCache &&
+        (entry = virHashLookup(virStorageSourceHeaderCache, key)) &&
+        entry->size == st->st_size &&
+        entry->mtime == st->st_mtime &&
+        entry->ctime == st->st_ctime) {
+        *buf = g_new0(char, entry->len + 1);
+        memcpy(*buf, entry->buf, entry->len);
+        *len = entry->len;
+        ret = true;
+    }
+
+    virMutexUnlock(&virStorageSourceHeaderCacheLock);
+    return ret;
+}
+
+
+void
+virStorageSourceHeaderCacheStore(const struct stat *st,
+                                 uid_t uid,
+                                 gid_t gid,
+                                 const char *buf,
+                                 size_t len)
+{
+    g_autofree char *key = NULL;
+    virStorageSourceHeaderCacheEntry *entry;
+    gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+
+    if (st->st_mtime + VIR_STORAGE_SOURCE_HEADER_CACHE_SETTLE >= now ||
+        st->st_ctime + VIR_STORAGE_SOURCE_HEADER_CACHE_SETTLE >= now)
+        return;
+
+    key = virStorageSourceHeaderCacheKey(st, uid, gid);
+    entry = g_new0(virStorageSourceHeaderCacheEntry, 1);
+    entry->size = st->st_size;
+    entry->mtime = st->st_mtime;
+    entry->ctime = st->st_ctime;
+    entry->buf = g_new0(char, len + 1);
+    memcpy(entry->buf, buf, len);
+    entry->len = len;
+
+    virMutexLock(&virStorageSourceHeaderCacheLock);
+
+    if (!virStorageSourceHeaderCache)
+        virStorageSourceHeaderCache = virHashNew(virStorageSourceHeaderCacheEntryFree);
+
+    if (virHashSize(virStorageSourceHeaderCache) >= VIR_STORAGE_SOURCE_HEADER_CACHE_MAX)
+        virHashRemoveAll(virStorageSourceHeaderCache);
+
+    if (virHashUpdateEntry(virStorageSourceHeaderCache, key, entry) < 0)
+        virStorageSourceHeaderCacheEntryFree(entry);
+
+    virMutexUnlock(&virStorageSourceHeaderCacheLock);
+}
+
+
 static int
 virStorageSourceGetMetadataRecurseReadHeader(virStorageSource *src,
                                              virStorageSource *parent,
@@ -1266,6 +1384,8 @@ virStorageSourceGetMetadataRecurseReadHeader(virStorageSource *src,
 {
     int ret = -1;
     ssize_t len;
+    struct stat st;
+    bool cacheable = false;
 
     if (virStorageSourceInitAs(src, uid, gid) < 0)
         return -1;
@@ -1275,9 +1395,24 @@ virStorageSourceGetMetadataRecurseReadHeader(virStorageSource *src,
         goto cleanup;
     }
 
+    if (virStorageSourceGetActualType(src) == VIR_STORAGE_TYPE_FILE &&
+        virStorageSourceStat(src, &st) == 0 &&
+        S_ISREG(st.st_mode)) {
+        cacheable = true;
+
+        if (virStorageSourceHeaderCacheLookup(&st, uid, gid, buf, headerLen)) {
+            VIR_DEBUG("using cached header of '%s'", src->path);
+            ret = 0;
+            goto cleanup;
+        }
+    }
+
     if ((len = virStorageSourceRead(src, 0, VIR_STORAGE_MAX_HEADER, buf)) < 0)
         goto cleanup;
 
+    if (cacheable)
+        virStorageSourceHeaderCacheStore(&st, uid, gid, *buf, len);
+
     *headerLen = len;
     ret = 0;
 
@@ -1421,3 +1556,104 @@ virStorageSourceGetMetadata(virStorageSource *src,
     return virStorageSourceGetMetadataRecurse(src, src, uid, gid,
                                               report_broken, max_depth, 1);
 }
+
+
+#define VIR_STORAGE_SOURCE_PREFETCH_THREADS 8
+
+typedef struct _virStorageSourcePrefetch virStorageSourcePrefetch;
+struct _virStorageSourcePrefetch {
+    virMutex lock;
+    virStorageSourceMetadataRequest *reqs;
+    size_t nreqs;
+    size_t next;
+    size_t max_depth;
+};
+
+
+static void
+virStorageSourcePrefetchWorker(void *opaque)
+{
+    virStorageSourcePrefetch *prefetch = opaque;
+
+    while (true) {
+        virStorageSourceMetadataRequest *req;
+
+        virMutexLock(&prefetch->lock);
+        if (prefetch->next == prefetch->nreqs) {
+            virMutexUnlock(&prefetch->lock);
+            break;
+        }
+        req = &prefetch->reqs[prefetch->next++];
+        virMutexUnlock(&prefetch->lock);
+
+        if (req->src)
+            ignore_value(virStorageSourceGetMetadata(req->src, req->uid, req->gid,
+                                                     prefetch->max_depth, false));
+    }
+}
+
+
+/**
+ * virStorageSourcePrefetchMetadata:
+ * @reqs: sources to probe along with the IDs to access them with
+ * @nreqs: number of elements in @reqs
+ * @max_depth: maximum depth of the backing chains
+ *
+ * Reads the headers of backing chains of independent sources concurrently
+ * so that subsequent virStorageSourceGetMetadata calls on them can be
+ * served from the cache of image headers. The sources in @reqs are not
+ * modified and any failures are ignored.
+ */
+void
+virStorageSourcePrefetchMetadata(const virStorageSourceMetadataRequest *reqs,
+                                 size_t nreqs,
+                                 size_t max_depth)
+{
+    virStorageSourcePrefetch prefetch = { .nreqs = nreqs,
+                                          .max_depth = max_depth };
+    g_autofree virThread *threads = NULL;
+    size_t nthreads = MIN(nreqs, VIR_STORAGE_SOURCE_PREFETCH_THREADS);
+    virErrorPtr orig_err;
+    size_t started;
+    size_t i;
+
+    if (nreqs == 0)
+        return;
+
+    /* errors are reported when the chains are detected for real */
+    virErrorPreserveLast(&orig_err);
+
+    if (virMutexInit(&prefetch.lock) < 0) {
+        virErrorRestore(&orig_err);
+        return;
+    }
+
+    prefetch.reqs = g_new0(virStorageSourceMetadataRequest, nreqs);
+    for (i = 0; i < nreqs; i++) {
+        prefetch.reqs[i].src = virStorageSourceCopy(reqs[i].src, false);
+        prefetch.reqs[i].uid = reqs[i].uid;
+        prefetch.reqs[i].gid = reqs[i].gid;
+    }
+
+    /* the calling thread is one of the workers too */
+    threads = g_new0(virThread, nthreads);
+    for (started = 0; started < nthreads - 1; started++) {
+        if (virThreadCreateFull(&threads[started], true,
+                                virStorageSourcePrefetchWorker,
+                                "storage-prefetch", false, &prefetch) < 0)
+            break;
+    }
+
+    virStorageSourcePrefetchWorker(&prefetch);
+
+    for (i = 0; i < started; i++)
+        virThreadJoin(&threads[i]);
+
+    virResetLastError();
+    virErrorRestore(&orig_err);
+
+    for (i = 0; i < nreqs; i++)
+        virObjectUnref(prefetch.reqs[i].src);
+    g_free(prefetch.reqs);
+    virMutexDestroy(&prefetch.lock);
+}
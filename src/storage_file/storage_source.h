@@ -135,6 +135,18 @@ virStorageSourceGetMetadata(virStorageSource *src,
                             bool report_broken)
     ATTRIBUTE_NONNULL(1);
 
+typedef struct _virStorageSourceMetadataRequest virStorageSourceMetadataRequest;
+struct _virStorageSourceMetadataRequest {
+    virStorageSource *src;
+    uid_t uid;
+    gid_t gid;
+};
+
+void
+virStorageSourcePrefetchMetadata(const virStorageSourceMetadataRequest *reqs,
+                                 size_t nreqs,
+                                 size_t max_depth);
+
 int
 virStorageSourceFetchRelativeBackingPath(virStorageSource *src,
                                          char **relPath)
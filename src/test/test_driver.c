@@ -697,12 +697,14 @@ testDomainGenerateIfnames(virDomainDef *domdef)
 
 
 static void
-testDomainShutdownState(virDomainPtr domain,
+testDomainShutdownState(testDriver *privconn,
+                        virDomainPtr domain,
                         virDomainObj *privdom,
                         virDomainShutoffReason reason)
 {
     virDomainObjRemoveTransientDef(privdom);
     virDomainObjSetState(privdom, VIR_DOMAIN_SHUTOFF, reason);
+    virDomainObjListUpdateID(privconn->domains, privdom);
 
     if (domain)
         domain->id = -1;
@@ -718,6 +720,7 @@ testDomainStartState(testDriver *privconn,
 
     virDomainObjSetState(dom, VIR_DOMAIN_RUNNING, reason);
     dom->def->id = g_atomic_int_add(&privconn->nextDomID, 1);
+    virDomainObjListUpdateID(privconn->domains, dom);
 
     if (virDomainObjSetDefTransient(privconn->xmlopt,
                                     dom, NULL) < 0) {
@@ -728,7 +731,7 @@ testDomainStartState(testDriver *privconn,
     ret = 0;
  cleanup:
     if (ret < 0)
-        testDomainShutdownState(NULL, dom, VIR_DOMAIN_SHUTOFF_FAILED);
+        testDomainShutdownState(privconn, NULL, dom, VIR_DOMAIN_SHUTOFF_FAILED);
     return ret;
 }
 
@@ -964,7 +967,7 @@ testParseDomains(testDriver *privconn,
                                      VIR_DOMAIN_RUNNING_BOOTED) < 0)
                 goto error;
         } else {
-            testDomainShutdownState(NULL, obj, 0);
+            testDomainShutdownState(privconn, NULL, obj, 0);
         }
         virDomainObjSetState(obj, nsdata->runstate, 0);
 
@@ -1798,7 +1801,7 @@ static int testDomainDestroyFlags(virDomainPtr domain,
     if (virDomainObjCheckActive(privdom) < 0)
         goto cleanup;
 
-    testDomainShutdownState(domain, privdom, VIR_DOMAIN_SHUTOFF_DESTROYED);
+    testDomainShutdownState(privconn, domain, privdom, VIR_DOMAIN_SHUTOFF_DESTROYED);
     event = virDomainEventLifecycleNewFromObj(privdom,
                                      VIR_DOMAIN_EVENT_STOPPED,
                                      VIR_DOMAIN_EVENT_STOPPED_DESTROYED);
@@ -1934,7 +1937,7 @@ static int testDomainShutdownFlags(virDomainPtr domain,
     testDomainActionSetState(privdom, privdom->def->onPoweroff);
 
     if (virDomainObjGetState(privdom, NULL) == VIR_DOMAIN_SHUTOFF) {
-        testDomainShutdownState(domain, privdom, VIR_DOMAIN_SHUTOFF_SHUTDOWN);
+        testDomainShutdownState(privconn, domain, privdom, VIR_DOMAIN_SHUTOFF_SHUTDOWN);
         event = virDomainEventLifecycleNewFromObj(privdom,
                                                   VIR_DOMAIN_EVENT_STOPPED,
                                                   VIR_DOMAIN_EVENT_STOPPED_SHUTDOWN);
@@ -1980,7 +1983,7 @@ static int testDomainReboot(virDomainPtr domain,
     testDomainActionSetState(privdom, privdom->def->onReboot);
 
     if (virDomainObjGetState(privdom, NULL) == VIR_DOMAIN_SHUTOFF) {
-        testDomainShutdownState(domain, privdom, VIR_DOMAIN_SHUTOFF_SHUTDOWN);
+        testDomainShutdownState(privconn, domain, privdom, VIR_DOMAIN_SHUTOFF_SHUTDOWN);
         event = virDomainEventLifecycleNewFromObj(privdom,
                                          VIR_DOMAIN_EVENT_STOPPED,
                                          VIR_DOMAIN_EVENT_STOPPED_SHUTDOWN);
@@ -2316,7 +2319,7 @@ testDomainSaveFlags(virDomainPtr domain, const char *path,
     if (!testDomainSaveImageWrite(privconn, path, privdom->def))
         goto cleanup;
 
-    testDomainShutdownState(domain, privdom, VIR_DOMAIN_SHUTOFF_SAVED);
+    testDomainShutdownState(privconn, domain, privdom, VIR_DOMAIN_SHUTOFF_SAVED);
     event = virDomainEventLifecycleNewFromObj(privdom,
                                      VIR_DOMAIN_EVENT_STOPPED,
                                      VIR_DOMAIN_EVENT_STOPPED_SAVED);
@@ -2506,7 +2509,7 @@ static int testDomainCoreDumpWithFormat(virDomainPtr domain,
     }
 
     if (flags & VIR_DUMP_CRASH) {
-        testDomainShutdownState(domain, privdom, VIR_DOMAIN_SHUTOFF_CRASHED);
+        testDomainShutdownState(privconn, domain, privdom, VIR_DOMAIN_SHUTOFF_CRASHED);
         event = virDomainEventLifecycleNewFromObj(privdom,
                                          VIR_DOMAIN_EVENT_STOPPED,
                                          VIR_DOMAIN_EVENT_STOPPED_CRASHED);
@@ -7147,6 +7150,81 @@ testStorageVolumeTypeForPool(int pooltype)
 }
 
 
+struct testStoragePoolListAllVolumesInfoData {
+    virTypedParamList *params;
+    int type;
+    unsigned int nvols;
+    bool error;
+};
+
+
+static int
+testStoragePoolListAllVolumesInfoIter(virStorageVolDef *voldef,
+                                      const void *opaque)
+{
+    struct testStoragePoolListAllVolumesInfoData *data = (void *)opaque;
+    unsigned int n = data->nvols;
+
+    if (data->error)
+        return 0;
+
+    if (virTypedParamListAddString(data->params, voldef->name,
+                                   "vol.%u.name", n) < 0 ||
+        virTypedParamListAddString(data->params, voldef->target.path,
+                                   "vol.%u.path", n) < 0 ||
+        virTypedParamListAddInt(data->params, data->type,
+                                "vol.%u.type", n) < 0 ||
+        virTypedParamListAddULLong(data->params, voldef->target.capacity,
+                                   "vol.%u.capacity", n) < 0 ||
+        virTypedParamListAddULLong(data->params, voldef->target.allocation,
+                                   "vol.%u.allocation", n) < 0) {
+        data->error = true;
+        return -1;
+    }
+
+    data->nvols++;
+    return 0;
+}
+
+
+static int
+testStoragePoolListAllVolumesInfo(virStoragePoolPtr pool,
+                                  virTypedParameterPtr *params,
+                                  int *nparams,
+                                  unsigned int flags)
+{
+    testDriver *privconn = pool->conn->privateData;
+    virStoragePoolObj *obj;
+    g_autoptr(virTypedParamList) list = g_new0(virTypedParamList, 1);
+    struct testStoragePoolListAllVolumesInfoData data = { 0 };
+    int ret = -1;
+
+    virCheckFlags(0, -1);
+
+    if (!(obj = testStoragePoolObjFindActiveByName(privconn, pool->name)))
+        return -1;
+
+    data.params = list;
+    if ((data.type = testStorageVolumeTypeForPool(virStoragePoolObjGetDef(obj)->type)) < 0)
+        goto cleanup;
+
+    if (virStoragePoolObjForEachVolume(obj, testStoragePoolListAllVolumesInfoIter,
+                                       &data) < 0 ||
+        data.error)
+        goto cleanup;
+
+    if (virTypedParamListAddUInt(list, data.nvols, "vol.count") < 0)
+        goto cleanup;
+
+    *nparams = virTypedParamListStealParams(list, params);
+    ret = 0;
+
+ cleanup:
+    virStoragePoolObjEndAPI(&obj);
+    return ret;
+}
+
+
 static int
 testStorageVolGetInfo(virStorageVolPtr vol,
                       virStorageVolInfoPtr info)
@@ -7893,7 +7971,7 @@ testDomainManagedSave(virDomainPtr dom, unsigned int flags)
         goto cleanup;
     }
 
-    testDomainShutdownState(dom, vm, VIR_DOMAIN_SHUTOFF_SAVED);
+    testDomainShutdownState(privconn, dom, vm, VIR_DOMAIN_SHUTOFF_SAVED);
     event = virDomainEventLifecycleNewFromObj(vm,
                                      VIR_DOMAIN_EVENT_STOPPED,
                                      VIR_DOMAIN_EVENT_STOPPED_SAVED);
@@ -8596,7 +8674,7 @@ testDomainSnapshotCreateXML(virDomainPtr domain,
 
         if ((flags & VIR_DOMAIN_SNAPSHOT_CREATE_HALT) &&
             virDomainObjIsActive(vm)) {
-            testDomainShutdownState(domain, vm,
+            testDomainShutdownState(privconn, domain, vm,
                                     VIR_DOMAIN_SHUTOFF_FROM_SNAPSHOT);
             event = virDomainEventLifecycleNewFromObj(vm, VIR_DOMAIN_EVENT_STOPPED,
                                     VIR_DOMAIN_EVENT_STOPPED_FROM_SNAPSHOT);
@@ -8823,7 +8901,7 @@ testDomainRevertToSnapshot(virDomainSnapshotPtr snapshot,
                 }
 
                 virResetError(err);
-                testDomainShutdownState(snapshot->domain, vm,
+                testDomainShutdownState(privconn, snapshot->domain, vm,
                                         VIR_DOMAIN_SHUTOFF_FROM_SNAPSHOT);
                 event = virDomainEventLifecycleNewFromObj(vm,
                             VIR_DOMAIN_EVENT_STOPPED,
@@ -8895,7 +8973,7 @@ testDomainRevertToSnapshot(virDomainSnapshotPtr snapshot,
 
         if (virDomainObjIsActive(vm)) {
             /* Transitions 4, 7 */
-            testDomainShutdownState(snapshot->domain, vm,
+            testDomainShutdownState(privconn, snapshot->domain, vm,
                                     VIR_DOMAIN_SHUTOFF_FROM_SNAPSHOT);
             event = virDomainEventLifecycleNewFromObj(vm,
                                     VIR_DOMAIN_EVENT_STOPPED,
@@ -9521,6 +9599,7 @@ static virStorageDriver testStorageDriver = {
     .storagePoolNumOfVolumes = testStoragePoolNumOfVolumes, /* 0.5.0 */
     .storagePoolListVolumes = testStoragePoolListVolumes, /* 0.5.0 */
     .storagePoolListAllVolumes = testStoragePoolListAllVolumes, /* 0.10.2 */
+    .storagePoolListAllVolumesInfo = testStoragePoolListAllVolumesInfo, /* 7.7.0 */
 
     .storageVolLookupByName = testStorageVolLookupByName, /* 0.5.0 */
     .storageVolLookupByKey = testStorageVolLookupByKey, /* 0.5.0 */
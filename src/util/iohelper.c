@@ -43,42 +43,133 @@
 # define O_DIRECT 0
 #endif
 
+/* Number of buffers in flight between the reading and the writing
+ * thread. Two are enough to overlap input and output, the rest absorbs
+ * jitter of either side. */
+#define RUN_IO_QUEUE_DEPTH 4
+
+typedef struct _runIOQueue runIOQueue;
+struct _runIOQueue {
+    virMutex lock;
+    virCond cond;
+
+    char *bufs[RUN_IO_QUEUE_DEPTH];
+    ssize_t lens[RUN_IO_QUEUE_DEPTH];
+    size_t buflen;
+
+    size_t head; /* index of the next buffer to write */
+    size_t count; /* number of filled buffers */
+    bool eof; /* reader is done, see @err */
+    bool quit; /* writer stopped, reader should too */
+    int err; /* errno of the failed read, 0 on EOF */
+
+    int fdin;
+    bool direct; /* reading from O_DIRECT file */
+};
+
+
+static void
+runIOReader(void *opaque)
+{
+    runIOQueue *q = opaque;
+
+    while (1) {
+        size_t idx;
+        ssize_t got;
+
+        virMutexLock(&q->lock);
+        while (q->count == RUN_IO_QUEUE_DEPTH && !q->quit)
+            ignore_value(virCondWait(&q->cond, &q->lock));
+        if (q->quit) {
+            virMutexUnlock(&q->lock);
+            return;
+        }
+        idx = (q->head + q->count) % RUN_IO_QUEUE_DEPTH;
+        virMutexUnlock(&q->lock);
+
+        /* If we read with O_DIRECT from file we can't use saferead as
+         * it can lead to unaligned read after reading last bytes.
+         * If we write with O_DIRECT use should use saferead so that
+         * writes will be aligned.
+         * In other cases using saferead reduces number of syscalls.
+         */
+        if (q->direct) {
+            if ((got = read(q->fdin, q->bufs[idx], q->buflen)) < 0 &&
+                errno == EINTR)
+                continue;
+        } else {
+            got = saferead(q->fdin, q->bufs[idx], q->buflen);
+        }
+
+        virMutexLock(&q->lock);
+        if (got <= 0) {
+            q->err = got < 0 ? errno : 0;
+            q->eof = true;
+        } else {
+            q->lens[idx] = got;
+            q->count++;
+        }
+        virCondBroadcast(&q->cond);
+        virMutexUnlock(&q->lock);
+
+        if (got <= 0)
+            return;
+    }
+}
+
+
 static int
 runIO(const char *path, int fd, int oflags)
 {
     g_autofree void *base = NULL; /* Location to be freed */
     char *buf = NULL; /* Aligned location within base */
     size_t buflen = 1024*1024;
-    intptr_t alignMask = 64*1024 - 1;
+    intptr_t alignMask = VIR_FILE_DIRECT_ALIGNMENT - 1;
     int ret = -1;
     int fdin, fdout;
     const char *fdinname, *fdoutname;
-    unsigned long long total = 0;
     bool direct = O_DIRECT && ((oflags & O_DIRECT) != 0);
-    off_t end = 0;
+    off_t start = 0;
+    ssize_t skip = 0;
+    runIOQueue *q = g_new0(runIOQueue, 1);
+    virThread reader;
+    bool readerStarted = false;
+    size_t i;
 
 #if WITH_POSIX_MEMALIGN
-    if (posix_memalign(&base, alignMask + 1, buflen))
+    if (posix_memalign(&base, alignMask + 1, buflen * RUN_IO_QUEUE_DEPTH))
         abort();
     buf = base;
 #else
-    buf = g_new0(char, buflen + alignMask);
+    buf = g_new0(char, buflen * RUN_IO_QUEUE_DEPTH + alignMask);
     base = buf;
     buf = (char *) (((intptr_t) base + alignMask) & ~alignMask);
 #endif
 
+    q->buflen = buflen;
+    for (i = 0; i < RUN_IO_QUEUE_DEPTH; i++)
+        q->bufs[i] = buf + i * buflen;
+
     switch (oflags & O_ACCMODE) {
     case O_RDONLY:
         fdin = fd;
         fdinname = path;
         fdout = STDOUT_FILENO;
         fdoutname = "stdout";
-        /* To make the implementation simpler, we give up on any
-         * attempt to use O_DIRECT in a non-trivial manner.  */
-        if (direct && ((end = lseek(fd, 0, SEEK_CUR)) != 0)) {
-            virReportSystemError(end < 0 ? errno : EINVAL, "%s",
-                                 _("O_DIRECT read needs entire seekable file"));
-            goto cleanup;
+        /* O_DIRECT reads have to start at an aligned offset. Start at the
+         * closest one below the current position and drop the extra data
+         * from the first buffer.  */
+        if (direct) {
+            if ((start = lseek(fd, 0, SEEK_CUR)) < 0) {
+                virReportSystemError(errno, "%s",
+                                     _("O_DIRECT read needs seekable file"));
+                goto cleanup;
+            }
+            skip = start & alignMask;
+            if (skip > 0 && lseek(fd, start - skip, SEEK_SET) < 0) {
+                virReportSystemError(errno, _("Unable to seek %s"), path);
+                goto cleanup;
+            }
         }
         break;
     case O_WRONLY:
@@ -86,11 +177,10 @@ runIO(const char *path, int fd, int oflags)
         fdinname = "stdin";
         fdout = fd;
         fdoutname = path;
-        /* To make the implementation simpler, we give up on any
-         * attempt to use O_DIRECT in a non-trivial manner.  */
-        if (direct && (end = lseek(fd, 0, SEEK_END)) != 0) {
-            virReportSystemError(end < 0 ? errno : EINVAL, "%s",
-                                 _("O_DIRECT write needs empty seekable file"));
+        if (direct &&
+            ((start = lseek(fd, 0, SEEK_CUR)) < 0 || (start & alignMask) != 0)) {
+            virReportSystemError(start < 0 ? errno : EINVAL, "%s",
+                                 _("O_DIRECT write needs seekable file at aligned offset"));
             goto cleanup;
         }
         break;
@@ -103,47 +193,81 @@ runIO(const char *path, int fd, int oflags)
         goto cleanup;
     }
 
+    if (virMutexInit(&q->lock) < 0) {
+        virReportSystemError(errno, "%s", _("Unable to init mutex"));
+        goto cleanup;
+    }
+    if (virCondInit(&q->cond) < 0) {
+        virReportSystemError(errno, "%s", _("Unable to init condition"));
+        goto cleanup;
+    }
+
+    /* Reading happens in a separate thread so that the next chunk of
+     * input is already being fetched while the current one is written */
+    q->fdin = fdin;
+    q->direct = fdin == fd && direct;
+    if (virThreadCreateFull(&reader, true, runIOReader,
+                            "iohelper-read", false, q) < 0) {
+        virReportSystemError(errno, "%s", _("Unable to create reader thread"));
+        goto cleanup;
+    }
+    readerStarted = true;
+
     while (1) {
         ssize_t got;
 
-        /* If we read with O_DIRECT from file we can't use saferead as
-         * it can lead to unaligned read after reading last bytes.
-         * If we write with O_DIRECT use should use saferead so that
-         * writes will be aligned.
-         * In other cases using saferead reduces number of syscalls.
-         */
-        if (fdin == fd && direct) {
-            if ((got = read(fdin, buf, buflen)) < 0 &&
-                errno == EINTR)
-                continue;
-        } else {
-            got = saferead(fdin, buf, buflen);
+        virMutexLock(&q->lock);
+        while (q->count == 0 && !q->eof)
+            ignore_value(virCondWait(&q->cond, &q->lock));
+        if (q->count == 0) {
+            virMutexUnlock(&q->lock);
+            break;
         }
+        buf = q->bufs[q->head];
+        got = q->lens[q->head];
+        virMutexUnlock(&q->lock);
 
-        if (got < 0) {
-            virReportSystemError(errno, _("Unable to read %s"), fdinname);
-            goto cleanup;
-        }
-        if (got == 0)
-            break;
+        if (skip > 0) {
+            ssize_t drop = MIN(skip, got);
 
-        total += got;
+            buf += drop;
+            got -= drop;
+            skip = 0;
+        }
 
         /* handle last write size align in direct case */
         if (got < buflen && direct && fdout == fd) {
-            ssize_t aligned_got = (got + alignMask) & ~alignMask;
+            ssize_t aligned_got = got & ~alignMask;
 
-            memset(buf + got, 0, aligned_got - got);
-
-            if (safewrite(fdout, buf, aligned_got) < 0) {
+            if (aligned_got > 0 &&
+                safewrite(fdout, buf, aligned_got) < 0) {
                 virReportSystemError(errno, _("Unable to write %s"), fdoutname);
                 goto cleanup;
             }
 
-            if (ftruncate(fd, total) < 0) {
-                virReportSystemError(errno, _("Unable to truncate %s"), fdoutname);
+#ifdef F_SETFL
+            /* The unaligned tail can't be written with O_DIRECT. It's at
+             * most one alignment unit, so let it go through the cache. */
+            if (got > aligned_got) {
+                if (fcntl(fd, F_SETFL, oflags & ~O_DIRECT) < 0) {
+                    virReportSystemError(errno, _("Unable to disable O_DIRECT on %s"),
+                                         fdoutname);
+                    goto cleanup;
+                }
+
+                if (safewrite(fdout, buf + aligned_got, got - aligned_got) < 0) {
+                    virReportSystemError(errno, _("Unable to write %s"), fdoutname);
+                    goto cleanup;
+                }
+            }
+#else /* !F_SETFL */
+            if (got > aligned_got) {
+                virReportSystemError(ENOTSUP,
+                                     _("Unable to write unaligned end of %s"),
+                                     fdoutname);
                 goto cleanup;
             }
+#endif /* !F_SETFL */
 
             break;
         }
@@ -152,6 +276,17 @@ runIO(const char *path, int fd, int oflags)
             virReportSystemError(errno, _("Unable to write %s"), fdoutname);
             goto cleanup;
         }
+
+        virMutexLock(&q->lock);
+        q->head = (q->head + 1) % RUN_IO_QUEUE_DEPTH;
+        q->count--;
+        virCondBroadcast(&q->cond);
+        virMutexUnlock(&q->lock);
+    }
+
+    if (q->err != 0) {
+        virReportSystemError(q->err, _("Unable to read %s"), fdinname);
+        goto cleanup;
     }
 
     /* Ensure all data is written */
@@ -166,6 +301,26 @@ runIO(const char *path, int fd, int oflags)
     ret = 0;
 
  cleanup:
+    if (readerStarted) {
+        virMutexLock(&q->lock);
+        q->quit = true;
+        virCondBroadcast(&q->cond);
+        virMutexUnlock(&q->lock);
+
+        /* On success the reader has seen EOF already. On failure it may
+         * be stuck reading input that never comes, so leave it (and
+         * the buffers it may still use) to the imminent process exit. */
+        if (ret == 0) {
+            virThreadJoin(&reader);
+            virCondDestroy(&q->cond);
+            virMutexDestroy(&q->lock);
+            g_free(q);
+        } else {
+            base = NULL;
+        }
+    } else {
+        g_free(q);
+    }
     if (VIR_CLOSE(fd) < 0 &&
         ret == 0) {
         virReportSystemError(errno, _("Unable to close %s"), path);
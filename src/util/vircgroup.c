@@ -56,6 +56,13 @@ VIR_LOG_INIT("util.cgroup");
 #define CGROUP_NB_TOTAL_CPU_STAT_PARAM 3
 #define CGROUP_NB_PER_CPU_STAT_PARAM   1
 
+/* Limit of statistics files kept open across all cgroups. Each running
+ * domain keeps a handful of them, so without a limit a host with many
+ * domains would run the daemon out of file descriptors (the systemd
+ * units set LimitNOFILE=8192). Files beyond the limit are opened for
+ * each read instead. */
+#define VIR_CGROUP_STAT_FILES_MAX 2048
+
 VIR_ENUM_IMPL(virCgroupController,
               VIR_CGROUP_CONTROLLER_LAST,
               "cpu", "cpuacct", "cpuset", "memory", "devices",
@@ -103,6 +110,35 @@ virCgroupGetDevicePermsString(int perms)
 
 
 #ifdef __linux__
+static int virCgroupStatFilesOpen;
+static int virCgroupStatFilesMax = VIR_CGROUP_STAT_FILES_MAX;
+
+static void
+virCgroupStatFileFree(void *opaque)
+{
+    virCgroupStatFile *file = opaque;
+
+    if (!file)
+        return;
+
+    VIR_FORCE_CLOSE(file->fd);
+    g_free(file);
+    g_atomic_int_add(&virCgroupStatFilesOpen, -1);
+}
+
+
+static virCgroup *
+virCgroupNewEmpty(void)
+{
+    virCgroup *group = g_new0(virCgroup, 1);
+
+    g_mutex_init(&group->statLock);
+    group->statFiles = virHashNew(virCgroupStatFileFree);
+
+    return group;
+}
+
+
 bool
 virCgroupAvailable(void)
 {
@@ -594,6 +630,154 @@ virCgroupGetValueStr(virCgroup *group,
 }
 
 
+/**
+ * virCgroupSetStatFilesMax:
+ * @max: new limit
+ *
+ * Changes the limit of statistics files kept open, files already open
+ * stay open. Meant for tests only.
+ *
+ * Returns the previous limit.
+ */
+int
+virCgroupSetStatFilesMax(int max)
+{
+    int old = g_atomic_int_get(&virCgroupStatFilesMax);
+
+    g_atomic_int_set(&virCgroupStatFilesMax, max);
+    return old;
+}
+
+
+/**
+ * virCgroupGetStatValueStr:
+ * @group: the cgroup
+ * @controller: the controller the file belongs to
+ * @key: name of the file
+ * @value: filled with the contents of the file
+ *
+ * Like virCgroupGetValueStr, but meant for statistics files read
+ * repeatedly. The file is opened on the first call only and kept open
+ * in @group, further calls just read it again from the beginning.
+ * Once VIR_CGROUP_STAT_FILES_MAX (see virCgroupSetStatFilesMax) files
+ * are kept open in total, further files are read like
+ * virCgroupGetValueStr does.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virCgroupGetStatValueStr(virCgroup *group,
+                         int controller,
+                         const char *key,
+                         char **value)
+{
+    g_autofree char *keypath = NULL;
+    g_autofree char *buf = NULL;
+    g_autoptr(GMutexLocker) locker = NULL;
+    virCgroupStatFile *file;
+    size_t len = 0;
+    size_t size;
+    ssize_t rc;
+
+    *value = NULL;
+
+    if (virCgroupPathOfController(group, controller, key, &keypath) < 0)
+        return -1;
+
+    VIR_DEBUG("Get stat value %s", keypath);
+
+    locker = g_mutex_locker_new(&group->statLock);
+
+    if (!(file = virHashLookup(group->statFiles, keypath))) {
+        int fd;
+
+        if (g_atomic_int_add(&virCgroupStatFilesOpen, 1) >=
+            g_atomic_int_get(&virCgroupStatFilesMax)) {
+            g_atomic_int_add(&virCgroupStatFilesOpen, -1);
+            return virCgroupGetValueRaw(keypath, value);
+        }
+
+        if ((fd = open(keypath, O_RDONLY | O_CLOEXEC)) < 0) {
+            virReportSystemError(errno,
+                                 _("Unable to read from '%s'"), keypath);
+            g_atomic_int_add(&virCgroupStatFilesOpen, -1);
+            return -1;
+        }
+
+        file = g_new0(virCgroupStatFile, 1);
+        file->fd = fd;
+        file->size = 1024;
+
+        if (virHashAddEntry(group->statFiles, keypath, file) < 0) {
+            virCgroupStatFileFree(file);
+            return -1;
+        }
+    }
+
+    /* Size the buffer after the previous reads so that a single
+     * pread() usually gets the whole file */
+    size = file->size + 1;
+    buf = g_new0(char, size);
+
+    while ((rc = pread(file->fd, buf + len, size - len - 1, len)) > 0) {
+        len += rc;
+
+        if (len == size - 1) {
+            if (size > 1024 * 1024) {
+                virReportSystemError(EFBIG,
+                                     _("Unable to read from '%s'"), keypath);
+                return -1;
+            }
+            size *= 2;
+            buf = g_renew(char, buf, size);
+        }
+    }
+
+    if (rc < 0) {
+        virReportSystemError(errno,
+                             _("Unable to read from '%s'"), keypath);
+        /* the cgroup might have been removed, open it again next time */
+        virHashRemoveEntry(group->statFiles, keypath);
+        return -1;
+    }
+
+    buf[len] = '\0';
+
+    /* leave room for the file to grow a bit */
+    if (len >= file->size / 2)
+        file->size = len * 2;
+
+    /* Terminated with '\n' has sometimes harmful effects to the caller */
+    if (len > 0 && buf[len - 1] == '\n')
+        buf[len - 1] = '\0';
+
+    *value = g_steal_pointer(&buf);
+    return 0;
+}
+
+
+int
+virCgroupGetStatValueU64(virCgroup *group,
+                         int controller,
+                         const char *key,
+                         unsigned long long int *value)
+{
+    g_autofree char *strval = NULL;
+
+    if (virCgroupGetStatValueStr(group, controller, key, &strval) < 0)
+        return -1;
+
+    if (virStrToLong_ull(strval, NULL, 10, value) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Unable to parse '%s' as an integer"),
+                       strval);
+        return -1;
+    }
+
+    return 0;
+}
+
+
 int
 virCgroupGetValueForBlkDev(const char *str,
                            const char *path,
@@ -747,7 +931,7 @@ virCgroupNew(const char *path,
               path, controllers, group);
 
     *group = NULL;
-    newGroup = g_new0(virCgroup, 1);
+    newGroup = virCgroupNewEmpty();
 
     if (virCgroupSetBackends(newGroup) < 0)
         return -1;
@@ -898,7 +1082,7 @@ virCgroupNewFromParent(virCgroup *parent,
                        int controllers,
                        virCgroup **group)
 {
-    g_autoptr(virCgroup) new = g_new0(virCgroup, 1);
+    g_autoptr(virCgroup) new = virCgroupNewEmpty();
 
     VIR_DEBUG("parent=%p path=%s controllers=%d group=%p",
               parent, path, controllers, group);
@@ -1146,7 +1330,7 @@ virCgroupNewDetect(pid_t pid,
                    int controllers,
                    virCgroup **group)
 {
-    g_autoptr(virCgroup) new = g_new0(virCgroup, 1);
+    g_autoptr(virCgroup) new = virCgroupNewEmpty();
 
     VIR_DEBUG("pid=%lld controllers=%d group=%p",
               (long long) pid, controllers, group);
@@ -2616,6 +2800,15 @@ virCgroupRemoveRecursively(char *grppath)
 }
 
 
+static void
+virCgroupCloseStatFiles(virCgroup *group)
+{
+    g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&group->statLock);
+
+    virHashRemoveAll(group->statFiles);
+}
+
+
 /**
  * virCgroupRemove:
  *
@@ -2633,6 +2826,10 @@ virCgroupRemove(virCgroup *group)
 {
     size_t i;
 
+    virCgroupCloseStatFiles(group);
+    if (group->nested)
+        virCgroupCloseStatFiles(group->nested);
+
     for (i = 0; i < VIR_CGROUP_BACKEND_TYPE_LAST; i++) {
         if (group->backends[i]) {
             int rc = group->backends[i]->remove(group);
@@ -2901,6 +3098,32 @@ virCgroupGetCpuacctStat(virCgroup *group, unsigned long long *user,
 }
 
 
+/**
+ * virCgroupGetCpuacctTimes:
+ * @group: the cgroup
+ * @usage: filled with the total CPU time
+ * @user: filled with the user CPU time
+ * @sys: filled with the system CPU time
+ *
+ * Same as calling virCgroupGetCpuacctUsage and virCgroupGetCpuacctStat,
+ * but reads the statistics only once where the backend allows that.
+ * All values are in nanoseconds.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virCgroupGetCpuacctTimes(virCgroup *group,
+                         unsigned long long *usage,
+                         unsigned long long *user,
+                         unsigned long long *sys)
+{
+    virCgroup *parent = virCgroupGetNested(group);
+
+    VIR_CGROUP_BACKEND_CALL(parent, VIR_CGROUP_CONTROLLER_CPUACCT,
+                            getCpuacctTimes, -1, usage, user, sys);
+}
+
+
 int
 virCgroupSetFreezerState(virCgroup *group, const char *state)
 {
@@ -3680,6 +3903,18 @@ virCgroupGetCpuacctStat(virCgroup *group G_GNUC_UNUSED,
 }
 
 
+int
+virCgroupGetCpuacctTimes(virCgroup *group G_GNUC_UNUSED,
+                         unsigned long long *usage G_GNUC_UNUSED,
+                         unsigned long long *user G_GNUC_UNUSED,
+                         unsigned long long *sys G_GNUC_UNUSED)
+{
+    virReportSystemError(ENOSYS, "%s",
+                         _("Control groups not supported on this platform"));
+    return -1;
+}
+
+
 int
 virCgroupGetDomainTotalCpuStats(virCgroup *group G_GNUC_UNUSED,
                                 virTypedParameterPtr params G_GNUC_UNUSED,
@@ -3795,6 +4030,9 @@ virCgroupFree(virCgroup *group)
     g_free(group->unified.placement);
     g_free(group->unitName);
 
+    virHashFree(group->statFiles);
+    g_mutex_clear(&group->statLock);
+
     virCgroupFree(group->nested);
 
     g_free(group);
@@ -56,6 +56,12 @@ struct _virCgroupV2Controller {
 };
 typedef struct _virCgroupV2Controller virCgroupV2Controller;
 
+struct _virCgroupStatFile {
+    int fd;
+    size_t size; /* buffer size to start reading with */
+};
+typedef struct _virCgroupStatFile virCgroupStatFile;
+
 struct _virCgroup {
     virCgroupBackend *backends[VIR_CGROUP_BACKEND_TYPE_LAST];
 
@@ -64,6 +70,10 @@ struct _virCgroup {
 
     char *unitName;
     virCgroup *nested;
+
+    /* statistics files kept open for re-reading, path -> virCgroupStatFile */
+    GMutex statLock;
+    GHashTable *statFiles;
 };
 
 #define virCgroupGetNested(cgroup) \
@@ -89,6 +99,18 @@ int virCgroupGetValueStr(virCgroup *group,
                          const char *key,
                          char **value);
 
+int virCgroupGetStatValueStr(virCgroup *group,
+                             int controller,
+                             const char *key,
+                             char **value);
+
+int virCgroupSetStatFilesMax(int max);
+
+int virCgroupGetStatValueU64(virCgroup *group,
+                             int controller,
+                             const char *key,
+                             unsigned long long int *value);
+
 int virCgroupSetValueU64(virCgroup *group,
                          int controller,
                          const char *key,
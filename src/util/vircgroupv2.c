@@ -751,9 +751,9 @@ virCgroupV2GetBlkioIoServiced(virCgroup *group,
     *requests_read = 0;
     *requests_write = 0;
 
-    if (virCgroupGetValueStr(group,
-                             VIR_CGROUP_CONTROLLER_BLKIO,
-                             "io.stat", &str1) < 0) {
+    if (virCgroupGetStatValueStr(group,
+                                 VIR_CGROUP_CONTROLLER_BLKIO,
+                                 "io.stat", &str1) < 0) {
         return -1;
     }
 
@@ -811,9 +811,9 @@ virCgroupV2GetBlkioIoDeviceServiced(virCgroup *group,
         requests_write
     };
 
-    if (virCgroupGetValueStr(group,
-                             VIR_CGROUP_CONTROLLER_BLKIO,
-                             "io.stat", &str1) < 0) {
+    if (virCgroupGetStatValueStr(group,
+                                 VIR_CGROUP_CONTROLLER_BLKIO,
+                                 "io.stat", &str1) < 0) {
         return -1;
     }
 
@@ -1247,10 +1247,10 @@ virCgroupV2GetMemoryStat(virCgroup *group,
     unsigned long long inactiveFileVal = 0;
     unsigned long long unevictableVal = 0;
 
-    if (virCgroupGetValueStr(group,
-                             VIR_CGROUP_CONTROLLER_MEMORY,
-                             "memory.stat",
-                             &stat) < 0) {
+    if (virCgroupGetStatValueStr(group,
+                                 VIR_CGROUP_CONTROLLER_MEMORY,
+                                 "memory.stat",
+                                 &stat) < 0) {
         return -1;
     }
 
@@ -1313,9 +1313,9 @@ virCgroupV2GetMemoryUsage(virCgroup *group,
                           unsigned long *kb)
 {
     unsigned long long usage_in_bytes;
-    int ret = virCgroupGetValueU64(group,
-                                   VIR_CGROUP_CONTROLLER_MEMORY,
-                                   "memory.current", &usage_in_bytes);
+    int ret = virCgroupGetStatValueU64(group,
+                                       VIR_CGROUP_CONTROLLER_MEMORY,
+                                       "memory.current", &usage_in_bytes);
     if (ret == 0)
         *kb = (unsigned long) usage_in_bytes >> 10;
     return ret;
@@ -1488,9 +1488,9 @@ virCgroupV2GetMemSwapUsage(virCgroup *group,
 {
     unsigned long long usage_in_bytes;
     int ret;
-    ret = virCgroupGetValueU64(group,
-                               VIR_CGROUP_CONTROLLER_MEMORY,
-                               "memory.swap.current", &usage_in_bytes);
+    ret = virCgroupGetStatValueU64(group,
+                                   VIR_CGROUP_CONTROLLER_MEMORY,
+                                   "memory.swap.current", &usage_in_bytes);
     if (ret == 0)
         *kb = (unsigned long) usage_in_bytes >> 10;
     return ret;
@@ -1667,82 +1667,84 @@ virCgroupV2SupportsCpuBW(virCgroup *cgroup)
 }
 
 
+/* Fills whichever of @usage, @user and @sys isn't NULL, all from a
+ * single read of cpu.stat. */
 static int
-virCgroupV2GetCpuacctUsage(virCgroup *group,
-                           unsigned long long *usage)
+virCgroupV2GetCpuacctTimes(virCgroup *group,
+                           unsigned long long *usage,
+                           unsigned long long *user,
+                           unsigned long long *sys)
 {
     g_autofree char *str = NULL;
-    char *tmp;
-
-    if (virCgroupGetValueStr(group, VIR_CGROUP_CONTROLLER_CPUACCT,
-                             "cpu.stat", &str) < 0) {
-        return -1;
-    }
+    g_auto(GStrv) lines = NULL;
+    GStrv line;
+    struct {
+        const char *key;
+        unsigned long long *value;
+        bool found;
+    } fields[] = {
+        { "usage_usec", usage, false },
+        { "user_usec", user, false },
+        { "system_usec", sys, false },
+    };
+    size_t i;
 
-    if (!(tmp = strstr(str, "usage_usec "))) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("cannot parse cpu usage stat '%s'"), str);
+    if (virCgroupGetStatValueStr(group, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                 "cpu.stat", &str) < 0) {
         return -1;
     }
-    tmp += strlen("usage_usec ");
 
-    if (virStrToLong_ull(tmp, &tmp, 10, usage) < 0) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("Failed to parse value '%s' as number."), tmp);
-        return -1;
-    }
+    lines = g_strsplit(str, "\n", 0);
 
-    *usage *= 1000;
+    for (line = lines; *line; line++) {
+        char *tmp = strchr(*line, ' ');
 
-    return 0;
-}
+        if (!tmp)
+            continue;
+        *tmp++ = '\0';
 
+        for (i = 0; i < G_N_ELEMENTS(fields); i++) {
+            if (!fields[i].value || STRNEQ(*line, fields[i].key))
+                continue;
 
-static int
-virCgroupV2GetCpuacctStat(virCgroup *group,
-                          unsigned long long *user,
-                          unsigned long long *sys)
-{
-    g_autofree char *str = NULL;
-    char *tmp;
-    unsigned long long userVal = 0;
-    unsigned long long sysVal = 0;
+            if (virStrToLong_ull(tmp, NULL, 10, fields[i].value) < 0) {
+                virReportError(VIR_ERR_INTERNAL_ERROR,
+                               _("Failed to parse value '%s' as number."), tmp);
+                return -1;
+            }
 
-    if (virCgroupGetValueStr(group, VIR_CGROUP_CONTROLLER_CPUACCT,
-                             "cpu.stat", &str) < 0) {
-        return -1;
+            *fields[i].value *= 1000;
+            fields[i].found = true;
+            break;
+        }
     }
 
-    if (!(tmp = strstr(str, "user_usec "))) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("cannot parse cpu user stat '%s'"), str);
-        return -1;
+    for (i = 0; i < G_N_ELEMENTS(fields); i++) {
+        if (fields[i].value && !fields[i].found) {
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("cannot find '%s' in cpu.stat"), fields[i].key);
+            return -1;
+        }
     }
-    tmp += strlen("user_usec ");
 
-    if (virStrToLong_ull(tmp, &tmp, 10, &userVal) < 0) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("Failed to parse value '%s' as number."), tmp);
-        return -1;
-    }
+    return 0;
+}
 
-    if (!(tmp = strstr(str, "system_usec "))) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("cannot parse cpu sys stat '%s'"), str);
-        return -1;
-    }
-    tmp += strlen("system_usec ");
 
-    if (virStrToLong_ull(tmp, &tmp, 10, &sysVal) < 0) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("Failed to parse value '%s' as number."), tmp);
-        return -1;
-    }
+static int
+virCgroupV2GetCpuacctUsage(virCgroup *group,
+                           unsigned long long *usage)
+{
+    return virCgroupV2GetCpuacctTimes(group, usage, NULL, NULL);
+}
 
-    *user = userVal * 1000;
-    *sys = sysVal * 1000;
 
-    return 0;
+static int
+virCgroupV2GetCpuacctStat(virCgroup *group,
+                          unsigned long long *user,
+                          unsigned long long *sys)
+{
+    return virCgroupV2GetCpuacctTimes(group, NULL, user, sys);
 }
 
 
@@ -1970,6 +1972,7 @@ virCgroupBackend virCgroupV2Backend = {
 
     .getCpuacctUsage = virCgroupV2GetCpuacctUsage,
     .getCpuacctStat = virCgroupV2GetCpuacctStat,
+    .getCpuacctTimes = virCgroupV2GetCpuacctTimes,
 
     .setCpusetMems = virCgroupV2SetCpusetMems,
     .getCpusetMems = virCgroupV2GetCpusetMems,
@@ -102,6 +102,10 @@ struct _virFileWrapperFd;
 
 typedef struct _virFileWrapperFd virFileWrapperFd;
 
+/* Alignment of buffers, file offsets and lengths which is sufficient for
+ * I/O on files opened with virFileDirectFdFlag() */
+#define VIR_FILE_DIRECT_ALIGNMENT (64 * 1024)
+
 int virFileDirectFdFlag(void);
 
 typedef enum {
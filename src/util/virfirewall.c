@@ -45,6 +45,19 @@ VIR_ENUM_IMPL(virFirewallLayerCommand,
               EBTABLES_PATH,
               IPTABLES_PATH,
               IP6TABLES_PATH,
+              NFT_PATH,
+);
+
+/* Tools able to apply a whole batch of rules of a layer at once.
+ * ebtables-restore is deliberately not used: the legacy version
+ * replaces whole tables instead of appending to them. */
+VIR_ENUM_DECL(virFirewallLayerRestoreCommand);
+VIR_ENUM_IMPL(virFirewallLayerRestoreCommand,
+              VIR_FIREWALL_LAYER_LAST,
+              NULL,
+              IPTABLES_RESTORE_PATH,
+              IP6TABLES_RESTORE_PATH,
+              NFT_PATH,
 );
 
 struct _virFirewallRule {
@@ -84,13 +97,38 @@ struct _virFirewall {
 static virFirewallBackend currentBackend = VIR_FIREWALL_BACKEND_AUTOMATIC;
 static virMutex ruleLock = VIR_MUTEX_INITIALIZER;
 
+/* Layers whose rules are applied in batches through the *-restore
+ * tool, protected by ruleLock */
+static bool restoreBatching[VIR_FIREWALL_LAYER_LAST];
+
 static int
 virFirewallValidateBackend(virFirewallBackend backend);
 
+static void
+virFirewallDetectRestore(void)
+{
+    size_t i;
+
+    for (i = 0; i < VIR_FIREWALL_LAYER_LAST; i++) {
+        const char *bin = virFirewallLayerRestoreCommandTypeToString(i);
+        g_autofree char *path = NULL;
+
+        if (!bin || !(path = virFindFileInPath(bin)))
+            continue;
+
+        VIR_DEBUG("found %s, applying rules in batches", path);
+        restoreBatching[i] = true;
+    }
+}
+
 static int
 virFirewallOnceInit(void)
 {
-    return virFirewallValidateBackend(currentBackend);
+    if (virFirewallValidateBackend(currentBackend) < 0)
+        return -1;
+
+    virFirewallDetectRestore();
+    return 0;
 }
 
 VIR_ONCE_GLOBAL_INIT(virFirewall);
@@ -151,9 +189,24 @@ virFirewallSetBackend(virFirewallBackend backend)
     if (virFirewallInitialize() < 0)
         return -1;
 
+    /* Only used by test suites, which expect each rule to be run
+     * as a separate command unless they ask for batches */
+    virFirewallSetBatching(false);
+
     return virFirewallValidateBackend(backend);
 }
 
+
+void
+virFirewallSetBatching(bool batching)
+{
+    size_t i;
+
+    for (i = 0; i < VIR_FIREWALL_LAYER_LAST; i++)
+        restoreBatching[i] = batching &&
+            virFirewallLayerRestoreCommandTypeToString(i) != NULL;
+}
+
 static virFirewallGroup *
 virFirewallGroupNew(void)
 {
@@ -305,6 +358,7 @@ virFirewallAddRuleFullV(virFirewall *firewall,
     case VIR_FIREWALL_LAYER_IPV6:
         ADD_ARG(rule, "-w");
         break;
+    case VIR_FIREWALL_LAYER_NFTABLES:
     case VIR_FIREWALL_LAYER_LAST:
         break;
     }
@@ -706,6 +760,160 @@ virFirewallApplyRule(virFirewall *firewall,
     return 0;
 }
 
+/*
+ * virFirewallRuleToRestoreLine:
+ * @rule: the rule to convert
+ * @table: filled with the table the rule operates on
+ *
+ * Formats @rule as a line understood by iptables-restore or nft -f.
+ * Rules which need their output or errors to be looked at, or which
+ * can't be expressed in that format are not batched.
+ *
+ * Returns the line or NULL if @rule must be applied on its own.
+ */
+static char *
+virFirewallRuleToRestoreLine(virFirewallRule *rule,
+                             const char **table)
+{
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    const char *const unbatchable[] = {
+        "-L", "--list", "-S", "--list-rules", "-C", "--check",
+        "-Z", "--zero", "-V", "--version",
+    };
+    size_t i;
+
+    if (rule->queryCB || rule->ignoreErrors ||
+        !restoreBatching[rule->layer])
+        return NULL;
+
+    if (rule->layer == VIR_FIREWALL_LAYER_NFTABLES) {
+        /* nft joins its arguments into a command itself, so a script
+         * holds the very same command */
+        *table = "";
+        for (i = 0; i < rule->argsLen; i++) {
+            if (strchr(rule->args[i], '\n') || strchr(rule->args[i], '#'))
+                return NULL;
+            virBufferAsprintf(&buf, "%s ", rule->args[i]);
+        }
+        virBufferTrim(&buf, " ");
+        return virBufferContentAndReset(&buf);
+    }
+
+    *table = "filter";
+
+    for (i = 0; i < rule->argsLen; i++) {
+        const char *arg = rule->args[i];
+        const char *c;
+        size_t j;
+
+        if (STREQ(arg, "-w"))
+            continue;
+
+        if (STREQ(arg, "-t") || STREQ(arg, "--table")) {
+            if (++i == rule->argsLen)
+                return NULL;
+            *table = rule->args[i];
+            continue;
+        }
+
+        for (j = 0; j < G_N_ELEMENTS(unbatchable); j++) {
+            if (STREQ(arg, unbatchable[j]))
+                return NULL;
+        }
+
+        if (*arg == '\0' || strchr(arg, '\n'))
+            return NULL;
+
+        if (virBufferUse(&buf) > 0)
+            virBufferAddLit(&buf, " ");
+
+        if (!strpbrk(arg, " \t\"\\")) {
+            virBufferAdd(&buf, arg, -1);
+            continue;
+        }
+
+        virBufferAddLit(&buf, "\"");
+        for (c = arg; *c; c++) {
+            if (*c == '"' || *c == '\\')
+                virBufferAddLit(&buf, "\\");
+            virBufferAddChar(&buf, *c);
+        }
+        virBufferAddLit(&buf, "\"");
+    }
+
+    return virBufferContentAndReset(&buf);
+}
+
+
+/*
+ * virFirewallApplyRulesRestore:
+ * @firewall: the firewall ruleset
+ * @rules: rules of one layer operating on @table
+ * @lines: the rules formatted by virFirewallRuleToRestoreLine
+ * @nrules: number of rules
+ * @table: the table to commit to, ignored for nftables
+ *
+ * Applies all @rules by a single run of the layer's restore tool. The
+ * batch is committed atomically, so if the tool fails nothing has been
+ * changed and the rules are replayed one by one to find and report the
+ * offending one exactly as if they were never batched. If the replay
+ * succeeds, the restore tool itself is not usable and batching gets
+ * turned off for the layer.
+ *
+ * Returns 0 on success, -1 on failure.
+ */
+static int
+virFirewallApplyRulesRestore(virFirewall *firewall,
+                             virFirewallRule **rules,
+                             char **lines,
+                             size_t nrules,
+                             const char *table)
+{
+    virFirewallLayer layer = rules[0]->layer;
+    const char *bin = virFirewallLayerRestoreCommandTypeToString(layer);
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    g_autoptr(virCommand) cmd = NULL;
+    g_autofree char *input = NULL;
+    g_autofree char *error = NULL;
+    int status = -1;
+    size_t i;
+
+    if (layer != VIR_FIREWALL_LAYER_NFTABLES)
+        virBufferAsprintf(&buf, "*%s\n", table);
+    for (i = 0; i < nrules; i++)
+        virBufferAsprintf(&buf, "%s\n", lines[i]);
+    if (layer != VIR_FIREWALL_LAYER_NFTABLES)
+        virBufferAddLit(&buf, "COMMIT\n");
+    input = virBufferContentAndReset(&buf);
+
+    VIR_INFO("Applying %zu rules via %s", nrules, bin);
+    VIR_DEBUG("Rules: %s", input);
+
+    if (layer == VIR_FIREWALL_LAYER_NFTABLES)
+        cmd = virCommandNewArgList(bin, "-f", "-", NULL);
+    else
+        cmd = virCommandNewArgList(bin, "-w", "--noflush", NULL);
+    virCommandSetInputBuffer(cmd, input);
+    virCommandSetErrorBuffer(cmd, &error);
+
+    if (virCommandRun(cmd, &status) == 0 && status == 0)
+        return 0;
+
+    VIR_DEBUG("Batch failed with status %d: %s, replaying rules one by one",
+              status, NULLSTR(error));
+    virResetLastError();
+
+    for (i = 0; i < nrules; i++) {
+        if (virFirewallApplyRule(firewall, rules[i], false) < 0)
+            return -1;
+    }
+
+    VIR_WARN("%s doesn't work here, not applying rules in batches anymore", bin);
+    restoreBatching[layer] = false;
+    return 0;
+}
+
+
 static int
 virFirewallApplyGroup(virFirewall *firewall,
                       size_t idx)
@@ -719,6 +927,43 @@ virFirewallApplyGroup(virFirewall *firewall,
     firewall->currentGroup = idx;
     group->addingRollback = false;
     for (i = 0; i < group->naction; i++) {
+        g_auto(GStrv) lines = NULL;
+        const char *table = NULL;
+        size_t nlines = 0;
+        char *line;
+
+        /* Collect the following rules of the same layer and table which
+         * can be committed together. Failures to apply any of them would
+         * abort the transaction, unlike ignored errors which are always
+         * handled by running the rules separately. */
+        while (!ignoreErrors &&
+               i + nlines < group->naction &&
+               group->action[i + nlines]->layer == group->action[i]->layer) {
+            const char *ruleTable;
+
+            if (!(line = virFirewallRuleToRestoreLine(group->action[i + nlines],
+                                                      &ruleTable)))
+                break;
+
+            if (table && STRNEQ(table, ruleTable)) {
+                g_free(line);
+                break;
+            }
+
+            table = ruleTable;
+            VIR_REALLOC_N(lines, nlines + 2);
+            lines[nlines++] = line;
+            lines[nlines] = NULL;
+        }
+
+        if (nlines > 1) {
+            if (virFirewallApplyRulesRestore(firewall, group->action + i,
+                                             lines, nlines, table) < 0)
+                return -1;
+            i += nlines - 1;
+            continue;
+        }
+
         if (virFirewallApplyRule(firewall,
                                  group->action[i],
                                  ignoreErrors) < 0)
@@ -30,6 +30,7 @@ typedef enum {
     VIR_FIREWALL_LAYER_ETHERNET,
     VIR_FIREWALL_LAYER_IPV4,
     VIR_FIREWALL_LAYER_IPV6,
+    VIR_FIREWALL_LAYER_NFTABLES,
 
     VIR_FIREWALL_LAYER_LAST,
 } virFirewallLayer;
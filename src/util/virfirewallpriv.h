@@ -35,3 +35,5 @@ typedef enum {
 } virFirewallBackend;
 
 int virFirewallSetBackend(virFirewallBackend backend);
+
+void virFirewallSetBatching(bool batching);
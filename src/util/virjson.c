@@ -93,6 +93,13 @@ struct _virJSONParser {
     int wrap;
 };
 
+struct _virJSONStreamParser {
+#if WITH_YAJL
+    yajl_handle hand;
+#endif
+    virJSONParser parser;
+};
+
 
 virJSONType
 virJSONValueGetType(const virJSONValue *value)
@@ -1717,7 +1724,6 @@ static const yajl_callbacks parserCallbacks = {
 };
 
 
-/* XXX add an incremental streaming parser - yajl trivially supports it */
 virJSONValue *
 virJSONValueFromString(const char *jsonstring)
 {
@@ -1777,6 +1783,144 @@ virJSONValueFromString(const char *jsonstring)
 }
 
 
+static void
+virJSONParserClear(virJSONParser *parser)
+{
+    size_t i;
+
+    for (i = 0; i < parser->nstate; i++)
+        VIR_FREE(parser->state[i].key);
+    VIR_FREE(parser->state);
+    parser->nstate = 0;
+
+    g_clear_pointer(&parser->head, virJSONValueFree);
+}
+
+
+static int
+virJSONStreamParserReset(virJSONStreamParser *sp)
+{
+    if (sp->hand)
+        yajl_free(sp->hand);
+    virJSONParserClear(&sp->parser);
+
+    if (!(sp->hand = yajl_alloc(&parserCallbacks, NULL, &sp->parser))) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Unable to create JSON parser"));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * virJSONStreamParserNew:
+ *
+ * Creates a parser which builds a virJSONValue out of a JSON document
+ * passed in arbitrarily sized pieces via virJSONStreamParserFeed. This
+ * allows parsing data as it arrives instead of scanning an ever growing
+ * buffer until the document is complete.
+ *
+ * Returns the new parser or NULL on error.
+ */
+virJSONStreamParser *
+virJSONStreamParserNew(void)
+{
+    virJSONStreamParser *sp = g_new0(virJSONStreamParser, 1);
+
+    if (virJSONStreamParserReset(sp) < 0) {
+        virJSONStreamParserFree(sp);
+        return NULL;
+    }
+
+    return sp;
+}
+
+
+void
+virJSONStreamParserFree(virJSONStreamParser *sp)
+{
+    if (!sp)
+        return;
+
+    if (sp->hand)
+        yajl_free(sp->hand);
+    virJSONParserClear(&sp->parser);
+    g_free(sp);
+}
+
+
+/**
+ * virJSONStreamParserFeed:
+ * @sp: stream parser
+ * @data: next piece of the JSON document
+ * @len: length of @data
+ *
+ * Parses @data as continuation of the document passed in by previous
+ * calls since the parser was created or last finished.
+ *
+ * Returns 0 on success, -1 and a libvirt error if @data is malformed.
+ */
+int
+virJSONStreamParserFeed(virJSONStreamParser *sp,
+                        const char *data,
+                        size_t len)
+{
+    unsigned char *errstr;
+
+    if (len == 0)
+        return 0;
+
+    if (yajl_parse(sp->hand, (const unsigned char *)data, len) == yajl_status_ok)
+        return 0;
+
+    errstr = yajl_get_error(sp->hand, 1, (const unsigned char *)data, len);
+    virReportError(VIR_ERR_INTERNAL_ERROR,
+                   _("cannot parse json: %s"), (const char *) errstr);
+    yajl_free_error(sp->hand, errstr);
+    return -1;
+}
+
+
+/**
+ * virJSONStreamParserFinish:
+ * @sp: stream parser
+ *
+ * Signals the end of the document passed in by virJSONStreamParserFeed
+ * and resets @sp so that it can be used for parsing another document.
+ *
+ * Returns the parsed value or NULL and a libvirt error if the document
+ * is malformed or incomplete.
+ */
+virJSONValue *
+virJSONStreamParserFinish(virJSONStreamParser *sp)
+{
+    virJSONValue *ret = NULL;
+
+    if (yajl_complete_parse(sp->hand) != yajl_status_ok) {
+        unsigned char *errstr = yajl_get_error(sp->hand, 0, NULL, 0);
+
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("cannot parse json: %s"), (const char *) errstr);
+        yajl_free_error(sp->hand, errstr);
+    } else if (sp->parser.nstate != 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("cannot parse json: unterminated string/map/array"));
+    } else if (!sp->parser.head) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("cannot parse json: empty document"));
+    } else {
+        ret = g_steal_pointer(&sp->parser.head);
+    }
+
+    if (virJSONStreamParserReset(sp) < 0)
+        g_clear_pointer(&ret, virJSONValueFree);
+
+    return ret;
+}
+
+
 static int
 virJSONValueToStringOne(virJSONValue *object,
                         yajl_gen g)
@@ -1896,6 +2040,42 @@ virJSONValueFromString(const char *jsonstring G_GNUC_UNUSED)
 }
 
 
+virJSONStreamParser *
+virJSONStreamParserNew(void)
+{
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("No JSON parser implementation is available"));
+    return NULL;
+}
+
+
+void
+virJSONStreamParserFree(virJSONStreamParser *sp)
+{
+    g_free(sp);
+}
+
+
+int
+virJSONStreamParserFeed(virJSONStreamParser *sp G_GNUC_UNUSED,
+                        const char *data G_GNUC_UNUSED,
+                        size_t len G_GNUC_UNUSED)
+{
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("No JSON parser implementation is available"));
+    return -1;
+}
+
+
+virJSONValue *
+virJSONStreamParserFinish(virJSONStreamParser *sp G_GNUC_UNUSED)
+{
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("No JSON parser implementation is available"));
+    return NULL;
+}
+
+
 int
 virJSONValueToBuffer(virJSONValue *object G_GNUC_UNUSED,
                      virBuffer *buf G_GNUC_UNUSED,
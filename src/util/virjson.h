@@ -163,6 +163,18 @@ virJSONValue *virJSONValueCopy(const virJSONValue *in);
 
 char *virJSONStringReformat(const char *jsonstr, bool pretty);
 
+typedef struct _virJSONStreamParser virJSONStreamParser;
+
+virJSONStreamParser *virJSONStreamParserNew(void);
+void virJSONStreamParserFree(virJSONStreamParser *sp);
+int virJSONStreamParserFeed(virJSONStreamParser *sp,
+                            const char *data,
+                            size_t len)
+    ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT;
+virJSONValue *virJSONStreamParserFinish(virJSONStreamParser *sp)
+    ATTRIBUTE_NONNULL(1);
+
 virJSONValue *virJSONValueObjectDeflatten(virJSONValue *json);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virJSONValue, virJSONValueFree);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virJSONStreamParser, virJSONStreamParserFree);
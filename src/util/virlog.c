@@ -287,6 +287,7 @@ virLogReset(void)
     virLogResetFilters();
     virLogResetOutputs();
     virLogDefaultPriority = VIR_LOG_DEFAULT;
+    g_atomic_int_set(&virLogAsync, 0);
     virLogUnlock();
     return 0;
 }
@@ -479,73 +480,26 @@ virLogSourceUpdate(virLogSource *source)
 }
 
 
-/**
- * virLogVMessage:
- * @source: where is that message coming from
- * @priority: the priority level
- * @filename: file where the message was emitted
- * @linenr: line where the message was emitted
- * @funcname: the function emitting the (debug) message
- * @metadata: NULL or metadata array, terminated by an item with NULL key
- * @fmt: the string format
- * @vargs: format args
+/*
+ * virLogOutputMessage:
  *
- * Call the libvirt logger with some information. Based on the configuration
- * the message may be stored, sent to output or just discarded
+ * Pushes a formatted message to the outputs defined, if none exist
+ * then use stderr. Must be called with virLogMutex held.
  */
 static void
-G_GNUC_PRINTF(7, 0)
-virLogVMessage(virLogSource *source,
-               virLogPriority priority,
-               const char *filename,
-               int linenr,
-               const char *funcname,
-               struct _virLogMetadata *metadata,
-               const char *fmt,
-               va_list vargs)
+virLogOutputMessage(virLogSource *source,
+                    virLogPriority priority,
+                    const char *filename,
+                    int linenr,
+                    const char *funcname,
+                    const char *timestamp,
+                    struct _virLogMetadata *metadata,
+                    const char *str,
+                    const char *msg)
 {
     static bool logInitMessageStderr = true;
-    g_autofree char *str = NULL;
-    g_autofree char *msg = NULL;
-    char timestamp[VIR_TIME_STRING_BUFLEN];
     size_t i;
-    int saved_errno = errno;
-
-    if (virLogInitialize() < 0)
-        return;
-
-    if (fmt == NULL)
-        return;
-
-    /*
-     * 3 intentionally non-thread safe variable reads.
-     * Since writes to the variable are serialized on
-     * virLogLock, worst case result is a log message
-     * is accidentally dropped or emitted, if another
-     * thread is updating log filter list concurrently
-     * with a log message emission.
-     */
-    if (source->serial < virLogFiltersSerial)
-        virLogSourceUpdate(source);
-    if (priority < source->priority)
-        goto cleanup;
 
-    /*
-     * serialize the error message, add level and timestamp
-     */
-    str = g_strdup_vprintf(fmt, vargs);
-
-    virLogFormatString(&msg, linenr, funcname, priority, str);
-
-    if (virTimeStringNowRaw(timestamp) < 0)
-        timestamp[0] = '\0';
-
-    virLogLock();
-
-    /*
-     * Push the message to the outputs defined, if none exist then
-     * use stderr.
-     */
     for (i = 0; i < virLogNbOutputs; i++) {
         if (priority >= virLogOutputs[i]->priority) {
             if (virLogOutputs[i]->logInitMessage) {
@@ -600,6 +554,368 @@ virLogVMessage(virLogSource *source,
                          timestamp, metadata,
                          str, msg, (void *) STDERR_FILENO);
     }
+}
+
+
+/*
+ * Asynchronous logging
+ *
+ * When enabled, debug and info messages are not passed to the outputs
+ * by the thread emitting them. The thread queues the formatted message
+ * in a ring buffer of its own without taking any lock, and a dedicated
+ * writer thread drains the rings into the outputs. When a ring is full
+ * the message is dropped and counted, the writer then reports how many
+ * were lost. Warnings, errors and messages carrying metadata are always
+ * written synchronously, after flushing what their thread queued.
+ */
+#define VIR_LOG_RING_SIZE 256
+#define VIR_LOG_ASYNC_INTERVAL (100 * 1000) /* microseconds */
+
+typedef struct _virLogRingEntry virLogRingEntry;
+struct _virLogRingEntry {
+    virLogSource *source;
+    virLogPriority priority;
+    const char *filename;
+    int linenr;
+    const char *funcname;
+    char timestamp[VIR_TIME_STRING_BUFLEN];
+    char *str;
+    char *msg;
+};
+
+typedef struct _virLogRing virLogRing;
+struct _virLogRing {
+    virLogRing *next;
+    unsigned int head; /* advanced by the owning thread only */
+    unsigned int tail; /* advanced with virLogMutex held */
+    unsigned int dropped;
+    int orphaned; /* set once the owning thread exited */
+    virLogRingEntry entries[VIR_LOG_RING_SIZE];
+};
+
+static int virLogAsync;
+static virLogRing *virLogRings; /* protected by virLogMutex */
+static unsigned long long virLogAsyncDropped;
+
+static GMutex virLogAsyncLock;
+static GCond virLogAsyncCond;
+static bool virLogAsyncWakeup;
+
+
+static void
+virLogRingRelease(void *data)
+{
+    virLogRing *ring = data;
+
+    /* the writer frees the ring once it is drained */
+    g_atomic_int_set(&ring->orphaned, 1);
+}
+
+static GPrivate virLogRingKey = G_PRIVATE_INIT(virLogRingRelease);
+
+
+static void
+virLogAsyncKick(void)
+{
+    g_mutex_lock(&virLogAsyncLock);
+    virLogAsyncWakeup = true;
+    g_cond_signal(&virLogAsyncCond);
+    g_mutex_unlock(&virLogAsyncLock);
+}
+
+
+static void
+virLogAsyncQueue(virLogSource *source,
+                 virLogPriority priority,
+                 const char *filename,
+                 int linenr,
+                 const char *funcname,
+                 const char *timestamp,
+                 char *str,
+                 char *msg)
+{
+    virLogRing *ring = g_private_get(&virLogRingKey);
+    virLogRingEntry *entry;
+    unsigned int head;
+    unsigned int pending;
+
+    if (!ring) {
+        ring = g_new0(virLogRing, 1);
+        g_private_set(&virLogRingKey, ring);
+
+        virLogLock();
+        ring->next = virLogRings;
+        virLogRings = ring;
+        virLogUnlock();
+    }
+
+    head = ring->head;
+    pending = head - g_atomic_int_get(&ring->tail);
+
+    if (pending >= VIR_LOG_RING_SIZE) {
+        g_atomic_int_inc(&ring->dropped);
+        g_free(str);
+        g_free(msg);
+        return;
+    }
+
+    entry = &ring->entries[head % VIR_LOG_RING_SIZE];
+    entry->source = source;
+    entry->priority = priority;
+    entry->filename = filename;
+    entry->linenr = linenr;
+    entry->funcname = funcname;
+    g_strlcpy(entry->timestamp, timestamp, sizeof(entry->timestamp));
+    entry->str = str;
+    entry->msg = msg;
+
+    /* publishes the entry to the writer thread */
+    g_atomic_int_set(&ring->head, head + 1);
+
+    /* don't wait for the writer's timeout if the ring is filling up */
+    if (pending + 1 == VIR_LOG_RING_SIZE / 2)
+        virLogAsyncKick();
+}
+
+
+static void
+virLogAsyncReportDropped(unsigned int dropped)
+{
+    g_autofree char *str = NULL;
+    g_autofree char *msg = NULL;
+    char timestamp[VIR_TIME_STRING_BUFLEN];
+
+    virLogAsyncDropped += dropped;
+
+    str = g_strdup_printf("dropped %u log messages (%llu in total)",
+                          dropped, virLogAsyncDropped);
+    virLogFormatString(&msg, __LINE__, __func__, VIR_LOG_WARN, str);
+
+    if (virTimeStringNowRaw(timestamp) < 0)
+        timestamp[0] = '\0';
+
+    virLogOutputMessage(&virLogSelf, VIR_LOG_WARN,
+                        __FILE__, __LINE__, __func__,
+                        timestamp, NULL, str, msg);
+}
+
+
+/*
+ * Passes the messages queued in @ring to the outputs. Must be called
+ * with virLogMutex held. Returns true if there were any.
+ */
+static bool
+virLogRingDrain(virLogRing *ring)
+{
+    unsigned int head = g_atomic_int_get(&ring->head);
+    unsigned int tail = ring->tail;
+    unsigned int dropped;
+    bool found = false;
+
+    for (; tail != head; tail++) {
+        virLogRingEntry *entry = &ring->entries[tail % VIR_LOG_RING_SIZE];
+
+        virLogOutputMessage(entry->source, entry->priority,
+                            entry->filename, entry->linenr,
+                            entry->funcname, entry->timestamp,
+                            NULL, entry->str, entry->msg);
+        g_clear_pointer(&entry->str, g_free);
+        g_clear_pointer(&entry->msg, g_free);
+        found = true;
+    }
+    g_atomic_int_set(&ring->tail, tail);
+
+    if ((dropped = g_atomic_int_get(&ring->dropped)) > 0) {
+        g_atomic_int_add(&ring->dropped, -(int) dropped);
+        virLogAsyncReportDropped(dropped);
+    }
+
+    return found;
+}
+
+
+/*
+ * Passes all queued messages to the outputs. Returns true if there
+ * were any.
+ */
+static bool
+virLogAsyncDrain(void)
+{
+    virLogRing **prev = &virLogRings;
+    virLogRing *ring;
+    bool found = false;
+
+    /* Held across the whole walk, since both the writer thread and
+     * virLogSetAsync drain the rings and either may unlink a ring
+     * @prev points to */
+    virLogLock();
+    while ((ring = *prev)) {
+        if (virLogRingDrain(ring))
+            found = true;
+
+        if (g_atomic_int_get(&ring->orphaned) &&
+            g_atomic_int_get(&ring->head) == ring->tail) {
+            *prev = ring->next;
+            g_free(ring);
+        } else {
+            prev = &ring->next;
+        }
+    }
+    virLogUnlock();
+
+    return found;
+}
+
+
+static void
+virLogAsyncWriter(void *opaque G_GNUC_UNUSED)
+{
+    while (true) {
+        gint64 deadline;
+
+        if (virLogAsyncDrain())
+            continue;
+
+        deadline = g_get_monotonic_time() + VIR_LOG_ASYNC_INTERVAL;
+
+        g_mutex_lock(&virLogAsyncLock);
+        while (!virLogAsyncWakeup &&
+               g_cond_wait_until(&virLogAsyncCond, &virLogAsyncLock, deadline))
+            ;
+        virLogAsyncWakeup = false;
+        g_mutex_unlock(&virLogAsyncLock);
+    }
+}
+
+
+static int
+virLogAsyncOnceInit(void)
+{
+    virThread thread;
+
+    if (virThreadCreateFull(&thread, false, virLogAsyncWriter,
+                            "log-writer", false, NULL) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to create log writer thread"));
+        return -1;
+    }
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(virLogAsync);
+
+
+/**
+ * virLogSetAsync:
+ * @async: whether to write debug and info messages asynchronously
+ *
+ * Switches debug and info messages between being written to the
+ * outputs by the emitting thread and being queued for a dedicated
+ * writer thread. In the asynchronous mode messages may be dropped if
+ * they are emitted faster than the outputs can take them. Switching
+ * back to synchronous mode writes out the messages queued so far.
+ *
+ * The writer thread doesn't survive fork(), daemons have to enable the
+ * asynchronous mode only once they are running in the background.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virLogSetAsync(bool async)
+{
+    if (virLogInitialize() < 0)
+        return -1;
+
+    if (async && virLogAsyncInitialize() < 0)
+        return -1;
+
+    g_atomic_int_set(&virLogAsync, async);
+
+    /* Flush what is queued already. The rings are processed under
+     * virLogMutex, so this can race with the writer thread safely. */
+    if (!async)
+        virLogAsyncDrain();
+
+    return 0;
+}
+
+
+/**
+ * virLogVMessage:
+ * @source: where is that message coming from
+ * @priority: the priority level
+ * @filename: file where the message was emitted
+ * @linenr: line where the message was emitted
+ * @funcname: the function emitting the (debug) message
+ * @metadata: NULL or metadata array, terminated by an item with NULL key
+ * @fmt: the string format
+ * @vargs: format args
+ *
+ * Call the libvirt logger with some information. Based on the configuration
+ * the message may be stored, sent to output or just discarded
+ */
+static void
+G_GNUC_PRINTF(7, 0)
+virLogVMessage(virLogSource *source,
+               virLogPriority priority,
+               const char *filename,
+               int linenr,
+               const char *funcname,
+               struct _virLogMetadata *metadata,
+               const char *fmt,
+               va_list vargs)
+{
+    g_autofree char *str = NULL;
+    g_autofree char *msg = NULL;
+    char timestamp[VIR_TIME_STRING_BUFLEN];
+    virLogRing *ring;
+    int saved_errno = errno;
+
+    if (virLogInitialize() < 0)
+        return;
+
+    if (fmt == NULL)
+        return;
+
+    /*
+     * 3 intentionally non-thread safe variable reads.
+     * Since writes to the variable are serialized on
+     * virLogLock, worst case result is a log message
+     * is accidentally dropped or emitted, if another
+     * thread is updating log filter list concurrently
+     * with a log message emission.
+     */
+    if (source->serial < virLogFiltersSerial)
+        virLogSourceUpdate(source);
+    if (priority < source->priority)
+        goto cleanup;
+
+    /*
+     * serialize the error message, add level and timestamp
+     */
+    str = g_strdup_vprintf(fmt, vargs);
+
+    virLogFormatString(&msg, linenr, funcname, priority, str);
+
+    if (virTimeStringNowRaw(timestamp) < 0)
+        timestamp[0] = '\0';
+
+    if (priority < VIR_LOG_WARN && !metadata &&
+        g_atomic_int_get(&virLogAsync)) {
+        virLogAsyncQueue(source, priority, filename, linenr, funcname,
+                         timestamp, g_steal_pointer(&str),
+                         g_steal_pointer(&msg));
+        goto cleanup;
+    }
+
+    virLogLock();
+    /* Write out what this thread queued before, so that its messages
+     * don't get reordered when a warning overtakes them */
+    if ((ring = g_private_get(&virLogRingKey)))
+        virLogRingDrain(ring);
+    virLogOutputMessage(source, priority, filename, linenr, funcname,
+                        timestamp, metadata, str, msg);
     virLogUnlock();
 
  cleanup:
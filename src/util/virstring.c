@@ -1001,6 +1001,50 @@ virStringBufferIsPrintable(const uint8_t *buf,
 }
 
 
+/**
+ * virStringBufferIsZero:
+ * @buf: buffer to check
+ * @buflen: size of @buf in bytes
+ *
+ * Checks whether @buf contains only zero bytes. Unlike comparing @buf
+ * against a zeroed buffer with memcmp() this touches only @buf and
+ * tests several words per iteration, which matters when scanning
+ * whole disk images for holes.
+ *
+ * Returns true if all @buflen bytes of @buf are zero.
+ */
+bool
+virStringBufferIsZero(const void *buf,
+                      size_t buflen)
+{
+    const unsigned char *p = buf;
+    const unsigned char *end = p + buflen;
+    unsigned long w[8];
+
+    /* bytes up to the first word boundary */
+    while (p < end && ((uintptr_t) p % sizeof(w[0])) != 0) {
+        if (*p++)
+            return false;
+    }
+
+    /* the memcpy() is optimized to aligned loads and keeps us clear of
+     * aliasing issues */
+    while ((size_t) (end - p) >= sizeof(w)) {
+        memcpy(w, p, sizeof(w));
+        if (w[0] | w[1] | w[2] | w[3] | w[4] | w[5] | w[6] | w[7])
+            return false;
+        p += sizeof(w);
+    }
+
+    while (p < end) {
+        if (*p++)
+            return false;
+    }
+
+    return true;
+}
+
+
 /**
  * virStringTrimOptionalNewline:
  * @str: the string to modify in-place
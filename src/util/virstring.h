@@ -131,6 +131,7 @@ void virStringFilterChars(char *str, const char *valid);
 
 bool virStringIsPrintable(const char *str);
 bool virStringBufferIsPrintable(const uint8_t *buf, size_t buflen);
+bool virStringBufferIsZero(const void *buf, size_t buflen);
 
 void virStringTrimOptionalNewline(char *str);
 
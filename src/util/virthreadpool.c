@@ -30,11 +30,32 @@
 #define VIR_FROM_THIS VIR_FROM_NONE
 
 typedef struct _virThreadPoolJob virThreadPoolJob;
+
+/* Jobs submitted on behalf of the same owner, e.g. a client */
+typedef struct _virThreadPoolOwner virThreadPoolOwner;
+struct _virThreadPoolOwner {
+    const void *key;
+    size_t queued;
+    size_t running;
+
+    /* queued jobs of the owner, oldest first */
+    virThreadPoolJob *head;
+    virThreadPoolJob *tail;
+
+    /* position among the owners with queued jobs */
+    virThreadPoolOwner *prev;
+    virThreadPoolOwner *next;
+};
+
 struct _virThreadPoolJob {
     virThreadPoolJob *prev;
     virThreadPoolJob *next;
     unsigned int priority;
 
+    virThreadPoolOwner *owner;
+    virThreadPoolJob *ownerPrev;
+    virThreadPoolJob *ownerNext;
+
     void *data;
 };
 
@@ -54,6 +75,12 @@ struct _virThreadPool {
     void *jobOpaque;
     virThreadPoolJobList jobList;
     size_t jobQueueDepth;
+    GHashTable *owners; /* owner key -> virThreadPoolOwner */
+    virThreadPoolOwner anonymous; /* owner of jobs queued without one */
+
+    /* owners with queued jobs, the first one is served next */
+    virThreadPoolOwner *ownersHead;
+    virThreadPoolOwner *ownersTail;
 
     virMutex mutex;
     virCond cond;
@@ -85,6 +112,110 @@ static inline bool virThreadPoolWorkerQuitHelper(size_t count, size_t limit)
     return count > limit;
 }
 
+
+static void
+virThreadPoolOwnersAppend(virThreadPool *pool,
+                          virThreadPoolOwner *owner)
+{
+    owner->prev = pool->ownersTail;
+    owner->next = NULL;
+    if (pool->ownersTail)
+        pool->ownersTail->next = owner;
+    else
+        pool->ownersHead = owner;
+    pool->ownersTail = owner;
+}
+
+
+static void
+virThreadPoolOwnersRemove(virThreadPool *pool,
+                          virThreadPoolOwner *owner)
+{
+    if (owner->prev)
+        owner->prev->next = owner->next;
+    else
+        pool->ownersHead = owner->next;
+    if (owner->next)
+        owner->next->prev = owner->prev;
+    else
+        pool->ownersTail = owner->prev;
+    owner->prev = owner->next = NULL;
+}
+
+
+static void
+virThreadPoolOwnerEnqueue(virThreadPool *pool,
+                          virThreadPoolJob *job)
+{
+    virThreadPoolOwner *owner = job->owner;
+
+    /* an owner without queued jobs waits for its turn behind the others */
+    if (!owner->head)
+        virThreadPoolOwnersAppend(pool, owner);
+
+    job->ownerPrev = owner->tail;
+    if (owner->tail)
+        owner->tail->ownerNext = job;
+    else
+        owner->head = job;
+    owner->tail = job;
+
+    owner->queued++;
+}
+
+
+static void
+virThreadPoolOwnerDequeue(virThreadPool *pool,
+                          virThreadPoolJob *job)
+{
+    virThreadPoolOwner *owner = job->owner;
+
+    if (job->ownerPrev)
+        job->ownerPrev->ownerNext = job->ownerNext;
+    else
+        owner->head = job->ownerNext;
+    if (job->ownerNext)
+        job->ownerNext->ownerPrev = job->ownerPrev;
+    else
+        owner->tail = job->ownerPrev;
+
+    owner->queued--;
+
+    if (!owner->head)
+        virThreadPoolOwnersRemove(pool, owner);
+}
+
+
+/* The owners of queued jobs take turns, each turn starts the oldest job
+ * of an owner. This way a single owner flooding the pool can't keep
+ * the jobs of others waiting until all of its jobs are done, while jobs
+ * of the same owner are still processed in order. Jobs queued without
+ * an owner share the turns of one anonymous owner.
+ */
+static virThreadPoolJob *
+virThreadPoolPickJob(virThreadPool *pool)
+{
+    virThreadPoolOwner *owner = pool->ownersHead;
+
+    /* the owner's next job waits for the others to take their turn */
+    if (owner->head->ownerNext && owner != pool->ownersTail) {
+        virThreadPoolOwnersRemove(pool, owner);
+        virThreadPoolOwnersAppend(pool, owner);
+    }
+
+    return owner->head;
+}
+
+
+static void
+virThreadPoolOwnerRelease(virThreadPool *pool,
+                          virThreadPoolOwner *owner)
+{
+    if (owner != &pool->anonymous &&
+        owner->queued == 0 && owner->running == 0)
+        g_hash_table_remove(pool->owners, owner->key);
+}
+
 static void virThreadPoolWorker(void *opaque)
 {
     struct virThreadPoolWorkerData *data = opaque;
@@ -94,6 +225,7 @@ static void virThreadPoolWorker(void *opaque)
     size_t *curWorkers = priority ? &pool->nPrioWorkers : &pool->nWorkers;
     size_t *maxLimit = priority ? &pool->maxPrioWorkers : &pool->maxWorkers;
     virThreadPoolJob *job = NULL;
+    virThreadPoolOwner *owner;
 
     VIR_FREE(data);
 
@@ -131,7 +263,7 @@ static void virThreadPoolWorker(void *opaque)
         if (priority) {
             job = pool->jobList.firstPrio;
         } else {
-            job = pool->jobList.head;
+            job = virThreadPoolPickJob(pool);
         }
 
         if (job == pool->jobList.firstPrio) {
@@ -155,10 +287,17 @@ static void virThreadPoolWorker(void *opaque)
 
         pool->jobQueueDepth--;
 
+        owner = job->owner;
+        virThreadPoolOwnerDequeue(pool, job);
+        owner->running++;
+
         virMutexUnlock(&pool->mutex);
         (pool->jobFunc)(job->data, pool->jobOpaque);
         VIR_FREE(job);
         virMutexLock(&pool->mutex);
+
+        owner->running--;
+        virThreadPoolOwnerRelease(pool, owner);
     }
 
  out:
@@ -233,6 +372,8 @@ virThreadPoolNewFull(size_t minWorkers,
     pool->jobFunc = func;
     pool->jobName = name;
     pool->jobOpaque = opaque;
+    pool->owners = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                         NULL, g_free);
 
     if (virMutexInit(&pool->mutex) < 0)
         goto error;
@@ -290,6 +431,11 @@ virThreadPoolDrainLocked(virThreadPool *pool)
         pool->jobList.head = pool->jobList.head->next;
         VIR_FREE(job);
     }
+
+    pool->ownersHead = pool->ownersTail = NULL;
+    pool->anonymous.head = pool->anonymous.tail = NULL;
+    pool->anonymous.queued = 0;
+    g_hash_table_remove_all(pool->owners);
 }
 
 void virThreadPoolFree(virThreadPool *pool)
@@ -307,6 +453,7 @@ void virThreadPoolFree(virThreadPool *pool)
     virCondDestroy(&pool->cond);
     g_free(pool->prioWorkers);
     virCondDestroy(&pool->prioCond);
+    g_hash_table_unref(pool->owners);
     g_free(pool);
 }
 
@@ -377,6 +524,20 @@ size_t virThreadPoolGetJobQueueDepth(virThreadPool *pool)
     return ret;
 }
 
+size_t virThreadPoolGetOwnerJobQueueDepth(virThreadPool *pool,
+                                          const void *owner)
+{
+    virThreadPoolOwner *entry;
+    size_t ret = 0;
+
+    virMutexLock(&pool->mutex);
+    if ((entry = g_hash_table_lookup(pool->owners, owner)))
+        ret = entry->queued;
+    virMutexUnlock(&pool->mutex);
+
+    return ret;
+}
+
 /*
  * @priority - job priority
  * Return: 0 on success, -1 otherwise
@@ -384,6 +545,23 @@ size_t virThreadPoolGetJobQueueDepth(virThreadPool *pool)
 int virThreadPoolSendJob(virThreadPool *pool,
                          unsigned int priority,
                          void *jobData)
+{
+    return virThreadPoolSendJobFull(pool, priority, NULL, jobData);
+}
+
+/*
+ * @priority - job priority
+ * @owner - identifies whom the job is processed for, may be NULL
+ *
+ * Workers are shared fairly among owners of queued jobs, see
+ * virThreadPoolPickJob. Jobs without @owner share a single turn.
+ *
+ * Return: 0 on success, -1 otherwise
+ */
+int virThreadPoolSendJobFull(virThreadPool *pool,
+                             unsigned int priority,
+                             const void *owner,
+                             void *jobData)
 {
     virThreadPoolJob *job;
 
@@ -401,6 +579,15 @@ int virThreadPoolSendJob(virThreadPool *pool,
     job->data = jobData;
     job->priority = priority;
 
+    if (!owner) {
+        job->owner = &pool->anonymous;
+    } else if (!(job->owner = g_hash_table_lookup(pool->owners, owner))) {
+        job->owner = g_new0(virThreadPoolOwner, 1);
+        job->owner->key = owner;
+        g_hash_table_insert(pool->owners, (void *) owner, job->owner);
+    }
+    virThreadPoolOwnerEnqueue(pool, job);
+
     job->prev = pool->jobList.tail;
     if (pool->jobList.tail)
         pool->jobList.tail->next = job;
@@ -40,6 +40,8 @@ size_t virThreadPoolGetPriorityWorkers(virThreadPool *pool);
 size_t virThreadPoolGetCurrentWorkers(virThreadPool *pool);
 size_t virThreadPoolGetFreeWorkers(virThreadPool *pool);
 size_t virThreadPoolGetJobQueueDepth(virThreadPool *pool);
+size_t virThreadPoolGetOwnerJobQueueDepth(virThreadPool *pool,
+                                          const void *owner);
 
 void virThreadPoolFree(virThreadPool *pool);
 
@@ -48,6 +50,12 @@ int virThreadPoolSendJob(virThreadPool *pool,
                          void *jobdata) ATTRIBUTE_NONNULL(1)
                                         G_GNUC_WARN_UNUSED_RESULT;
 
+int virThreadPoolSendJobFull(virThreadPool *pool,
+                             unsigned int priority,
+                             const void *owner,
+                             void *jobdata) ATTRIBUTE_NONNULL(1)
+                                            G_GNUC_WARN_UNUSED_RESULT;
+
 int virThreadPoolSetParameters(virThreadPool *pool,
                                long long int minWorkers,
                                long long int maxWorkers,
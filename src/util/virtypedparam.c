@@ -916,3 +916,30 @@ virTypedParamListAddDouble(virTypedParamList *list,
 
     return ret;
 }
+
+
+/**
+ * virTypedParamListAddParams:
+ * @list: typed parameter list
+ * @params: array of typed parameters
+ * @nparams: number of parameters in @params
+ *
+ * Appends a deep copy of @params to @list.
+ */
+void
+virTypedParamListAddParams(virTypedParamList *list,
+                           virTypedParameterPtr params,
+                           size_t nparams)
+{
+    size_t i;
+
+    VIR_RESIZE_N(list->par, list->par_alloc, list->npar, nparams);
+
+    for (i = 0; i < nparams; i++) {
+        virTypedParameterPtr par = list->par + list->npar++;
+
+        *par = params[i];
+        if (par->type == VIR_TYPED_PARAM_STRING)
+            par->value.s = g_strdup(params[i].value.s);
+    }
+}
@@ -173,3 +173,6 @@ int virTypedParamListAddDouble(virTypedParamList *list,
                                const char *namefmt,
                                ...)
     G_GNUC_PRINTF(3, 4) G_GNUC_WARN_UNUSED_RESULT;
+void virTypedParamListAddParams(virTypedParamList *list,
+                                virTypedParameterPtr params,
+                                size_t nparams);
@@ -24,6 +24,8 @@
 #include "virlog.h"
 
 #include "domain_conf.h"
+#include "virdomainobjlist.h"
+#include "viruuid.h"
 
 #define VIR_FROM_THIS VIR_FROM_NONE
 
@@ -76,6 +78,245 @@ static int testGetFilesystem(const void *opaque)
     return ret;
 }
 
+static virDomainObj *
+testDomainObjListAdd(virDomainObjList *doms,
+                     const char *name,
+                     const char *uuid)
+{
+    g_autoptr(virDomainDef) def = NULL;
+    g_autofree char *filename = NULL;
+    virDomainObj *vm;
+
+    filename = g_strdup_printf("%s/domainconfdata/getfilesystem.xml",
+                               abs_srcdir);
+
+    if (!(def = virDomainDefParseFile(filename, xmlopt, NULL, 0)))
+        return NULL;
+
+    g_free(def->name);
+    def->name = g_strdup(name);
+    if (virUUIDParse(uuid, def->uuid) < 0)
+        return NULL;
+
+    if (!(vm = virDomainObjListAdd(doms, def, xmlopt, 0, NULL)))
+        return NULL;
+    def = NULL;
+
+    /* Keep the reference, but let lookups lock the object */
+    virObjectUnlock(vm);
+    return vm;
+}
+
+
+static void
+testDomainObjSetID(virDomainObjList *doms,
+                   virDomainObj *vm,
+                   int id,
+                   bool update)
+{
+    virObjectLock(vm);
+    vm->def->id = id;
+    if (update)
+        virDomainObjListUpdateID(doms, vm);
+    virObjectUnlock(vm);
+}
+
+
+static int
+testDomainObjListCheckID(virDomainObjList *doms,
+                         int id,
+                         virDomainObj *expect)
+{
+    virDomainObj *vm = virDomainObjListFindByID(doms, id);
+    int ret = 0;
+
+    if (vm != expect) {
+        fprintf(stderr, "Lookup of ID %d returned %p, expected %p\n",
+                id, vm, expect);
+        ret = -1;
+    }
+
+    virDomainObjEndAPI(&vm);
+    return ret;
+}
+
+
+static int
+testDomainObjListFindByID(const void *opaque G_GNUC_UNUSED)
+{
+    virDomainObjList *doms = NULL;
+    virDomainObj *vm1 = NULL;
+    virDomainObj *vm2 = NULL;
+    int ret = -1;
+
+    if (!(doms = virDomainObjListNew()))
+        return -1;
+
+    if (!(vm1 = testDomainObjListAdd(doms, "demo1",
+                                     "8369f1ac-7e46-e869-4ca5-759d51478066")) ||
+        !(vm2 = testDomainObjListAdd(doms, "demo2",
+                                     "8369f1ac-7e46-e869-4ca5-759d51478067")))
+        goto cleanup;
+
+    /* Neither domain is running yet */
+    if (testDomainObjListCheckID(doms, 1, NULL) < 0)
+        goto cleanup;
+
+    /* Start and stop reported through the index */
+    testDomainObjSetID(doms, vm1, 1, true);
+    if (testDomainObjListCheckID(doms, 1, vm1) < 0 ||
+        testDomainObjListCheckID(doms, 2, NULL) < 0)
+        goto cleanup;
+
+    testDomainObjSetID(doms, vm1, -1, true);
+    if (testDomainObjListCheckID(doms, 1, NULL) < 0)
+        goto cleanup;
+
+    /* The ID is free to be reused by another domain */
+    testDomainObjSetID(doms, vm2, 1, true);
+    if (testDomainObjListCheckID(doms, 1, vm2) < 0)
+        goto cleanup;
+
+    /* A driver which doesn't report ID changes must still get correct
+     * results, both for a new ID and for one that went stale after it
+     * was recorded by a previous lookup */
+    testDomainObjSetID(doms, vm1, 2, false);
+    if (testDomainObjListCheckID(doms, 2, vm1) < 0)
+        goto cleanup;
+
+    testDomainObjSetID(doms, vm1, 3, false);
+    if (testDomainObjListCheckID(doms, 2, NULL) < 0 ||
+        testDomainObjListCheckID(doms, 3, vm1) < 0)
+        goto cleanup;
+
+    /* A removed domain must not be found by its ID anymore */
+    virObjectLock(vm2);
+    virDomainObjListRemove(doms, vm2);
+    virObjectUnlock(vm2);
+    if (testDomainObjListCheckID(doms, 1, NULL) < 0 ||
+        testDomainObjListCheckID(doms, 3, vm1) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    virObjectUnref(vm1);
+    virObjectUnref(vm2);
+    virObjectUnref(doms);
+    return ret;
+}
+
+static int
+testDomainObjSummary(const void *opaque G_GNUC_UNUSED)
+{
+    virDomainObjList *doms = NULL;
+    virDomainObj *vm = NULL;
+    virDomainObj *api = NULL;
+    g_autoptr(virDomainObjSummary) summary = NULL;
+    g_autoptr(virDomainObjSummary) again = NULL;
+    char *names[2] = { NULL, NULL };
+    int ids[2] = { 0, 0 };
+    int nnames;
+    size_t i;
+    int ret = -1;
+
+    if (!(doms = virDomainObjListNew()))
+        return -1;
+
+    if (!(vm = testDomainObjListAdd(doms, "demo",
+                                    "8369f1ac-7e46-e869-4ca5-759d51478066")))
+        goto cleanup;
+
+    /* Adding the domain publishes its first summary */
+    if (!(summary = virDomainObjGetSummary(vm)))
+        goto cleanup;
+
+    if (STRNEQ(summary->def->name, "demo") ||
+        summary->def->id != -1 ||
+        memcmp(summary->def->uuid, vm->def->uuid, VIR_UUID_BUFLEN) != 0) {
+        fprintf(stderr, "Unexpected initial summary\n");
+        goto cleanup;
+    }
+
+    /* Publishing an unchanged domain must not replace the summary */
+    virObjectLock(vm);
+    virDomainObjPublishSummary(vm);
+    virObjectUnlock(vm);
+    again = virDomainObjGetSummary(vm);
+    if (again != summary) {
+        fprintf(stderr, "Summary of an unchanged domain was replaced\n");
+        goto cleanup;
+    }
+    g_clear_pointer(&again, virObjectUnref);
+    g_clear_pointer(&summary, virObjectUnref);
+
+    /* Hold the domain lock as a long running job would. The listing
+     * functions must not wait for it (in this single threaded test they
+     * would never return) and must not see changes made under the lock
+     * until they are published. */
+    virObjectLock(vm);
+    vm->def->id = 5;
+    vm->persistent = true;
+
+    if (virDomainObjListNumOfDomains(doms, true, NULL, NULL) != 0 ||
+        virDomainObjListNumOfDomains(doms, false, NULL, NULL) != 1) {
+        fprintf(stderr, "Listing saw an unpublished change\n");
+        goto unlock;
+    }
+
+    /* A state change publishes everything that changed so far */
+    virDomainObjSetState(vm, VIR_DOMAIN_RUNNING, VIR_DOMAIN_RUNNING_BOOTED);
+
+    if (virDomainObjListNumOfDomains(doms, true, NULL, NULL) != 1 ||
+        virDomainObjListGetActiveIDs(doms, ids, G_N_ELEMENTS(ids),
+                                     NULL, NULL) != 1 ||
+        ids[0] != 5) {
+        fprintf(stderr, "Listing didn't see a published change\n");
+        goto unlock;
+    }
+
+    if (!(summary = virDomainObjGetSummary(vm)) ||
+        summary->state.state != VIR_DOMAIN_RUNNING ||
+        summary->state.reason != VIR_DOMAIN_RUNNING_BOOTED ||
+        !summary->persistent) {
+        fprintf(stderr, "Unexpected summary of a running domain\n");
+        goto unlock;
+    }
+
+    /* Changes without a state change are published once the API is
+     * done with the object */
+    vm->def->id = -1;
+    api = virObjectRef(vm);
+    virDomainObjEndAPI(&api);
+
+    nnames = virDomainObjListGetInactiveNames(doms, names,
+                                              G_N_ELEMENTS(names),
+                                              NULL, NULL);
+    if (nnames != 1 || STRNEQ(names[0], "demo") ||
+        virDomainObjListNumOfDomains(doms, true, NULL, NULL) != 0) {
+        fprintf(stderr, "Listing didn't see the stopped domain\n");
+        goto cleanup;
+    }
+
+    /* Readers holding the old summary keep a consistent copy */
+    if (summary->def->id != 5 || STRNEQ(summary->def->name, "demo")) {
+        fprintf(stderr, "Previously obtained summary was modified\n");
+        goto cleanup;
+    }
+
+    ret = 0;
+    goto cleanup;
+
+ unlock:
+    virObjectUnlock(vm);
+ cleanup:
+    for (i = 0; i < G_N_ELEMENTS(names); i++)
+        g_free(names[i]);
+    virObjectUnref(vm);
+    virObjectUnref(doms);
+    return ret;
+}
+
 static int
 mymain(void)
 {
@@ -103,6 +344,14 @@ mymain(void)
     DO_TEST_GET_FS("/dev/pts", false);
     DO_TEST_GET_FS("/doesnotexist", false);
 
+    if (virTestRun("Domain list lookup by ID",
+                   testDomainObjListFindByID, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Domain summary",
+                   testDomainObjSummary, NULL) < 0)
+        ret = -1;
+
     virObjectUnref(caps);
     virObjectUnref(xmlopt);
 
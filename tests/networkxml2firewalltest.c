@@ -76,20 +76,29 @@ VIR_MOCK_WRAP_RET_ARGS(g_dbus_connection_call_sync,
 static void
 testCommandDryRun(const char *const*args G_GNUC_UNUSED,
                   const char *const*env G_GNUC_UNUSED,
-                  const char *input G_GNUC_UNUSED,
+                  const char *input,
                   char **output,
                   char **error,
                   int *status,
-                  void *opaque G_GNUC_UNUSED)
+                  void *opaque)
 {
+    virBuffer *buf = opaque;
+
+    /* rules applied in a batch are only visible in the input */
+    if (input)
+        virBufferAdd(buf, input, -1);
+
     *status = 0;
-    *output = g_strdup("");
-    *error = g_strdup("");
+    if (output)
+        *output = g_strdup("");
+    if (error)
+        *error = g_strdup("");
 }
 
 static int testCompareXMLToArgvFiles(const char *xml,
                                      const char *cmdline,
-                                     const char *baseargs)
+                                     const char *baseargs,
+                                     virNetworkFirewallBackend backend)
 {
     char *actualargv = NULL;
     g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
@@ -98,12 +107,12 @@ static int testCompareXMLToArgvFiles(const char *xml,
     char *actual;
     g_autoptr(virCommandDryRunToken) dryRunToken = virCommandDryRunTokenNew();
 
-    virCommandSetDryRun(dryRunToken, &buf, true, true, testCommandDryRun, NULL);
+    virCommandSetDryRun(dryRunToken, &buf, true, true, testCommandDryRun, &buf);
 
     if (!(def = virNetworkDefParseFile(xml, NULL)))
         goto cleanup;
 
-    if (networkAddFirewallRules(def) < 0)
+    if (networkAddFirewallRules(def, backend) < 0)
         goto cleanup;
 
     actual = actualargv = virBufferContentAndReset(&buf);
@@ -129,6 +138,7 @@ static int testCompareXMLToArgvFiles(const char *xml,
 struct testInfo {
     const char *name;
     const char *baseargs;
+    virNetworkFirewallBackend backend;
 };
 
 
@@ -142,10 +152,15 @@ testCompareXMLToIPTablesHelper(const void *data)
 
     xml = g_strdup_printf("%s/networkxml2firewalldata/%s.xml",
                           abs_srcdir, info->name);
-    args = g_strdup_printf("%s/networkxml2firewalldata/%s-%s.args",
-                           abs_srcdir, info->name, RULESTYPE);
+    if (info->backend == VIR_NETWORK_FIREWALL_BACKEND_NFTABLES)
+        args = g_strdup_printf("%s/networkxml2firewalldata/%s-nftables-%s.args",
+                               abs_srcdir, info->name, RULESTYPE);
+    else
+        args = g_strdup_printf("%s/networkxml2firewalldata/%s-%s.args",
+                               abs_srcdir, info->name, RULESTYPE);
 
-    result = testCompareXMLToArgvFiles(xml, args, info->baseargs);
+    result = testCompareXMLToArgvFiles(xml, args, info->baseargs,
+                                       info->backend);
 
     VIR_FREE(xml);
     VIR_FREE(args);
@@ -163,13 +178,23 @@ mymain(void)
 # define DO_TEST(name) \
     do { \
         struct testInfo info = { \
-            name, baseargs, \
+            name, baseargs, VIR_NETWORK_FIREWALL_BACKEND_IPTABLES, \
         }; \
         if (virTestRun("Network XML-2-iptables " name, \
                        testCompareXMLToIPTablesHelper, &info) < 0) \
             ret = -1; \
     } while (0)
 
+# define DO_TEST_NFTABLES(name) \
+    do { \
+        struct testInfo info = { \
+            name, "", VIR_NETWORK_FIREWALL_BACKEND_NFTABLES, \
+        }; \
+        if (virTestRun("Network XML-2-nftables " name, \
+                       testCompareXMLToIPTablesHelper, &info) < 0) \
+            ret = -1; \
+    } while (0)
+
     if (virFirewallSetBackend(VIR_FIREWALL_BACKEND_DIRECT) < 0) {
         return EXIT_FAILURE;
     }
@@ -187,6 +212,14 @@ mymain(void)
     DO_TEST("nat-ipv6-masquerade");
     DO_TEST("route-default");
 
+    /* nft applies all rules of a network in one batch */
+    virFirewallSetBatching(true);
+
+    DO_TEST_NFTABLES("nat-default");
+    DO_TEST_NFTABLES("nat-tftp");
+    DO_TEST_NFTABLES("nat-ipv6");
+    DO_TEST_NFTABLES("route-default");
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -25,6 +25,7 @@
 
 # include "testutils.h"
 # include "nwfilter/nwfilter_ebiptables_driver.h"
+# include "nwfilter/nwfilter_gentech_driver.h"
 # include "virbuffer.h"
 
 # define LIBVIRT_VIRFIREWALLPRIV_H_ALLOW
@@ -33,6 +34,9 @@
 # define LIBVIRT_VIRCOMMANDPRIV_H_ALLOW
 # include "vircommandpriv.h"
 
+# define LIBVIRT_NWFILTER_GENTECH_DRIVER_PRIV_H_ALLOW
+# include "nwfilter/nwfilter_gentech_driver_priv.h"
+
 # define VIR_FROM_THIS VIR_FROM_NONE
 
 # ifdef __linux__
@@ -406,6 +410,206 @@ static int testCompareXMLToArgvFiles(const char *xml,
     return ret;
 }
 
+static int
+testNWFilterApplyRules(virNWFilterRuleInst **rules,
+                       size_t nrules,
+                       char **actual)
+{
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    g_autoptr(virCommandDryRunToken) dryRunToken = virCommandDryRunTokenNew();
+
+    virCommandSetDryRun(dryRunToken, &buf, true, true, NULL, NULL);
+
+    if (ebiptables_driver.applyNewRules("vnet0", rules, nrules) < 0)
+        return -1;
+
+    *actual = virBufferContentAndReset(&buf);
+    return 0;
+}
+
+
+/*
+ * Instantiates @filter from its cached program and compares the
+ * result to the one of expanding the filter files with @vars.
+ * The value of PORT seen by the first rule must be @port.
+ */
+static int
+testNWFilterProgramCompare(virNWFilterDriverState *driver,
+                           virNWFilterDef *filter,
+                           GHashTable *vars,
+                           const char *port,
+                           size_t nrules,
+                           virNWFilterProgram **prog)
+{
+    g_autofree char *xml = NULL;
+    g_autofree char *expected = NULL;
+    g_autofree char *actual = NULL;
+    virNWFilterRuleInst **rules = NULL;
+    size_t nrulesActual = 0;
+    virNWFilterInst inst;
+    const char *value;
+    size_t i;
+    int ret = -1;
+
+    memset(&inst, 0, sizeof(inst));
+
+    xml = g_strdup_printf("%s/nwfilterxml2firewalldata/%s.xml",
+                          abs_srcdir, filter->name);
+
+    if (virNWFilterDefToInst(xml, vars, &inst) < 0 ||
+        testNWFilterApplyRules(inst.rules, inst.nrules, &expected) < 0)
+        goto cleanup;
+
+    if (!(*prog = virNWFilterProgramGet(driver, filter)) ||
+        virNWFilterProgramToRuleInsts(*prog, vars, &rules, &nrulesActual) < 0 ||
+        testNWFilterApplyRules(rules, nrulesActual, &actual) < 0)
+        goto cleanup;
+
+    if (nrulesActual != nrules) {
+        fprintf(stderr, "Expected %zu rules, got %zu\n", nrules, nrulesActual);
+        goto cleanup;
+    }
+
+    if (!(value = virNWFilterVarValueGetSimple(virHashLookup(rules[0]->vars,
+                                                             "PORT"))) ||
+        STRNEQ(value, port)) {
+        fprintf(stderr, "Expected PORT '%s', got '%s'\n", port, NULLSTR(value));
+        goto cleanup;
+    }
+
+    if (virTestCompareToString(expected, actual) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    for (i = 0; i < nrulesActual; i++)
+        virNWFilterRuleInstFree(rules[i]);
+    g_free(rules);
+    virNWFilterInstReset(&inst);
+    return ret;
+}
+
+
+static int
+testNWFilterProgramCountRules(virNWFilterProgram *prog,
+                              GHashTable *vars,
+                              size_t *nrules)
+{
+    virNWFilterRuleInst **rules = NULL;
+    size_t i;
+
+    *nrules = 0;
+    if (virNWFilterProgramToRuleInsts(prog, vars, &rules, nrules) < 0)
+        return -1;
+
+    for (i = 0; i < *nrules; i++)
+        virNWFilterRuleInstFree(rules[i]);
+    g_free(rules);
+    return 0;
+}
+
+
+static int
+testNWFilterProgramLoad(virNWFilterObjList *nwfilters,
+                        virNWFilterDef *def,
+                        virNWFilterDef **loaded)
+{
+    virNWFilterObj *obj;
+
+    if (!def)
+        return -1;
+
+    if (!(obj = virNWFilterObjListAssignDef(nwfilters, def))) {
+        virNWFilterDefFree(def);
+        return -1;
+    }
+
+    if (loaded)
+        *loaded = virNWFilterObjGetDef(obj);
+    virNWFilterObjUnlock(obj);
+    return 0;
+}
+
+
+static int
+testNWFilterProgram(const void *opaque G_GNUC_UNUSED)
+{
+    virNWFilterDriverState driver = { 0 };
+    g_autofree char *childxml = NULL;
+    g_autofree char *topxml = NULL;
+    g_autoptr(GHashTable) vars = virHashNew(virNWFilterVarValueHashFree);
+    virNWFilterDef *top = NULL;
+    virNWFilterProgram *first;
+    virNWFilterProgram *prog;
+    size_t nrules;
+    int ret = -1;
+
+    childxml = g_strdup_printf("%s/nwfilterxml2firewalldata/cache-child.xml",
+                               abs_srcdir);
+    topxml = g_strdup_printf("%s/nwfilterxml2firewalldata/cache-top.xml",
+                             abs_srcdir);
+
+    if (!(driver.nwfilters = virNWFilterObjListNew()))
+        return -1;
+
+    if (testNWFilterProgramLoad(driver.nwfilters,
+                                virNWFilterDefParseFile(childxml), NULL) < 0 ||
+        testNWFilterProgramLoad(driver.nwfilters,
+                                virNWFilterDefParseFile(topxml), &top) < 0)
+        goto cleanup;
+
+    /* PORT comes from the parameter of the filter reference */
+    if (testSetOneParameter(vars, "ADDR", "10.0.0.1") < 0 ||
+        testNWFilterProgramCompare(&driver, top, vars, "22", 2, &first) < 0)
+        goto cleanup;
+
+    /* The same program with other variables, which take precedence
+     * over the parameters of the filter reference */
+    virHashRemoveAll(vars);
+    if (testSetOneParameter(vars, "ADDR", "10.0.0.2") < 0 ||
+        testSetOneParameter(vars, "PORT", "80") < 0 ||
+        testNWFilterProgramCompare(&driver, top, vars, "80", 2, &prog) < 0)
+        goto cleanup;
+
+    if (prog != first) {
+        fprintf(stderr, "Program was compiled again\n");
+        goto cleanup;
+    }
+
+    /* Redefining a referenced filter must invalidate the program */
+    if (testNWFilterProgramLoad(driver.nwfilters,
+                                virNWFilterDefParseString(
+                                    "<filter name='cache-child'>"
+                                    "  <uuid>d1f2c0a7-5b1e-4c1f-9a8e-3e6f2b7c4d10</uuid>"
+                                    "  <rule action='accept' direction='in'>"
+                                    "    <tcp srcipaddr='$ADDR' dstportstart='$PORT'/>"
+                                    "  </rule>"
+                                    "  <rule action='drop' direction='in'>"
+                                    "    <tcp srcipaddr='$ADDR'/>"
+                                    "  </rule>"
+                                    "</filter>"), NULL) < 0)
+        goto cleanup;
+
+    if (!(prog = virNWFilterProgramGet(&driver, top)) ||
+        testNWFilterProgramCountRules(prog, vars, &nrules) < 0)
+        goto cleanup;
+
+    if (nrules != 3) {
+        fprintf(stderr,
+                "Expected 3 rules after redefining the filter, got %zu\n",
+                nrules);
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    virNWFilterObjListFree(driver.nwfilters);
+    return ret;
+}
+
+
 struct testInfo {
     const char *name;
 };
@@ -491,6 +695,14 @@ mymain(void)
     DO_TEST("udplite-ipv6");
     DO_TEST("vlan");
 
+    if (virNWFilterTechDriversInit(false) < 0)
+        return EXIT_FAILURE;
+
+    if (virTestRun("NWFilter program cache", testNWFilterProgram, NULL) < 0)
+        ret = -1;
+
+    virNWFilterTechDriversShutdown();
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
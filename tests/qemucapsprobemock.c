@@ -79,32 +79,35 @@ qemuMonitorSend(qemuMonitor *mon,
 }
 
 
-static int (*realQemuMonitorJSONIOProcessLine)(qemuMonitor *mon,
-                                               const char *line,
-                                               qemuMonitorMessage *msg);
+static int (*realQemuMonitorJSONIOProcessObject)(qemuMonitor *mon,
+                                                 virJSONValue *obj,
+                                                 const char *line,
+                                                 qemuMonitorMessage *msg);
 
 int
-qemuMonitorJSONIOProcessLine(qemuMonitor *mon,
-                             const char *line,
-                             qemuMonitorMessage *msg)
+qemuMonitorJSONIOProcessObject(qemuMonitor *mon,
+                               virJSONValue *obj,
+                               const char *line,
+                               qemuMonitorMessage *msg)
 {
-    virJSONValue *value = NULL;
     char *json = NULL;
+    bool greeting;
     int ret;
 
-    REAL_SYM(realQemuMonitorJSONIOProcessLine);
+    REAL_SYM(realQemuMonitorJSONIOProcessObject);
 
-    ret = realQemuMonitorJSONIOProcessLine(mon, line, msg);
+    /* @obj is consumed by the real function */
+    if (!(json = virJSONValueToString(obj, true))) {
+        fprintf(stderr, "Failed to reformat reply string '%s'\n", line);
+        abort();
+    }
+    greeting = virJSONValueObjectHasKey(obj, "QMP") == 1;
 
-    if (ret == 0) {
-        if (!(value = virJSONValueFromString(line)) ||
-            !(json = virJSONValueToString(value, true))) {
-            fprintf(stderr, "Failed to reformat reply string '%s'\n", line);
-            abort();
-        }
+    ret = realQemuMonitorJSONIOProcessObject(mon, obj, line, msg);
 
+    if (ret == 0) {
         /* Ignore QMP greeting */
-        if (virJSONValueObjectHasKey(value, "QMP"))
+        if (greeting)
             goto cleanup;
 
         if (first)
@@ -117,6 +120,5 @@ qemuMonitorJSONIOProcessLine(qemuMonitor *mon,
 
  cleanup:
     VIR_FREE(json);
-    virJSONValueFree(value);
     return ret;
 }
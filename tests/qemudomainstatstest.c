@@ -0,0 +1,309 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#ifdef WITH_QEMU
+
+# include "datatypes.h"
+# include "internal.h"
+# include "virtypedparam.h"
+# include "conf/domain_conf.h"
+# include "qemu/qemu_domain.h"
+# define LIBVIRT_QEMU_DRIVERPRIV_H_ALLOW
+# include "qemu/qemu_driverpriv.h"
+
+# include "testutilsqemu.h"
+
+# define VIR_FROM_THIS VIR_FROM_QEMU
+
+static virQEMUDriver driver;
+
+static virDomainObj *
+testDomainStatsNewVM(int id)
+{
+    virDomainObj *vm;
+
+    if (!(vm = virDomainObjNew(driver.xmlopt)))
+        return NULL;
+
+    vm->def = virDomainDefNew();
+    vm->def->virtType = VIR_DOMAIN_VIRT_QEMU;
+    vm->def->name = g_strdup_printf("stats%d", id);
+    vm->def->uuid[0] = id;
+    virDomainDefSetMemoryTotal(vm->def, 1024 * 1024);
+    virDomainObjSetState(vm, VIR_DOMAIN_SHUTOFF, id % 2);
+
+    virObjectUnlock(vm);
+    return vm;
+}
+
+
+struct testParallelData {
+    size_t nvms;
+    unsigned int nworkers;
+};
+
+static int
+testDomainStatsParallel(const void *opaque)
+{
+    const struct testParallelData *data = opaque;
+    virConnectPtr conn = NULL;
+    virDomainObj **vms = NULL;
+    virDomainStatsRecordPtr *records = NULL;
+    size_t i;
+    int ret = -1;
+
+    if (!(conn = virGetConnect()))
+        return -1;
+    conn->privateData = &driver;
+
+    vms = g_new0(virDomainObj *, data->nvms);
+    records = g_new0(virDomainStatsRecordPtr, data->nvms + 1);
+
+    for (i = 0; i < data->nvms; i++) {
+        if (!(vms[i] = testDomainStatsNewVM(i)))
+            goto cleanup;
+    }
+
+    if (qemuConnectGetAllDomainStatsParallel(conn, vms, data->nvms,
+                                             VIR_DOMAIN_STATS_STATE, 0,
+                                             records, data->nworkers,
+                                             0, 0) < 0)
+        goto cleanup;
+
+    /* Records must be in the order of the domains, regardless of which
+     * worker gathered them and when */
+    for (i = 0; i < data->nvms; i++) {
+        int reason;
+
+        if (!records[i] ||
+            STRNEQ(records[i]->dom->name, vms[i]->def->name)) {
+            VIR_TEST_DEBUG("Record %zu doesn't belong to '%s'",
+                           i, vms[i]->def->name);
+            goto cleanup;
+        }
+
+        if (virTypedParamsGetInt(records[i]->params, records[i]->nparams,
+                                 "state.reason", &reason) != 1 ||
+            (size_t) reason != i % 2) {
+            VIR_TEST_DEBUG("Record %zu has unexpected state", i);
+            goto cleanup;
+        }
+    }
+
+    ret = 0;
+
+ cleanup:
+    virDomainStatsRecordListFree(records);
+    virObjectListFreeCount(vms, data->nvms);
+    conn->privateData = NULL;
+    virObjectUnref(conn);
+    return ret;
+}
+
+
+static int
+testDomainStatsCheck(virConnectPtr conn,
+                     virDomainObj *vm,
+                     unsigned int stats,
+                     long long now,
+                     unsigned int maxAge,
+                     unsigned int flags,
+                     unsigned long long expect)
+{
+    virDomainStatsRecordPtr records[2] = { NULL, NULL };
+    unsigned long long got = 0;
+    int state;
+    int ret = -1;
+
+    virObjectLock(vm);
+
+    if (qemuDomainGetStats(conn, vm, stats, &records[0],
+                           now, maxAge, flags) < 0)
+        goto cleanup;
+
+    if (stats == VIR_DOMAIN_STATS_STATE) {
+        if (virTypedParamsGetInt(records[0]->params, records[0]->nparams,
+                                 "state.state", &state) != 1)
+            goto cleanup;
+        got = state;
+    } else {
+        if (virTypedParamsGetULLong(records[0]->params, records[0]->nparams,
+                                    "balloon.current", &got) != 1)
+            goto cleanup;
+    }
+
+    if (got != expect) {
+        VIR_TEST_DEBUG("Expected %llu at %lld (max age %u, flags 0x%x), got %llu",
+                       expect, now, maxAge, flags, got);
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    virObjectUnlock(vm);
+    virDomainStatsRecordListFree(records);
+    return ret;
+}
+
+
+static int
+testDomainStatsCache(const void *opaque G_GNUC_UNUSED)
+{
+    virConnectPtr conn = NULL;
+    virDomainObj *vm = NULL;
+    qemuDomainObjPrivate *priv;
+    unsigned int cached = QEMU_DOMAIN_STATS_CACHED;
+    unsigned int job = QEMU_DOMAIN_STATS_HAVE_JOB;
+    int ret = -1;
+
+    if (!(conn = virGetConnect()))
+        return -1;
+    conn->privateData = &driver;
+
+    if (!(vm = testDomainStatsNewVM(0)))
+        goto cleanup;
+    priv = vm->privateData;
+
+    /* Only callers asking for cached stats fill the cache, and groups
+     * which need the monitor only when they were gathered with a job */
+    if (testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_STATE,
+                             10000, 1000, 0, VIR_DOMAIN_SHUTOFF) < 0 ||
+        testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_BALLOON,
+                             10000, 1000, cached, 1024 * 1024) < 0)
+        goto cleanup;
+
+    if (priv->nstatsCache != 0) {
+        VIR_TEST_DEBUG("Unexpected cache entries: %zu", priv->nstatsCache);
+        goto cleanup;
+    }
+
+    if (testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_STATE,
+                             10000, 1000, cached, VIR_DOMAIN_SHUTOFF) < 0 ||
+        testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_BALLOON,
+                             10000, 1000, cached | job, 1024 * 1024) < 0)
+        goto cleanup;
+
+    if (priv->nstatsCache != 2) {
+        VIR_TEST_DEBUG("Unexpected cache entries: %zu", priv->nstatsCache);
+        goto cleanup;
+    }
+
+    virObjectLock(vm);
+    virDomainObjSetState(vm, VIR_DOMAIN_PAUSED, 0);
+    virDomainDefSetMemoryTotal(vm->def, 2 * 1024 * 1024);
+    virObjectUnlock(vm);
+
+    /* Within the max age cached callers get the old values, callers
+     * not asking for them get fresh ones without updating the cache */
+    if (testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_STATE,
+                             10500, 1000, cached, VIR_DOMAIN_SHUTOFF) < 0 ||
+        testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_STATE,
+                             10500, 1000, 0, VIR_DOMAIN_PAUSED) < 0 ||
+        testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_STATE,
+                             11000, 1000, cached, VIR_DOMAIN_SHUTOFF) < 0)
+        goto cleanup;
+
+    /* Data gathered with a job also serves callers without one, but not
+     * callers which want the backing chain */
+    if (testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_BALLOON,
+                             10500, 1000, cached, 1024 * 1024) < 0 ||
+        testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_BALLOON,
+                             10500, 1000, cached | job |
+                             QEMU_DOMAIN_STATS_BACKING, 2 * 1024 * 1024) < 0)
+        goto cleanup;
+
+    /* Expired entries are refreshed */
+    if (testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_STATE,
+                             11001, 1000, cached, VIR_DOMAIN_PAUSED) < 0)
+        goto cleanup;
+
+    virObjectLock(vm);
+    virDomainObjSetState(vm, VIR_DOMAIN_SHUTOFF, 0);
+    virObjectUnlock(vm);
+
+    /* A zero max age disables the cache */
+    if (testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_STATE,
+                             11500, 0, cached, VIR_DOMAIN_SHUTOFF) < 0 ||
+        testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_STATE,
+                             11500, 1000, cached, VIR_DOMAIN_PAUSED) < 0)
+        goto cleanup;
+
+    /* The cache is dropped along with the rest of the live state */
+    virObjectLock(vm);
+    qemuDomainStatsCacheClear(priv);
+    virObjectUnlock(vm);
+
+    if (priv->nstatsCache != 0 ||
+        testDomainStatsCheck(conn, vm, VIR_DOMAIN_STATS_STATE,
+                             11500, 1000, cached, VIR_DOMAIN_SHUTOFF) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    virObjectUnref(vm);
+    conn->privateData = NULL;
+    virObjectUnref(conn);
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+    if (qemuTestDriverInit(&driver) < 0)
+        return EXIT_FAILURE;
+
+# define DO_TEST_PARALLEL(vms, workers) \
+    do { \
+        static struct testParallelData data = { vms, workers }; \
+        if (virTestRun("parallel stats of " #vms " domains with " \
+                       #workers " workers", \
+                       testDomainStatsParallel, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_TEST_PARALLEL(2, 2);
+    DO_TEST_PARALLEL(50, 4);
+    /* more workers than domains */
+    DO_TEST_PARALLEL(3, 8);
+
+    if (virTestRun("cached stats", testDomainStatsCache, NULL) < 0)
+        ret = -1;
+
+    qemuTestDriverFree(&driver);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
+
+#else
+
+int
+main(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#endif /* WITH_QEMU */
@@ -0,0 +1,186 @@
+#include <config.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "testutils.h"
+
+#ifdef WITH_QEMU
+
+# include "internal.h"
+# include "virfile.h"
+# include "qemu/qemu_saveimage.h"
+
+# include "testutilsqemu.h"
+
+# define VIR_FROM_THIS VIR_FROM_QEMU
+
+static virQEMUDriver driver;
+static char *tmpdir;
+
+struct testInfo {
+    const char *name;
+    unsigned int version;
+    unsigned int channels;
+    unsigned int nchunks;
+    const char *cookie;
+    bool fail;
+};
+
+
+static int
+testSaveImageWrite(virQEMUSaveData *data,
+                   const char *path)
+{
+    VIR_AUTOCLOSE fd = -1;
+
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)) < 0) {
+        VIR_TEST_DEBUG("cannot create '%s': %s", path, g_strerror(errno));
+        return -1;
+    }
+
+    if (virQEMUSaveDataWrite(data, fd, path) < 0)
+        return -1;
+
+    /* the migration stream would follow here */
+
+    if (lseek(fd, 0, SEEK_SET) < 0) {
+        VIR_TEST_DEBUG("cannot seek in '%s': %s", path, g_strerror(errno));
+        return -1;
+    }
+
+    return virQEMUSaveDataFinish(data, &fd, path);
+}
+
+
+static int
+testSaveImageHeader(const void *opaque)
+{
+    const struct testInfo *info = opaque;
+    g_autofree char *xmlpath = NULL;
+    g_autofree char *xml = NULL;
+    g_autofree char *path = NULL;
+    g_autoptr(virDomainDef) def = NULL;
+    virQEMUSaveData *data = NULL;
+    virQEMUSaveData *loaded = NULL;
+    VIR_AUTOCLOSE fd = -1;
+    int ret = -1;
+
+    xmlpath = g_strdup_printf("%s/qemuxml2argvdata/minimal.xml", abs_srcdir);
+    path = g_strdup_printf("%s/%s.save", tmpdir, info->name);
+
+    if (virTestLoadFile(xmlpath, &xml) < 0)
+        return -1;
+
+    /* 0 is the raw (uncompressed) format */
+    if (!(data = virQEMUSaveDataNew(g_strdup(xml), NULL, true, 0,
+                                    driver.xmlopt)))
+        return -1;
+
+    data->header.version = info->version;
+    data->header.channels = info->channels;
+    data->header.nchunks = info->nchunks;
+    data->cookie = g_strdup(info->cookie);
+
+    if (testSaveImageWrite(data, path) < 0)
+        goto cleanup;
+
+    fd = qemuSaveImageOpen(&driver, NULL, path, &def, &loaded,
+                           false, NULL, false, false);
+
+    if (info->fail) {
+        if (fd >= 0) {
+            VIR_TEST_DEBUG("opening '%s' should have failed", path);
+            goto cleanup;
+        }
+
+        virResetLastError();
+        ret = 0;
+        goto cleanup;
+    }
+
+    if (fd < 0)
+        goto cleanup;
+
+    if (memcmp(&data->header, &loaded->header, sizeof(data->header)) != 0) {
+        VIR_TEST_DEBUG("header of '%s' doesn't match the written one", path);
+        goto cleanup;
+    }
+
+    if (STRNEQ(loaded->xml, xml) ||
+        STRNEQ_NULLABLE(loaded->cookie, info->cookie)) {
+        VIR_TEST_DEBUG("data of '%s' don't match the written ones", path);
+        goto cleanup;
+    }
+
+    if (STRNEQ(def->name, "QEMUGuest1")) {
+        VIR_TEST_DEBUG("unexpected domain '%s' in '%s'", def->name, path);
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    virQEMUSaveDataFree(data);
+    virQEMUSaveDataFree(loaded);
+    return ret;
+}
+
+
+# define TMPDIRTEMPLATE abs_builddir "/qemusaveimagedir-XXXXXX"
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+    tmpdir = g_strdup(TMPDIRTEMPLATE);
+
+    if (!g_mkdtemp(tmpdir)) {
+        fprintf(stderr, "Cannot create tmpdir");
+        abort();
+    }
+
+    if (qemuTestDriverInit(&driver) < 0)
+        return EXIT_FAILURE;
+
+# define DO_TEST_FULL(name, version, channels, nchunks, cookie, fail) \
+    do { \
+        static struct testInfo info = { \
+            name, version, channels, nchunks, cookie, fail \
+        }; \
+        if (virTestRun("QEMU save image " name, \
+                       testSaveImageHeader, &info) < 0) \
+            ret = -1; \
+    } while (0)
+
+# define DO_TEST(name, version, channels, nchunks, cookie) \
+    DO_TEST_FULL(name, version, channels, nchunks, cookie, false)
+
+    DO_TEST("v2", QEMU_SAVE_VERSION, 0, 0, NULL);
+    DO_TEST("v2-cookie", QEMU_SAVE_VERSION, 0, 0, "<cookie/>");
+    DO_TEST("v3", QEMU_SAVE_VERSION_PARALLEL, 4, 8192, NULL);
+    DO_TEST("v3-cookie", QEMU_SAVE_VERSION_PARALLEL, 255, 1, "<cookie/>");
+    DO_TEST_FULL("v4", QEMU_SAVE_VERSION_PARALLEL + 1, 4, 1, NULL, true);
+
+    if (getenv("LIBVIRT_SKIP_CLEANUP") == NULL)
+        virFileDeleteTree(tmpdir);
+
+    qemuTestDriverFree(&driver);
+    VIR_FREE(tmpdir);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
+
+#else
+
+int
+main(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#endif /* WITH_QEMU */
@@ -759,6 +759,192 @@ static int testCgroupGetPercpuStats(const void *args G_GNUC_UNUSED)
     return ret;
 }
 
+static int
+testCgroupGetStatValueStr(const void *args G_GNUC_UNUSED)
+{
+    g_autoptr(virCgroup) cgroup = NULL;
+    g_autofree char *path = NULL;
+    g_autofree char *fill = NULL;
+    g_autofree char *big = NULL;
+    g_autofree char *value = NULL;
+    int rv;
+
+    if ((rv = virCgroupNewPartition("/virtualmachines", true,
+                                    (1 << VIR_CGROUP_CONTROLLER_CPU) |
+                                    (1 << VIR_CGROUP_CONTROLLER_CPUACCT),
+                                    &cgroup)) < 0) {
+        fprintf(stderr, "Could not create /virtualmachines cgroup: %d\n", -rv);
+        return -1;
+    }
+
+    if (virCgroupGetStatValueStr(cgroup, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                 "cpuacct.usage", &value) < 0 ||
+        STRNEQ(value, "2787788855799582\n")) {
+        fprintf(stderr, "Wrong first read of cpuacct.usage: '%s'\n", NULLSTR(value));
+        return -1;
+    }
+    VIR_FREE(value);
+
+    if (g_hash_table_size(cgroup->statFiles) != 1) {
+        fprintf(stderr, "cpuacct.usage was not kept open\n");
+        return -1;
+    }
+
+    /* The file is kept open, a changed value must be read nevertheless */
+    if (virCgroupPathOfController(cgroup, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                  "cpuacct.usage", &path) < 0 ||
+        virFileWriteStr(path, "42\n", 0) < 0) {
+        fprintf(stderr, "Could not change cpuacct.usage\n");
+        return -1;
+    }
+
+    if (virCgroupGetStatValueStr(cgroup, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                 "cpuacct.usage", &value) < 0 ||
+        STRNEQ(value, "42\n")) {
+        fprintf(stderr, "Wrong re-read of cpuacct.usage: '%s'\n", NULLSTR(value));
+        return -1;
+    }
+    VIR_FREE(value);
+
+    /* Contents longer than the buffer used for the previous reads */
+    fill = g_strnfill(5000, '1');
+    big = g_strdup_printf("%s\n", fill);
+
+    if (virFileWriteStr(path, big, 0) < 0) {
+        fprintf(stderr, "Could not change cpuacct.usage\n");
+        return -1;
+    }
+
+    if (virCgroupGetStatValueStr(cgroup, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                 "cpuacct.usage", &value) < 0 ||
+        STRNEQ(value, big)) {
+        fprintf(stderr, "Wrong read of grown cpuacct.usage\n");
+        return -1;
+    }
+
+    if (g_hash_table_size(cgroup->statFiles) != 1) {
+        fprintf(stderr, "cpuacct.usage was opened again\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testCgroupStatFilesMax(const void *args G_GNUC_UNUSED)
+{
+    virCgroup *cgroup = NULL;
+    g_autoptr(virCgroup) other = NULL;
+    g_autofree char *value = NULL;
+    int oldMax = virCgroupSetStatFilesMax(1);
+    unsigned int controllers = (1 << VIR_CGROUP_CONTROLLER_CPU) |
+                               (1 << VIR_CGROUP_CONTROLLER_CPUACCT);
+    int ret = -1;
+    int rv;
+
+    if ((rv = virCgroupNewPartition("/virtualmachines", true,
+                                    controllers, &cgroup)) < 0 ||
+        (rv = virCgroupNewPartition("/virtualmachines", true,
+                                    controllers, &other)) < 0) {
+        fprintf(stderr, "Could not create /virtualmachines cgroup: %d\n", -rv);
+        goto cleanup;
+    }
+
+    if (virCgroupGetStatValueStr(cgroup, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                 "cpuacct.usage", &value) < 0)
+        goto cleanup;
+    VIR_FREE(value);
+
+    /* Over the limit the file is still read, just not kept open */
+    if (virCgroupGetStatValueStr(cgroup, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                 "cpuacct.stat", &value) < 0 ||
+        STRNEQ(value, "user 216687025\nsystem 43421396\n")) {
+        fprintf(stderr, "Wrong read of cpuacct.stat over the limit: '%s'\n",
+                NULLSTR(value));
+        goto cleanup;
+    }
+    VIR_FREE(value);
+
+    if (g_hash_table_size(cgroup->statFiles) != 1) {
+        fprintf(stderr, "Expected 1 open file, got %u\n",
+                g_hash_table_size(cgroup->statFiles));
+        goto cleanup;
+    }
+
+    /* The limit is shared by all cgroups */
+    if (virCgroupGetStatValueStr(other, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                 "cpuacct.stat", &value) < 0)
+        goto cleanup;
+    VIR_FREE(value);
+
+    if (g_hash_table_size(other->statFiles) != 0) {
+        fprintf(stderr, "File kept open despite the limit\n");
+        goto cleanup;
+    }
+
+    /* Freeing a cgroup makes room for others */
+    g_clear_pointer(&cgroup, virCgroupFree);
+
+    if (virCgroupGetStatValueStr(other, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                 "cpuacct.stat", &value) < 0)
+        goto cleanup;
+
+    if (g_hash_table_size(other->statFiles) != 1) {
+        fprintf(stderr, "File not kept open after another cgroup was freed\n");
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    virCgroupFree(cgroup);
+    virCgroupSetStatFilesMax(oldMax);
+    return ret;
+}
+
+
+static int
+testCgroupGetCpuacctTimes(const void *args G_GNUC_UNUSED)
+{
+    g_autoptr(virCgroup) cgroup = NULL;
+    g_autofree char *path = NULL;
+    unsigned long long usage = 0;
+    unsigned long long user = 0;
+    unsigned long long sys = 0;
+
+    if (virCgroupNewSelf(&cgroup) < 0) {
+        fprintf(stderr, "Cannot create cgroup for self\n");
+        return -1;
+    }
+
+    if (virCgroupPathOfController(cgroup, VIR_CGROUP_CONTROLLER_CPUACCT,
+                                  "cpu.stat", &path) < 0 ||
+        virFileWriteStr(path,
+                        "usage_usec 300\n"
+                        "user_usec 200\n"
+                        "system_usec 100\n"
+                        "nr_periods 0\n"
+                        "nr_throttled 0\n"
+                        "throttled_usec 0\n", 0) < 0) {
+        fprintf(stderr, "Could not change cpu.stat\n");
+        return -1;
+    }
+
+    if (virCgroupGetCpuacctTimes(cgroup, &usage, &user, &sys) < 0)
+        return -1;
+
+    if (usage != 300000 || user != 200000 || sys != 100000) {
+        fprintf(stderr,
+                "Wrong values from virCgroupGetCpuacctTimes: %llu %llu %llu\n",
+                usage, user, sys);
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static int testCgroupGetMemoryUsage(const void *args G_GNUC_UNUSED)
 {
     g_autoptr(virCgroup) cgroup = NULL;
@@ -1070,6 +1256,12 @@ mymain(void)
 
     if (virTestRun("virCgroupGetPercpuStats works", testCgroupGetPercpuStats, NULL) < 0)
         ret = -1;
+
+    if (virTestRun("virCgroupGetStatValueStr works", testCgroupGetStatValueStr, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Limit of open stat files", testCgroupStatFilesMax, NULL) < 0)
+        ret = -1;
     cleanupFakeFS(fakerootdir);
 
     fakerootdir = initFakeFS(NULL, "all-in-one");
@@ -1093,6 +1285,9 @@ mymain(void)
         ret = -1;
     if (virTestRun("Cgroup available (unified)", testCgroupAvailable, (void*)0x1) < 0)
         ret = -1;
+    if (virTestRun("virCgroupGetCpuacctTimes works (unified)",
+                   testCgroupGetCpuacctTimes, NULL) < 0)
+        ret = -1;
     cleanupFakeFS(fakerootdir);
 
     /* cgroup hybrid */
@@ -1035,6 +1035,188 @@ testFirewallQuery(const void *opaque G_GNUC_UNUSED)
 }
 
 
+static void
+testFirewallBatchHook(const char *const*args,
+                      const char *const*env G_GNUC_UNUSED,
+                      const char *input,
+                      char **output G_GNUC_UNUSED,
+                      char **error G_GNUC_UNUSED,
+                      int *status,
+                      void *opaque)
+{
+    bool *restoreFails = opaque;
+
+    if (!g_str_has_suffix(args[0], "-restore"))
+        return;
+
+    virBufferAdd(fwBuf, input, -1);
+
+    if (*restoreFails)
+        *status = 1;
+}
+
+
+static void
+testFirewallBatchRules(virFirewall *fw)
+{
+    virFirewallStartTransaction(fw, VIR_FIREWALL_TRANSACTION_IGNORE_ERRORS);
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_IPV4,
+                       "-N", "LIBVIRT_INP", NULL);
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_IPV4,
+                       "-A", "INPUT",
+                       "--jump", "LIBVIRT_INP", NULL);
+
+    virFirewallStartTransaction(fw, 0);
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_IPV4,
+                       "-A", "LIBVIRT_INP",
+                       "--source", "192.168.122.1",
+                       "--jump", "ACCEPT", NULL);
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_IPV4,
+                       "-A", "LIBVIRT_INP",
+                       "--source", "!192.168.122.1",
+                       "-m", "comment", "--comment", "reject \"others\"",
+                       "--jump", "REJECT", NULL);
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_IPV4,
+                       "--table", "nat",
+                       "-A", "POSTROUTING",
+                       "--source", "192.168.122.0/24",
+                       "--jump", "MASQUERADE", NULL);
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_IPV4,
+                       "--table", "nat",
+                       "-A", "POSTROUTING",
+                       "--source", "192.168.123.0/24",
+                       "--jump", "MASQUERADE", NULL);
+
+    virFirewallAddRule(fw, VIR_FIREWALL_LAYER_IPV6,
+                       "-A", "INPUT",
+                       "--jump", "ACCEPT", NULL);
+}
+
+
+static int
+testFirewallBatch(const void *opaque)
+{
+    g_auto(virBuffer) cmdbuf = VIR_BUFFER_INITIALIZER;
+    g_auto(virBuffer) inputbuf = VIR_BUFFER_INITIALIZER;
+    g_autoptr(virFirewall) fw = virFirewallNew();
+    int ret = -1;
+    const char *actual = NULL;
+    const char *expected =
+        IPTABLES_PATH " -w -N LIBVIRT_INP\n"
+        IPTABLES_PATH " -w -A INPUT --jump LIBVIRT_INP\n"
+        IPTABLES_RESTORE_PATH " -w --noflush\n"
+        IPTABLES_RESTORE_PATH " -w --noflush\n"
+        IP6TABLES_PATH " -w -A INPUT --jump ACCEPT\n";
+    const char *expectedInput =
+        "*filter\n"
+        "-A LIBVIRT_INP --source 192.168.122.1 --jump ACCEPT\n"
+        "-A LIBVIRT_INP --source !192.168.122.1 -m comment "
+        "--comment \"reject \\\"others\\\"\" --jump REJECT\n"
+        "COMMIT\n"
+        "*nat\n"
+        "-A POSTROUTING --source 192.168.122.0/24 --jump MASQUERADE\n"
+        "-A POSTROUTING --source 192.168.123.0/24 --jump MASQUERADE\n"
+        "COMMIT\n";
+    const struct testFirewallData *data = opaque;
+    g_autoptr(virCommandDryRunToken) dryRunToken = virCommandDryRunTokenNew();
+    bool restoreFails = false;
+
+    fwDisabled = data->fwDisabled;
+    if (virFirewallSetBackend(data->tryBackend) < 0)
+        goto cleanup;
+
+    virFirewallSetBatching(true);
+    fwBuf = &inputbuf;
+    virCommandSetDryRun(dryRunToken, &cmdbuf, false, false,
+                        testFirewallBatchHook, &restoreFails);
+
+    testFirewallBatchRules(fw);
+
+    if (virFirewallApply(fw) < 0)
+        goto cleanup;
+
+    actual = virBufferCurrentContent(&cmdbuf);
+
+    if (STRNEQ_NULLABLE(expected, actual)) {
+        fprintf(stderr, "Unexpected command execution\n");
+        virTestDifference(stderr, expected, actual);
+        goto cleanup;
+    }
+
+    actual = virBufferCurrentContent(&inputbuf);
+
+    if (STRNEQ_NULLABLE(expectedInput, actual)) {
+        fprintf(stderr, "Unexpected batch input\n");
+        virTestDifference(stderr, expectedInput, actual);
+        goto cleanup;
+    }
+
+    ret = 0;
+ cleanup:
+    fwBuf = NULL;
+    return ret;
+}
+
+
+static int
+testFirewallBatchFallback(const void *opaque)
+{
+    g_auto(virBuffer) cmdbuf = VIR_BUFFER_INITIALIZER;
+    g_auto(virBuffer) inputbuf = VIR_BUFFER_INITIALIZER;
+    g_autoptr(virFirewall) fw = virFirewallNew();
+    int ret = -1;
+    const char *actual = NULL;
+    const char *expected =
+        IPTABLES_PATH " -w -N LIBVIRT_INP\n"
+        IPTABLES_PATH " -w -A INPUT --jump LIBVIRT_INP\n"
+        IPTABLES_RESTORE_PATH " -w --noflush\n"
+        IPTABLES_PATH " -w -A LIBVIRT_INP --source 192.168.122.1 --jump ACCEPT\n"
+        IPTABLES_PATH " -w -A LIBVIRT_INP --source '!192.168.122.1' -m comment "
+        "--comment 'reject \"others\"' --jump REJECT\n"
+        IPTABLES_PATH " -w --table nat -A POSTROUTING --source 192.168.122.0/24 --jump MASQUERADE\n"
+        IPTABLES_PATH " -w --table nat -A POSTROUTING --source 192.168.123.0/24 --jump MASQUERADE\n"
+        IP6TABLES_PATH " -w -A INPUT --jump ACCEPT\n";
+    const struct testFirewallData *data = opaque;
+    g_autoptr(virCommandDryRunToken) dryRunToken = virCommandDryRunTokenNew();
+    bool restoreFails = true;
+
+    fwDisabled = data->fwDisabled;
+    if (virFirewallSetBackend(data->tryBackend) < 0)
+        goto cleanup;
+
+    /* The restore tool fails while the rules themselves apply fine, so
+     * the first batch is replayed and batching is given up on */
+    virFirewallSetBatching(true);
+    fwBuf = &inputbuf;
+    virCommandSetDryRun(dryRunToken, &cmdbuf, false, false,
+                        testFirewallBatchHook, &restoreFails);
+
+    testFirewallBatchRules(fw);
+
+    if (virFirewallApply(fw) < 0)
+        goto cleanup;
+
+    actual = virBufferCurrentContent(&cmdbuf);
+
+    if (STRNEQ_NULLABLE(expected, actual)) {
+        fprintf(stderr, "Unexpected command execution\n");
+        virTestDifference(stderr, expected, actual);
+        goto cleanup;
+    }
+
+    ret = 0;
+ cleanup:
+    fwBuf = NULL;
+    return ret;
+}
+
+
 static int
 mymain(void)
 {
@@ -1084,6 +1266,8 @@ mymain(void)
     RUN_TEST("many rollback", testFirewallManyRollback);
     RUN_TEST("chained rollback", testFirewallChainedRollback);
     RUN_TEST("query transaction", testFirewallQuery);
+    RUN_TEST_DIRECT("batch", testFirewallBatch);
+    RUN_TEST_DIRECT("batch fallback", testFirewallBatchFallback);
 
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
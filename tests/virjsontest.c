@@ -102,6 +102,64 @@ testJSONFromString(const void *data)
 }
 
 
+static int
+testJSONStream(const void *data)
+{
+    const struct testInfo *info = data;
+    g_autoptr(virJSONStreamParser) parser = NULL;
+    const char *expectstr = info->expect ? info->expect : info->doc;
+    size_t len = strlen(info->doc);
+    size_t chunk;
+
+    if (!(parser = virJSONStreamParserNew()))
+        return -1;
+
+    /* feed the document in differently sized pieces reusing the parser */
+    for (chunk = 1; chunk <= len; chunk *= 2) {
+        g_autoptr(virJSONValue) json = NULL;
+        g_autofree char *formatted = NULL;
+        size_t off;
+
+        for (off = 0; off < len; off += chunk) {
+            if (virJSONStreamParserFeed(parser, info->doc + off,
+                                        MIN(chunk, len - off)) < 0)
+                break;
+        }
+
+        if (off >= len)
+            json = virJSONStreamParserFinish(parser);
+        else
+            virJSONValueFree(virJSONStreamParserFinish(parser));
+
+        if (!json) {
+            if (info->pass) {
+                VIR_TEST_VERBOSE("Failed to parse %s in %zu byte chunks",
+                                 info->doc, chunk);
+                return -1;
+            }
+            continue;
+        }
+
+        if (!info->pass) {
+            VIR_TEST_VERBOSE("Unexpected success while parsing %s", info->doc);
+            return -1;
+        }
+
+        if (!(formatted = virJSONValueToString(json, false))) {
+            VIR_TEST_VERBOSE("Failed to format json data");
+            return -1;
+        }
+
+        if (STRNEQ(expectstr, formatted)) {
+            virTestDifference(stderr, expectstr, formatted);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
 static int
 testJSONAddRemove(const void *data)
 {
@@ -596,6 +654,20 @@ mymain(void)
     DO_TEST_FULL("stealing of attributes while creating objects",
                  ObjectFormatSteal, NULL, NULL, true);
 
+#define DO_TEST_STREAM(name, doc, expect, pass) \
+    DO_TEST_FULL("stream " name, Stream, doc, expect, pass)
+
+    DO_TEST_STREAM("object",
+                   "{\"return\": [{\"name\": \"quit\"}, {\"id\": 1.5}],"
+                   " \"id\": \"libvirt-2\"}",
+                   "{\"return\":[{\"name\":\"quit\"},{\"id\":1.5}],"
+                   "\"id\":\"libvirt-2\"}", true);
+    DO_TEST_STREAM("escaped string", "[\"{\\\"blurb\\\":\\\"test\\\"}\"]",
+                   NULL, true);
+    DO_TEST_STREAM("trailing whitespace", "[ 1, 2 ]  \r", "[1,2]", true);
+    DO_TEST_STREAM("unterminated", "{\"a\": [1, 2", NULL, false);
+    DO_TEST_STREAM("garbage", "[ 1 ] garbage", NULL, false);
+
 #define DO_TEST_DEFLATTEN(name, pass) \
     DO_TEST_FULL(name, Deflatten, NULL, NULL, pass)
 
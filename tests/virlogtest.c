@@ -23,6 +23,8 @@
 
 #include "virlog.h"
 
+VIR_LOG_INIT("tests.logtest");
+
 struct testLogData {
     const char *str;
     int count;
@@ -107,6 +109,143 @@ testLogParseFilters(const void *opaque)
     return ret;
 }
 
+static void
+testLogAsyncOutput(virLogSource *source,
+                   virLogPriority priority G_GNUC_UNUSED,
+                   const char *filename G_GNUC_UNUSED,
+                   int linenr G_GNUC_UNUSED,
+                   const char *funcname G_GNUC_UNUSED,
+                   const char *timestamp G_GNUC_UNUSED,
+                   struct _virLogMetadata *metadata G_GNUC_UNUSED,
+                   const char *rawstr G_GNUC_UNUSED,
+                   const char *str G_GNUC_UNUSED,
+                   void *data)
+{
+    int *count = data;
+
+    if (source == &virLogSelf)
+        (*count)++;
+}
+
+static int
+testLogAsync(const void *opaque)
+{
+    int ret = -1;
+    int count = 0;
+    int i;
+    virLogOutput **outputs = g_new0(virLogOutput *, 1);
+    const struct testLogData *data = opaque;
+
+    if (!(outputs[0] = virLogOutputNew(testLogAsyncOutput, NULL, &count,
+                                       VIR_LOG_DEBUG, VIR_LOG_TO_STDERR,
+                                       NULL))) {
+        g_free(outputs);
+        return -1;
+    }
+
+    if (virLogDefineOutputs(outputs, 1) < 0) {
+        virLogOutputListFree(outputs, 1);
+        return -1;
+    }
+
+    if (virLogSetDefaultPriority(VIR_LOG_DEBUG) < 0 ||
+        virLogSetAsync(true) < 0)
+        goto cleanup;
+
+    for (i = 0; i < data->count; i++)
+        VIR_DEBUG("message %d", i);
+
+    /* switching back flushes the queued messages */
+    if (virLogSetAsync(false) < 0)
+        goto cleanup;
+
+    if (count != data->count) {
+        VIR_TEST_DEBUG("Expected %d messages but got %d",
+                       data->count, count);
+        goto cleanup;
+    }
+
+    ret = 0;
+ cleanup:
+    virLogReset();
+    return ret;
+}
+
+struct testLogOrderData {
+    virLogPriority priorities[3];
+    size_t n;
+};
+
+static void
+testLogOrderOutput(virLogSource *source,
+                   virLogPriority priority,
+                   const char *filename G_GNUC_UNUSED,
+                   int linenr G_GNUC_UNUSED,
+                   const char *funcname G_GNUC_UNUSED,
+                   const char *timestamp G_GNUC_UNUSED,
+                   struct _virLogMetadata *metadata G_GNUC_UNUSED,
+                   const char *rawstr G_GNUC_UNUSED,
+                   const char *str G_GNUC_UNUSED,
+                   void *data)
+{
+    struct testLogOrderData *order = data;
+
+    if (source == &virLogSelf &&
+        order->n < G_N_ELEMENTS(order->priorities))
+        order->priorities[order->n++] = priority;
+}
+
+static int
+testLogAsyncOrder(const void *opaque G_GNUC_UNUSED)
+{
+    int ret = -1;
+    struct testLogOrderData order = { 0 };
+    virLogPriority expected[] = { VIR_LOG_DEBUG, VIR_LOG_INFO, VIR_LOG_WARN };
+    size_t i;
+    virLogOutput **outputs = g_new0(virLogOutput *, 1);
+
+    if (!(outputs[0] = virLogOutputNew(testLogOrderOutput, NULL, &order,
+                                       VIR_LOG_DEBUG, VIR_LOG_TO_STDERR,
+                                       NULL))) {
+        g_free(outputs);
+        return -1;
+    }
+
+    if (virLogDefineOutputs(outputs, 1) < 0) {
+        virLogOutputListFree(outputs, 1);
+        return -1;
+    }
+
+    if (virLogSetDefaultPriority(VIR_LOG_DEBUG) < 0 ||
+        virLogSetAsync(true) < 0)
+        goto cleanup;
+
+    VIR_DEBUG("queued debug message");
+    VIR_INFO("queued info message");
+    /* written synchronously, after the messages queued before */
+    VIR_WARN("synchronous warning");
+
+    if (order.n != G_N_ELEMENTS(expected)) {
+        VIR_TEST_DEBUG("Expected %zu messages but got %zu",
+                       G_N_ELEMENTS(expected), order.n);
+        goto cleanup;
+    }
+
+    for (i = 0; i < order.n; i++) {
+        if (order.priorities[i] != expected[i]) {
+            VIR_TEST_DEBUG("Expected priority %d at %zu but got %d",
+                           expected[i], i, order.priorities[i]);
+            goto cleanup;
+        }
+    }
+
+    ret = 0;
+ cleanup:
+    ignore_value(virLogSetAsync(false));
+    virLogReset();
+    return ret;
+}
+
 static int
 mymain(void)
 {
@@ -151,6 +290,9 @@ mymain(void)
     TEST_PARSE_FILTERS_FAIL(":foo", 1);
     TEST_PARSE_FILTERS_FAIL("1:+", 1);
 
+    DO_TEST_FULL("testLogAsync", testLogAsync, NULL, 100, true);
+    DO_TEST_FULL("testLogAsyncOrder", testLogAsyncOrder, NULL, 0, true);
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -516,6 +516,65 @@ static int testMessagePayloadStreamEncode(const void *args G_GNUC_UNUSED)
     return ret;
 }
 
+static int testMessageBufferPool(const void *args G_GNUC_UNUSED)
+{
+    virNetMessage *msg = virNetMessageNew(true);
+    virNetMessageBufferStats before;
+    virNetMessageBufferStats after;
+    char *buffer;
+    size_t i;
+    int ret = -1;
+
+    if (virNetMessageEncodeHeader(msg) < 0)
+        goto cleanup;
+
+    /* Clearing the message returns the buffer to the pool ... */
+    buffer = msg->buffer;
+    virNetMessageClear(msg);
+    virNetMessageGetBufferStats(&before);
+
+    /* ... so the next message of the same size class reuses it */
+    msg->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
+    virNetMessageBufferReserve(msg, msg->bufferLength);
+    virNetMessageGetBufferStats(&after);
+
+    if (msg->buffer != buffer) {
+        VIR_DEBUG("Expected pooled buffer %p got %p", buffer, msg->buffer);
+        goto cleanup;
+    }
+
+    if (after.hits != before.hits + 1 ||
+        after.pooled != before.pooled - 1) {
+        VIR_DEBUG("Expected one more hit and one less pooled buffer");
+        goto cleanup;
+    }
+
+    /* Growing the buffer beyond its size class keeps the content */
+    for (i = 0; i < msg->bufferAlloc; i++)
+        msg->buffer[i] = i % 251;
+
+    msg->bufferLength = VIR_NET_MESSAGE_INITIAL * 2;
+    virNetMessageBufferReserve(msg, msg->bufferLength);
+
+    if (msg->bufferAlloc < msg->bufferLength) {
+        VIR_DEBUG("Expected at least %zu bytes got %zu",
+                  msg->bufferLength, msg->bufferAlloc);
+        goto cleanup;
+    }
+
+    for (i = 0; i < VIR_NET_MESSAGE_INITIAL + VIR_NET_MESSAGE_LEN_MAX; i++) {
+        if (msg->buffer[i] != (char) (i % 251)) {
+            VIR_DEBUG("Buffer content differs at offset %zu", i);
+            goto cleanup;
+        }
+    }
+
+    ret = 0;
+ cleanup:
+    virNetMessageFree(msg);
+    return ret;
+}
+
 
 static int
 mymain(void)
@@ -541,6 +600,9 @@ mymain(void)
     if (virTestRun("Message Payload Stream Encode", testMessagePayloadStreamEncode, NULL) < 0)
         ret = -1;
 
+    if (virTestRun("Message Buffer Pool", testMessageBufferPool, NULL) < 0)
+        ret = -1;
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
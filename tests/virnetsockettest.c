@@ -392,6 +392,90 @@ static int testSocketUNIXAddrs(const void *data G_GNUC_UNUSED)
     return ret;
 }
 
+static int testSocketWriteVec(const void *data G_GNUC_UNUSED)
+{
+    virNetSocket *sock = NULL;
+    int sv[2] = { -1, -1 };
+    int ret = -1;
+    const char *expect = "Hello, vectored world";
+    GOutputVector vec[] = {
+        { "Hello", 5 },
+        { ", ", 2 },
+        { "vectored", 8 },
+        { " world", 6 },
+    };
+    ssize_t len = strlen(expect);
+    g_autofree char *big = NULL;
+    g_autofree char *got = NULL;
+    ssize_t biglen = 1024 * 1024;
+    ssize_t nwritten;
+    ssize_t i;
+
+    if (socketpair(PF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        virReportSystemError(errno, "%s",
+                             "Cannot create socket pair");
+        return -1;
+    }
+
+    if (virNetSocketNewConnectSockFD(sv[0], &sock) < 0)
+        goto cleanup;
+    sv[0] = -1;
+
+    if (virNetSocketSetBlocking(sock, false) < 0)
+        goto cleanup;
+
+    /* Small buffers are written at once, as if they were concatenated */
+    if ((nwritten = virNetSocketWriteVec(sock, vec, G_N_ELEMENTS(vec))) != len) {
+        VIR_DEBUG("Expected %zd bytes written, got %zd", len, nwritten);
+        goto cleanup;
+    }
+
+    got = g_new0(char, biglen + 1);
+    if (saferead(sv[1], got, len) != len || STRNEQ(got, expect)) {
+        VIR_DEBUG("Unexpected data '%s', expected '%s'", got, expect);
+        goto cleanup;
+    }
+
+    /* Buffers which don't fit into the socket are written partially,
+     * but still in order. A full socket must not block the write. */
+    big = g_new0(char, biglen);
+    for (i = 0; i < biglen; i++)
+        big[i] = 'a' + i % 26;
+
+    vec[0].buffer = "x";
+    vec[0].size = 1;
+    vec[1].buffer = big;
+    vec[1].size = biglen;
+    vec[2].buffer = big;
+    vec[2].size = biglen;
+
+    if ((nwritten = virNetSocketWriteVec(sock, vec, 3)) <= 1 ||
+        nwritten >= biglen) {
+        VIR_DEBUG("Unexpected partial write of %zd bytes", nwritten);
+        goto cleanup;
+    }
+
+    if ((i = virNetSocketWriteVec(sock, vec + 1, 2)) != 0) {
+        VIR_DEBUG("Expected write to a full socket to block, got %zd", i);
+        goto cleanup;
+    }
+
+    if (saferead(sv[1], got, nwritten) != nwritten ||
+        got[0] != 'x' ||
+        memcmp(got + 1, big, nwritten - 1) != 0) {
+        VIR_DEBUG("Partially written data doesn't match");
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    virObjectUnref(sock);
+    VIR_FORCE_CLOSE(sv[0]);
+    VIR_FORCE_CLOSE(sv[1]);
+    return ret;
+}
+
 static int testSocketCommandNormal(const void *data G_GNUC_UNUSED)
 {
     virNetSocket *csock = NULL; /* Client socket */
@@ -568,6 +652,9 @@ mymain(void)
     if (virTestRun("Socket UNIX Addrs", testSocketUNIXAddrs, NULL) < 0)
         ret = -1;
 
+    if (virTestRun("Socket Write Vector", testSocketWriteVec, NULL) < 0)
+        ret = -1;
+
     if (virTestRun("Socket External Command /dev/zero", testSocketCommandNormal, NULL) < 0)
         ret = -1;
     if (virTestRun("Socket External Command /dev/does-not-exist", testSocketCommandFail, NULL) < 0)
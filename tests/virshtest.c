@@ -250,6 +250,30 @@ static int testCompareDomstateByName(const void *data G_GNUC_UNUSED)
     return testCompareOutputLit(exp, NULL, argv);
 }
 
+static int testCompareVolListCustom(const void *data G_GNUC_UNUSED)
+{
+    const char *const argv[] = { VIRSH_CUSTOM, "vol-list", "default-pool",
+                                 NULL };
+    const char *exp = "\
+ Name          Path\n\
+------------------------------------------\n\
+ default-vol   /default-pool/default-vol\n\
+\n";
+    return testCompareOutputLit(exp, NULL, argv);
+}
+
+static int testCompareVolListDetailsCustom(const void *data G_GNUC_UNUSED)
+{
+    const char *const argv[] = { VIRSH_CUSTOM, "vol-list", "default-pool",
+                                 "--details", NULL };
+    const char *exp = "\
+ Name          Path                        Type   Capacity     Allocation\n\
+---------------------------------------------------------------------------\n\
+ default-vol   /default-pool/default-vol   file   976.56 KiB   48.83 KiB\n\
+\n";
+    return testCompareOutputLit(exp, NULL, argv);
+}
+
 struct testInfo {
     const char *const *argv;
     const char *result;
@@ -334,6 +358,14 @@ mymain(void)
                    testCompareDomstateByName, NULL) != 0)
         ret = -1;
 
+    if (virTestRun("virsh vol-list (custom)",
+                   testCompareVolListCustom, NULL) != 0)
+        ret = -1;
+
+    if (virTestRun("virsh vol-list --details (custom)",
+                   testCompareVolListDetailsCustom, NULL) != 0)
+        ret = -1;
+
     /* It's a bit awkward listing result before argument, but that's a
      * limitation of C99 vararg macros.  */
 # define DO_TEST(i, result, ...) \
@@ -0,0 +1,202 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <sys/stat.h>
+
+#include "testutils.h"
+
+#define LIBVIRT_STORAGE_SOURCE_PRIV_H_ALLOW
+#include "storage_source_priv.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+static const char header[] = "QFI\xfb header of some image";
+
+/* Old enough to be cached */
+#define OLD_TIME 1000000000
+
+static void
+testHeaderCacheStat(struct stat *st,
+                    ino_t ino)
+{
+    memset(st, 0, sizeof(*st));
+    st->st_dev = 1;
+    st->st_ino = ino;
+    st->st_mode = S_IFREG | 0600;
+    st->st_size = 1024 * 1024;
+    st->st_mtime = OLD_TIME;
+    st->st_ctime = OLD_TIME;
+}
+
+
+static int
+testHeaderCacheExpect(const struct stat *st,
+                      uid_t uid,
+                      gid_t gid,
+                      bool hit)
+{
+    g_autofree char *buf = NULL;
+    size_t len = 0;
+
+    if (virStorageSourceHeaderCacheLookup(st, uid, gid, &buf, &len) != hit) {
+        VIR_TEST_DEBUG("expected cache %s for inode %llu uid %u gid %u",
+                       hit ? "hit" : "miss", (unsigned long long)st->st_ino,
+                       (unsigned int)uid, (unsigned int)gid);
+        return -1;
+    }
+
+    if (hit && (len != sizeof(header) || memcmp(buf, header, len) != 0)) {
+        VIR_TEST_DEBUG("cached header of inode %llu differs",
+                       (unsigned long long)st->st_ino);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testHeaderCacheHit(const void *opaque G_GNUC_UNUSED)
+{
+    struct stat st;
+
+    testHeaderCacheStat(&st, 10);
+
+    if (testHeaderCacheExpect(&st, 107, 107, false) < 0)
+        return -1;
+
+    virStorageSourceHeaderCacheStore(&st, 107, 107, header, sizeof(header));
+
+    return testHeaderCacheExpect(&st, 107, 107, true);
+}
+
+
+static int
+testHeaderCacheIds(const void *opaque G_GNUC_UNUSED)
+{
+    struct stat st;
+
+    testHeaderCacheStat(&st, 20);
+    virStorageSourceHeaderCacheStore(&st, 107, 107, header, sizeof(header));
+
+    /* an image readable by one user must not leak to another one */
+    if (testHeaderCacheExpect(&st, 0, 0, false) < 0 ||
+        testHeaderCacheExpect(&st, 107, 0, false) < 0 ||
+        testHeaderCacheExpect(&st, 0, 107, false) < 0)
+        return -1;
+
+    return testHeaderCacheExpect(&st, 107, 107, true);
+}
+
+
+static int
+testHeaderCacheChanged(const void *opaque G_GNUC_UNUSED)
+{
+    struct stat st;
+    struct stat changed;
+
+    testHeaderCacheStat(&st, 30);
+    virStorageSourceHeaderCacheStore(&st, 0, 0, header, sizeof(header));
+
+    changed = st;
+    changed.st_size += 512;
+    if (testHeaderCacheExpect(&changed, 0, 0, false) < 0)
+        return -1;
+
+    changed = st;
+    changed.st_mtime++;
+    if (testHeaderCacheExpect(&changed, 0, 0, false) < 0)
+        return -1;
+
+    changed = st;
+    changed.st_ctime++;
+    if (testHeaderCacheExpect(&changed, 0, 0, false) < 0)
+        return -1;
+
+    changed = st;
+    changed.st_dev++;
+    if (testHeaderCacheExpect(&changed, 0, 0, false) < 0)
+        return -1;
+
+    return testHeaderCacheExpect(&st, 0, 0, true);
+}
+
+
+static int
+testHeaderCacheRecent(const void *opaque G_GNUC_UNUSED)
+{
+    struct stat st;
+    time_t now = g_get_real_time() / G_USEC_PER_SEC;
+
+    /* files which were just modified may change again without their
+     * timestamps changing, so they must not be cached */
+    testHeaderCacheStat(&st, 40);
+    st.st_mtime = now;
+    virStorageSourceHeaderCacheStore(&st, 0, 0, header, sizeof(header));
+    if (testHeaderCacheExpect(&st, 0, 0, false) < 0)
+        return -1;
+
+    testHeaderCacheStat(&st, 41);
+    st.st_ctime = now;
+    virStorageSourceHeaderCacheStore(&st, 0, 0, header, sizeof(header));
+    return testHeaderCacheExpect(&st, 0, 0, false);
+}
+
+
+static int
+testHeaderCacheFull(const void *opaque G_GNUC_UNUSED)
+{
+    struct stat st;
+    size_t i;
+
+    /* more entries than the cache can hold */
+    for (i = 0; i < 1024; i++) {
+        testHeaderCacheStat(&st, 1000 + i);
+        virStorageSourceHeaderCacheStore(&st, 0, 0, header, sizeof(header));
+    }
+
+    /* the most recently stored entry survives emptying the cache */
+    if (testHeaderCacheExpect(&st, 0, 0, true) < 0)
+        return -1;
+
+    testHeaderCacheStat(&st, 1000);
+    return testHeaderCacheExpect(&st, 0, 0, false);
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+    if (virTestRun("header cache hit", testHeaderCacheHit, NULL) < 0)
+        ret = -1;
+    if (virTestRun("header cache IDs", testHeaderCacheIds, NULL) < 0)
+        ret = -1;
+    if (virTestRun("header cache changed file",
+                   testHeaderCacheChanged, NULL) < 0)
+        ret = -1;
+    if (virTestRun("header cache recent file", testHeaderCacheRecent, NULL) < 0)
+        ret = -1;
+    if (virTestRun("header cache full", testHeaderCacheFull, NULL) < 0)
+        ret = -1;
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
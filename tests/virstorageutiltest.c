@@ -70,9 +70,164 @@ testGlusterExtractPoolSources(const void *opaque)
 }
 
 
+static virStorageVolDef *
+testRefreshLocalFindVol(virStoragePoolObj *obj,
+                        const char *name)
+{
+    virStorageVolDef *vol;
+
+    if (!(vol = virStorageVolDefFindByName(obj, name)))
+        fprintf(stderr, "volume '%s' not found\n", name);
+
+    return vol;
+}
+
+
+static int
+testRefreshLocal(const void *opaque)
+{
+    const char *scratchdir = opaque;
+    g_autoptr(virStoragePoolDef) def = g_new0(virStoragePoolDef, 1);
+    virStoragePoolObj *obj = NULL;
+    g_autofree char *unchanged = g_strdup_printf("%s/unchanged.img", scratchdir);
+    g_autofree char *changed = g_strdup_printf("%s/changed.img", scratchdir);
+    g_autofree char *removed = g_strdup_printf("%s/removed.img", scratchdir);
+    virStorageVolDef *unchangedVol;
+    virStorageVolDef *vol;
+    int ret = -1;
+
+    if (virFileWriteStr(unchanged, "unchanged", 0600) < 0 ||
+        virFileWriteStr(changed, "changed", 0600) < 0 ||
+        virFileWriteStr(removed, "removed", 0600) < 0) {
+        fprintf(stderr, "cannot create volumes in %s\n", scratchdir);
+        return -1;
+    }
+
+    def->name = g_strdup("refresh");
+    def->type = VIR_STORAGE_POOL_DIR;
+    def->target.path = g_strdup(scratchdir);
+
+    if (!(obj = virStoragePoolObjNew()))
+        return -1;
+    virStoragePoolObjSetDef(obj, g_steal_pointer(&def));
+
+    if (virStorageBackendRefreshLocal(obj) < 0)
+        goto cleanup;
+
+    if (virStoragePoolObjGetVolumesCount(obj) != 3) {
+        fprintf(stderr, "expected 3 volumes after the first refresh, got %zu\n",
+                virStoragePoolObjGetVolumesCount(obj));
+        goto cleanup;
+    }
+
+    if (!(unchangedVol = testRefreshLocalFindVol(obj, "unchanged.img")))
+        goto cleanup;
+
+    if (virFileWriteStr(changed, "changed and grown", 0) < 0 ||
+        unlink(removed) < 0) {
+        fprintf(stderr, "cannot modify volumes in %s\n", scratchdir);
+        goto cleanup;
+    }
+
+    /* Refresh the way storagePoolRefreshImpl does */
+    if (virStoragePoolObjStashVols(obj) < 0)
+        goto cleanup;
+
+    if (virStorageBackendRefreshLocal(obj) < 0) {
+        virStoragePoolObjDropStashedVols(obj);
+        goto cleanup;
+    }
+    virStoragePoolObjDropStashedVols(obj);
+
+    if (virStoragePoolObjGetVolumesCount(obj) != 2) {
+        fprintf(stderr, "expected 2 volumes after the second refresh, got %zu\n",
+                virStoragePoolObjGetVolumesCount(obj));
+        goto cleanup;
+    }
+
+    if (!(vol = testRefreshLocalFindVol(obj, "unchanged.img")))
+        goto cleanup;
+
+    if (vol != unchangedVol) {
+        fprintf(stderr, "unchanged volume was probed again\n");
+        goto cleanup;
+    }
+
+    if (!(vol = testRefreshLocalFindVol(obj, "changed.img")))
+        goto cleanup;
+
+    if (vol->target.capacity != strlen("changed and grown")) {
+        fprintf(stderr, "changed volume has stale capacity %llu\n",
+                vol->target.capacity);
+        goto cleanup;
+    }
+
+    if (virStorageVolDefFindByName(obj, "removed.img")) {
+        fprintf(stderr, "removed volume is still listed\n");
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    virStoragePoolObjEndAPI(&obj);
+    return ret;
+}
+
+
+static int
+testWipeLocalZero(const void *opaque)
+{
+    const char *scratchdir = opaque;
+    g_autoptr(virStorageVolDef) vol = g_new0(virStorageVolDef, 1);
+    g_autofree char *data = NULL;
+    g_autofree char *buf = NULL;
+    int len = 1024 * 1024 + 1000;
+    int wiped = 512 * 1024 + 123;
+    int i;
+
+    vol->name = g_strdup("wipe.img");
+    vol->target.path = g_strdup_printf("%s/wipe.img", scratchdir);
+    vol->target.format = VIR_STORAGE_FILE_RAW;
+    vol->target.capacity = len;
+    vol->target.allocation = wiped;
+
+    /* A fully allocated file, so that the range isn't handled as sparse */
+    data = g_strnfill(len, 'x');
+    if (virFileWriteStr(vol->target.path, data, 0600) < 0) {
+        fprintf(stderr, "cannot create volume in %s\n", scratchdir);
+        return -1;
+    }
+
+    if (virStorageBackendVolWipeLocal(NULL, vol,
+                                      VIR_STORAGE_VOL_WIPE_ALG_ZERO, 0) < 0)
+        return -1;
+
+    if (virFileReadAll(vol->target.path, len + 1, &buf) != len) {
+        fprintf(stderr, "wiping changed the size of the volume\n");
+        return -1;
+    }
+
+    /* Only the requested range, which isn't block aligned, is zeroed
+     * whether the kernel or the write loop did it */
+    for (i = 0; i < len; i++) {
+        if (buf[i] != (i < wiped ? '\0' : 'x')) {
+            fprintf(stderr, "unexpected byte 0x%02x at offset %d\n",
+                    (unsigned char) buf[i], i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+#define SCRATCHDIRTEMPLATE abs_builddir "/storageutildir-XXXXXX"
+
 static int
 mymain(void)
 {
+    char scratchdir[] = SCRATCHDIRTEMPLATE;
     int ret = 0;
 
 #define DO_TEST_GLUSTER_EXTRACT_POOL_SOURCES_FULL(testname, sffx, pooltype) \
@@ -104,6 +259,20 @@ mymain(void)
 #undef DO_TEST_GLUSTER_EXTRACT_POOL_SOURCES_NETFS
 #undef DO_TEST_GLUSTER_EXTRACT_POOL_SOURCES_FULL
 
+    if (!g_mkdtemp(scratchdir)) {
+        fprintf(stderr, "Cannot create storageutildir");
+        abort();
+    }
+
+    if (virTestRun("refresh local pool", testRefreshLocal, scratchdir) < 0)
+        ret = -1;
+
+    if (virTestRun("wipe local volume", testWipeLocalZero, scratchdir) < 0)
+        ret = -1;
+
+    if (getenv("LIBVIRT_SKIP_CLEANUP") == NULL)
+        virFileDeleteTree(scratchdir);
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -473,6 +473,49 @@ static int testFilterChars(const void *args)
     return ret;
 }
 
+/* Check every alignment and length up to a few blocks of words, with
+ * and without a single non-zero byte at each possible position. */
+static int
+testBufferIsZero(const void *args G_GNUC_UNUSED)
+{
+    g_autofree unsigned char *buf = g_new0(unsigned char, 256);
+    size_t start;
+    size_t len;
+    size_t i;
+
+    for (start = 0; start < 16; start++) {
+        for (len = 0; len <= 200; len++) {
+            if (!virStringBufferIsZero(buf + start, len)) {
+                fprintf(stderr, "Zero buffer at %zu len %zu not detected\n",
+                        start, len);
+                return -1;
+            }
+
+            for (i = 0; i < len; i++) {
+                buf[start + i] = 0x80;
+
+                if (virStringBufferIsZero(buf + start, len)) {
+                    fprintf(stderr,
+                            "Non-zero byte %zu at %zu len %zu not detected\n",
+                            i, start, len);
+                    return -1;
+                }
+
+                buf[start + i] = 0;
+            }
+        }
+    }
+
+    /* bytes right outside the range must not matter */
+    buf[15] = buf[16 + 100] = 0xff;
+    if (!virStringBufferIsZero(buf + 16, 100)) {
+        fprintf(stderr, "Bytes outside of the buffer were checked\n");
+        return -1;
+    }
+
+    return 0;
+}
+
 static int
 mymain(void)
 {
@@ -751,6 +794,9 @@ mymain(void)
     TEST_FILTER_CHARS(NULL, NULL, NULL);
     TEST_FILTER_CHARS("hello 123 hello", "helo", "hellohello");
 
+    if (virTestRun("virStringBufferIsZero", testBufferIsZero, NULL) < 0)
+        ret = -1;
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -0,0 +1,196 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+#include "virerror.h"
+#include "virlog.h"
+#include "virthread.h"
+#include "virthreadpool.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+VIR_LOG_INIT("tests.threadpooltest");
+
+#define TEST_FLOOD_JOBS 10
+
+typedef struct _testThreadPoolJob testThreadPoolJob;
+struct _testThreadPoolJob {
+    int owner;
+    size_t seq;
+    bool block;
+};
+
+typedef struct _testThreadPoolData testThreadPoolData;
+struct _testThreadPoolData {
+    virMutex lock;
+    virCond cond;
+    bool started;
+    bool released;
+
+    /* jobs in the order they were processed */
+    testThreadPoolJob *done[TEST_FLOOD_JOBS + 2];
+    size_t ndone;
+};
+
+
+static void
+testThreadPoolWorker(void *jobdata,
+                     void *opaque)
+{
+    testThreadPoolJob *job = jobdata;
+    testThreadPoolData *data = opaque;
+
+    virMutexLock(&data->lock);
+
+    if (job->block) {
+        data->started = true;
+        virCondBroadcast(&data->cond);
+        while (!data->released)
+            ignore_value(virCondWait(&data->cond, &data->lock));
+    }
+
+    data->done[data->ndone++] = job;
+    virCondBroadcast(&data->cond);
+
+    virMutexUnlock(&data->lock);
+}
+
+
+/*
+ * With a single worker kept busy by owner 1, owner 1 queues a flood of
+ * jobs followed by a single job of owner 2. The job of owner 2 must not
+ * wait for the whole flood, while the jobs of owner 1 still run in the
+ * order they were queued.
+ */
+static int
+testThreadPoolFairness(const void *opaque G_GNUC_UNUSED)
+{
+    testThreadPoolData data = { 0 };
+    testThreadPoolJob jobs[TEST_FLOOD_JOBS + 2];
+    virThreadPool *pool = NULL;
+    int flooder = 1;
+    int other = 2;
+    size_t depth;
+    size_t lastSeq = 0;
+    size_t i;
+    int ret = -1;
+
+    if (virMutexInit(&data.lock) < 0)
+        return -1;
+    if (virCondInit(&data.cond) < 0) {
+        virMutexDestroy(&data.lock);
+        return -1;
+    }
+
+    memset(jobs, 0, sizeof(jobs));
+    for (i = 0; i < G_N_ELEMENTS(jobs); i++) {
+        jobs[i].owner = flooder;
+        jobs[i].seq = i;
+    }
+    jobs[0].block = true;
+    jobs[G_N_ELEMENTS(jobs) - 1].owner = other;
+
+    if (!(pool = virThreadPoolNewFull(1, 1, 0, testThreadPoolWorker,
+                                      "test-pool", &data)))
+        goto cleanup;
+
+    if (virThreadPoolSendJobFull(pool, 0, &flooder, &jobs[0]) < 0)
+        goto cleanup;
+
+    virMutexLock(&data.lock);
+    while (!data.started)
+        ignore_value(virCondWait(&data.cond, &data.lock));
+    virMutexUnlock(&data.lock);
+
+    for (i = 1; i < G_N_ELEMENTS(jobs); i++) {
+        if (virThreadPoolSendJobFull(pool, 0,
+                                     jobs[i].owner == flooder ? &flooder : &other,
+                                     &jobs[i]) < 0)
+            goto cleanup;
+    }
+
+    depth = virThreadPoolGetOwnerJobQueueDepth(pool, &flooder);
+
+    virMutexLock(&data.lock);
+    data.released = true;
+    virCondBroadcast(&data.cond);
+    while (data.ndone < G_N_ELEMENTS(jobs))
+        ignore_value(virCondWait(&data.cond, &data.lock));
+    virMutexUnlock(&data.lock);
+
+    if (depth != TEST_FLOOD_JOBS) {
+        VIR_TEST_DEBUG("Expected %d queued jobs of the flooding owner, got %zu",
+                       TEST_FLOOD_JOBS, depth);
+        goto cleanup;
+    }
+
+    /* the blocking job, one job of the flood and then the other owner */
+    for (i = 0; i < data.ndone; i++) {
+        if (data.done[i]->owner == other)
+            break;
+    }
+    if (i > 2) {
+        VIR_TEST_DEBUG("Job of the other owner ran at position %zu", i);
+        goto cleanup;
+    }
+
+    for (i = 0; i < data.ndone; i++) {
+        if (data.done[i]->owner != flooder)
+            continue;
+        if (data.done[i]->seq < lastSeq) {
+            VIR_TEST_DEBUG("Job %zu of the flooding owner ran after job %zu",
+                           data.done[i]->seq, lastSeq);
+            goto cleanup;
+        }
+        lastSeq = data.done[i]->seq;
+    }
+
+    if (virThreadPoolGetOwnerJobQueueDepth(pool, &flooder) != 0) {
+        VIR_TEST_DEBUG("Jobs of the flooding owner left in the queue");
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    if (pool && !data.released) {
+        virMutexLock(&data.lock);
+        data.released = true;
+        virCondBroadcast(&data.cond);
+        virMutexUnlock(&data.lock);
+    }
+    virThreadPoolFree(pool);
+    virCondDestroy(&data.cond);
+    virMutexDestroy(&data.lock);
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+    if (virTestRun("Fairness among job owners",
+                   testThreadPoolFairness, NULL) < 0)
+        ret = -1;
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
@@ -2199,6 +2199,10 @@ static const vshCmdOptDef opts_domstats[] = {
      .type = VSH_OT_BOOL,
      .help = N_("report only stats that are accessible instantly"),
     },
+    {.name = "cached",
+     .type = VSH_OT_BOOL,
+     .help = N_("allow reporting recently gathered stats"),
+    },
     VIRSH_COMMON_OPT_DOMAIN_OT_ARGV(N_("list of domains to get stats for"), 0),
     {.name = NULL}
 };
@@ -2306,6 +2310,9 @@ cmdDomstats(vshControl *ctl, const vshCmd *cmd)
     if (vshCommandOptBool(cmd, "nowait"))
         flags |= VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT;
 
+    if (vshCommandOptBool(cmd, "cached"))
+        flags |= VIR_CONNECT_GET_ALL_DOMAINS_STATS_CACHED;
+
     if (vshCommandOptBool(cmd, "domain")) {
         domlist = g_new0(virDomainPtr, 1);
         ndoms = 1;
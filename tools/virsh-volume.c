@@ -1378,6 +1378,134 @@ virshStorageVolListCollect(vshControl *ctl,
     return list;
 }
 
+struct virshStorageVolInfoEntry {
+    const char *name;
+    const char *path;
+    int type;
+    unsigned long long capacity;
+    unsigned long long allocation;
+};
+
+static int
+virshStorageVolInfoEntrySorter(const void *a, const void *b)
+{
+    const struct virshStorageVolInfoEntry *va = a;
+    const struct virshStorageVolInfoEntry *vb = b;
+
+    return vshStrcasecmp(va->name, vb->name);
+}
+
+/*
+ * Print the list of volumes of @pool gathered by a single
+ * virStoragePoolListAllVolumesInfo() call.
+ *
+ * Returns 1 on success, 0 if the API is not supported by the daemon
+ * and the caller should query the volumes one by one, -1 on error.
+ */
+static int
+virshStorageVolListBulk(vshControl *ctl,
+                        virStoragePoolPtr pool,
+                        bool details)
+{
+    virTypedParameterPtr params = NULL;
+    int nparams = 0;
+    unsigned int nvols = 0;
+    struct virshStorageVolInfoEntry *vols = NULL;
+    vshTable *table = NULL;
+    size_t i;
+    int ret = -1;
+
+    if (virStoragePoolListAllVolumesInfo(pool, &params, &nparams, 0) < 0) {
+        if (last_error && last_error->code == VIR_ERR_NO_SUPPORT) {
+            vshResetLibvirtError();
+            return 0;
+        }
+
+        vshError(ctl, "%s", _("Failed to list volumes"));
+        return -1;
+    }
+
+    if (virTypedParamsGetUInt(params, nparams, "vol.count", &nvols) <= 0) {
+        vshError(ctl, "%s", _("Failed to list volumes"));
+        goto cleanup;
+    }
+
+    if (nvols > 0)
+        vols = g_new0(struct virshStorageVolInfoEntry, nvols);
+
+    for (i = 0; i < nvols; i++) {
+        char key[VIR_TYPED_PARAM_FIELD_LENGTH];
+
+        g_snprintf(key, sizeof(key), "vol.%zu.name", i);
+        if (virTypedParamsGetString(params, nparams, key, &vols[i].name) <= 0) {
+            vshError(ctl, "%s", _("Failed to list volumes"));
+            goto cleanup;
+        }
+
+        g_snprintf(key, sizeof(key), "vol.%zu.path", i);
+        if (virTypedParamsGetString(params, nparams, key, &vols[i].path) <= 0)
+            vols[i].path = _("unknown");
+
+        vols[i].type = -1;
+        g_snprintf(key, sizeof(key), "vol.%zu.type", i);
+        ignore_value(virTypedParamsGetInt(params, nparams, key, &vols[i].type));
+        g_snprintf(key, sizeof(key), "vol.%zu.capacity", i);
+        ignore_value(virTypedParamsGetULLong(params, nparams, key,
+                                             &vols[i].capacity));
+        g_snprintf(key, sizeof(key), "vol.%zu.allocation", i);
+        ignore_value(virTypedParamsGetULLong(params, nparams, key,
+                                             &vols[i].allocation));
+    }
+
+    if (nvols > 0)
+        qsort(vols, nvols, sizeof(*vols), virshStorageVolInfoEntrySorter);
+
+    if (details)
+        table = vshTableNew(_("Name"), _("Path"), _("Type"), _("Capacity"), _("Allocation"), NULL);
+    else
+        table = vshTableNew(_("Name"), _("Path"), NULL);
+    if (!table)
+        goto cleanup;
+
+    for (i = 0; i < nvols; i++) {
+        g_autofree char *capacity = NULL;
+        g_autofree char *allocation = NULL;
+        const char *unit;
+        double val;
+
+        if (!details) {
+            if (vshTableRowAppend(table, vols[i].name, vols[i].path, NULL) < 0)
+                goto cleanup;
+            continue;
+        }
+
+        val = vshPrettyCapacity(vols[i].capacity, &unit);
+        capacity = g_strdup_printf("%.2lf %s", val, unit);
+
+        val = vshPrettyCapacity(vols[i].allocation, &unit);
+        allocation = g_strdup_printf("%.2lf %s", val, unit);
+
+        if (vshTableRowAppend(table,
+                              vols[i].name,
+                              vols[i].path,
+                              virshVolumeTypeToString(vols[i].type),
+                              capacity,
+                              allocation,
+                              NULL) < 0)
+            goto cleanup;
+    }
+
+    vshTablePrintToStdout(table, ctl);
+
+    ret = 1;
+
+ cleanup:
+    vshTableFree(table);
+    g_free(vols);
+    virTypedParamsFree(params, nparams);
+    return ret;
+}
+
 /*
  * "vol-list" command
  */
@@ -1409,6 +1537,7 @@ cmdVolList(vshControl *ctl, const vshCmd *cmd G_GNUC_UNUSED)
     double val;
     bool details = vshCommandOptBool(cmd, "details");
     size_t i;
+    int rc;
     bool ret = false;
     struct volInfoText {
         char *allocation;
@@ -1424,6 +1553,13 @@ cmdVolList(vshControl *ctl, const vshCmd *cmd G_GNUC_UNUSED)
     if (!(pool = virshCommandOptPool(ctl, cmd, "pool", NULL)))
         return false;
 
+    /* Try to get everything in one go first, older daemons need one
+     * call per volume below */
+    if ((rc = virshStorageVolListBulk(ctl, pool, details)) != 0) {
+        ret = rc > 0;
+        goto cleanup;
+    }
+
     if (!(list = virshStorageVolListCollect(ctl, pool, 0)))
         goto cleanup;
 
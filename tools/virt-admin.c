@@ -1109,6 +1109,43 @@ cmdDaemonLogOutputs(vshControl *ctl, const vshCmd *cmd)
     return true;
 }
 
+/* -----------------------------------
+ * Command daemon-message-buffer-stats
+ * -----------------------------------
+ */
+static const vshCmdInfo info_daemon_message_buffer_stats[] = {
+    {.name = "help",
+     .data = N_("get statistics of the daemon's RPC message buffer pool")
+    },
+    {.name = "desc",
+     .data = N_("Retrieve statistics of the pool of buffers the daemon uses "
+                "for RPC messages.")
+    },
+    {.name = NULL}
+};
+
+static bool
+cmdDaemonMessageBufferStats(vshControl *ctl,
+                            const vshCmd *cmd G_GNUC_UNUSED)
+{
+    virTypedParameterPtr params = NULL;
+    int nparams = 0;
+    size_t i;
+    vshAdmControl *priv = ctl->privData;
+
+    if (virAdmConnectGetMessageBufferStats(priv->conn, &params,
+                                           &nparams, 0) < 0) {
+        vshError(ctl, "%s", _("Unable to get message buffer statistics"));
+        return false;
+    }
+
+    for (i = 0; i < nparams; i++)
+        vshPrint(ctl, "%-15s: %llu\n", params[i].field, params[i].value.ul);
+
+    virTypedParamsFree(params, nparams);
+    return true;
+}
+
 static void *
 vshAdmConnectionHandler(vshControl *ctl)
 {
@@ -1448,6 +1485,12 @@ static const vshCmdDef monitoringCmds[] = {
      .info = info_srv_clients_info,
      .flags = 0
     },
+    {.name = "daemon-message-buffer-stats",
+     .handler = cmdDaemonMessageBufferStats,
+     .opts = NULL,
+     .info = info_daemon_message_buffer_stats,
+     .flags = 0
+    },
     {.name = NULL}
 };
 